@@ -0,0 +1,144 @@
+#include "BaseConverter.hpp"
+#include "LimbArith.hpp"
+#include "Multiplier.hpp"
+#include "Divider.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+typedef std::vector<uint32_t> Limbs;
+
+// remove the leading zero limbs
+static void trim(Limbs &a) {
+    while (!a.empty() && !a.back()) a.pop_back();
+}
+
+static Limbs multiply(const Limbs &a, const Limbs &b, uint64_t limb_base) {
+    if (a.empty() || b.empty()) return Limbs();
+    Limbs r(a.size() + b.size());
+    Multiplier::mul(a.data(), a.size(), b.data(), b.size(), r.data(), limb_base);
+    trim(r);
+    return r;
+}
+
+// a small value (below limb_base^2) as limbs
+static Limbs from_value(uint64_t val, uint64_t limb_base) {
+    Limbs a;
+    while (val) {
+        uint64_t carry;
+        a.push_back(LimbArith::split(val, limb_base, carry));
+        val = carry;
+    }
+    return a;
+}
+
+// quadratic conversion: peel off the lowest target limb by one pass of long division each time
+static Limbs convert_basecase(Limbs a, uint64_t from, uint64_t to, size_t need) {
+    Limbs r;
+    while (!a.empty() && r.size() < need) {
+        uint64_t rem = 0;
+        for (size_t i = a.size(); i > 0; i--) {
+            uint64_t cur = rem * from + a[i - 1]; // rem < to <= 2^32 and from <= 2^32 so this fits in 64 bits
+            a[i - 1] = (uint32_t) (cur / to);
+            rem = cur % to;
+        }
+        trim(a);
+        r.push_back((uint32_t) rem);
+    }
+    trim(r);
+    return r;
+}
+
+// powers[i] is to^(2^i) written in base from
+static Limbs convert_rec(const Limbs &a, const std::vector<Limbs> &powers, uint64_t from, uint64_t to, size_t need) {
+    // split by the largest power that takes about half of the limbs, so both halves are balanced
+    size_t k = powers.size();
+    while (k > 0 && powers[k - 1].size() * 2 > a.size()) k--;
+    if (a.size() <= BaseConverter::BASECASE_THRESHOLD || k == 0) return convert_basecase(a, from, to, need);
+    const Limbs &p = powers[k - 1];
+    const size_t shift = (size_t) 1 << (k - 1);
+
+    // a = q * to^shift + r, then r fills the low shift target limbs and q the ones above
+    Limbs q = Divider::divide(a.data(), a.size(), p.data(), p.size(), from);
+    Limbs r = a;
+    const Limbs qp = multiply(q, p, from);
+    LimbArith::sub_in(r.data(), r.size(), qp.data(), qp.size(), from);
+    trim(r);
+    Limbs ret = convert_rec(r, powers, from, to, std::min(need, shift));
+    // the high half is skipped entirely when only the low limbs are needed
+    if (need > shift && !q.empty()) {
+        Limbs hi = convert_rec(q, powers, from, to, need - shift);
+        ret.resize(shift, 0);
+        ret.insert(ret.end(), hi.begin(), hi.end());
+    }
+    trim(ret);
+    return ret;
+}
+
+std::vector<uint32_t> BaseConverter::power(uint64_t base, uint64_t e, uint64_t limb_base) {
+    Limbs ret(1, 1), b = from_value(base, limb_base);
+    // left-to-right binary exponentiation
+    for (int i = 63; i >= 0; i--) {
+        if (ret.size() > 1 || ret[0] != 1) ret = multiply(ret, ret, limb_base);
+        if ((e >> i) & 1) ret = multiply(ret, b, limb_base);
+    }
+    return ret;
+}
+
+std::vector<uint32_t> BaseConverter::convert(const uint32_t *x, size_t n, uint64_t from, uint64_t to, size_t need) {
+    Limbs a(x, x + n);
+    trim(a);
+    if (from == to) {
+        if (a.size() > need) a.resize(need);
+        trim(a);
+        return a;
+    }
+    std::vector<Limbs> powers(1, from_value(to, from));
+    while (powers.back().size() * 2 <= a.size()) powers.push_back(multiply(powers.back(), powers.back(), from));
+    return convert_rec(a, powers, from, to, need);
+}
+
+// e with root^e == a, or 0 if a is not a power of root
+static uint32_t log_exact(uint64_t a, uint64_t root) {
+    uint32_t e = 0;
+    while (a > 1 && a % root == 0) {
+        a /= root;
+        e++;
+    }
+    return a == 1 ? e : 0;
+}
+
+uint64_t BaseConverter::commonRoot(uint64_t a, uint64_t b) {
+    if (a == b || a < 2 || b < 2) return 0;
+    // every common root of a and b is a power of the smallest root of a, so that one is the only candidate
+    for (uint32_t e = 63; e > 0; e--) {
+        uint64_t r = (uint64_t) std::llround(std::pow((double) a, 1.0 / e));
+        for (uint64_t c = r > 2 ? r - 1 : 2; c <= r + 1; c++) {
+            if (log_exact(a, c) == e) return log_exact(b, c) ? c : 0;
+        }
+    }
+    return 0;
+}
+
+void BaseConverter::regroupBits(const uint32_t *x, size_t n, unsigned from_bits, int64_t shift, uint32_t *out, size_t m, unsigned to_bits) {
+    const int64_t total = (int64_t) n * from_bits;
+    for (size_t i = 0; i < m; i++) {
+        // gather the to_bits wide window starting at bit pos of x, from at most three source limbs
+        int64_t pos = (int64_t) i * to_bits + shift;
+        uint64_t val = 0;
+        unsigned got = 0;
+        if (pos < 0) {
+            got = (unsigned) std::min<int64_t>(-pos, to_bits);
+            pos += got;
+        }
+        while (got < to_bits && pos < total) {
+            const size_t limb = (size_t) (pos / from_bits);
+            const unsigned off = (unsigned) (pos % from_bits);
+            const unsigned take = std::min(from_bits - off, to_bits - got);
+            val |= (uint64_t) ((x[limb] >> off) & (uint32_t) (((uint64_t) 1 << take) - 1)) << got;
+            got += take;
+            pos += take;
+        }
+        out[i] = (uint32_t) val;
+    }
+}
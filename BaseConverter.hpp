@@ -0,0 +1,25 @@
+#ifndef __BASE_CONVERTER_HPP__
+#define __BASE_CONVERTER_HPP__
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// 在两种 limb 基数之间转换无符号大数，按目标基数的幂分治，乘除法都交给 Multiplier 和 Divider
+class BaseConverter {
+    public:
+        // 不超过该 limb 数时直接逐次除以目标 limb 基数
+        static const size_t BASECASE_THRESHOLD = 32;
+        // 返回 base^e，以 limb_base 为基数，结果去掉了高位的 0
+        static std::vector<uint32_t> power(uint64_t base, uint64_t e, uint64_t limb_base);
+        // 把以 from 为基数的 x 转换为以 to 为基数，只保留最低的 need 个 limb，结果去掉了高位的 0
+        static std::vector<uint32_t> convert(const uint32_t *x, size_t n, uint64_t from, uint64_t to, size_t need = SIZE_MAX);
+        // a 和 b 不同且都是同一个整数的幂时返回其中最小的一个，否则返回 0
+        // 这时两种基数的数字都由若干个该整数的数字组成，转换只需重新分组，不做乘除法
+        static uint64_t commonRoot(uint64_t a, uint64_t b);
+        // 按二进制位重新分组：x 的每个 limb 存放 from_bits 位，out 的每个 limb 存放 to_bits 位，
+        // out 的第 t 位取 x 的第 t + shift 位，超出 x 的位为 0
+        static void regroupBits(const uint32_t *x, size_t n, unsigned from_bits, int64_t shift, uint32_t *out, size_t m, unsigned to_bits);
+};
+
+#endif
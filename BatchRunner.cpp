@@ -0,0 +1,179 @@
+#include "BatchRunner.hpp"
+#include "FixedFloat.hpp"
+#include "Expression.hpp"
+#include "RootFinder.hpp"
+#include "ResultCache.hpp"
+
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+static uint64_t read_field(std::istringstream &fields, uint64_t min, uint64_t max) {
+    uint64_t val;
+    if (!(fields >> val) || val < min || val > max) throw std::runtime_error("invalid record");
+    return val;
+}
+
+// format v at the end of out, without a temporary string
+static void append(std::string &out, const FixedFloat &v) {
+    const size_t at = out.size();
+    out.resize(at + v.maxChars());
+    out.resize(v.toChars(out.data() + at, out.data() + out.size()).ptr - out.data());
+}
+
+BatchRunner::BatchRunner(ThreadPool &pool, uint64_t max_digits): pool(pool), max_digits(max_digits) {}
+
+std::string BatchRunner::process(const std::string &line) {
+    std::istringstream fields(line);
+    std::string kind;
+    fields >> kind;
+    try {
+        const uint16_t base = (uint16_t) read_field(fields, 2, 36);
+        const uint64_t int_digit_len = read_field(fields, 0, FixedFloat::MAX_DIGIT_LEN);
+        const uint64_t dec_digit_len = read_field(fields, 0, FixedFloat::MAX_DIGIT_LEN);
+        // jobs may come from any client of the server, so one line must not claim all of the memory
+        if (int_digit_len + dec_digit_len > max_digits) throw std::runtime_error("precision too large");
+        if (kind == "eval") {
+            std::string src, x;
+            if (!(fields >> src)) throw std::runtime_error("invalid record");
+            ResultCache &cache = ResultCache::shared();
+            const std::shared_ptr<const ResultCache::Compiled> e = cache.compile(src);
+            std::vector<FixedFloat> xs;
+            while (fields >> x) xs.emplace_back(base, int_digit_len, dec_digit_len, x);
+            if (xs.empty()) throw std::runtime_error("invalid record");
+            std::string ret;
+            if (xs.size() >= BATCH_MIN_POINTS) {
+                // this already runs in a pool task, parallelFor keeps the thread numbers of nested calls apart
+                for (const FixedFloat &y : e->expr.evalBatch(xs, pool)) {
+                    append(ret, y);
+                    ret += ' ';
+                }
+            } else {
+                // repeated queries are answered from the result cache
+                for (const FixedFloat &y : xs) {
+                    append(ret, cache.eval(*e, y));
+                    ret += ' ';
+                }
+            }
+            ret.pop_back();
+            return ret;
+        }
+        if (kind == "adapt") {
+            // the third field is the number of correct digits, x keeps all of its own digits
+            std::string src, x;
+            if (!(fields >> src)) throw std::runtime_error("invalid record");
+            const std::shared_ptr<const ResultCache::Compiled> e = ResultCache::shared().compile(src);
+            std::string ret;
+            while (fields >> x) {
+                const size_t dot = x.find('.');
+                const uint64_t x_dec = dot == std::string::npos ? 1 : std::max<uint64_t>(x.size() - dot - 1, 1);
+                if (int_digit_len + x_dec > max_digits) throw std::runtime_error("precision too large");
+                // escalation stops at the same cap, an answer that needs more digits fails the job
+                append(ret, e->expr.evalAdaptive(FixedFloat(base, int_digit_len, x_dec, x), dec_digit_len, max_digits).value);
+                ret += ' ';
+            }
+            if (ret.empty()) throw std::runtime_error("invalid record");
+            ret.pop_back();
+            return ret;
+        }
+        if (kind == "conv") {
+            std::string num;
+            if (!(fields >> num)) throw std::runtime_error("invalid record");
+            const uint16_t base_to = (uint16_t) read_field(fields, 2, 36);
+            return FixedFloat(base, int_digit_len, dec_digit_len, num).baseTo(base_to).toString();
+        }
+        if (kind == "root" || kind == "roots") {
+            std::string src;
+            if (!(fields >> src)) throw std::runtime_error("invalid record");
+            const FixedFloat like(base, int_digit_len, dec_digit_len);
+            Polynomial p;
+            if (!ResultCache::shared().compile(src)->expr.toPolynomial(like, p)) throw std::runtime_error("not a polynomial");
+            if (kind == "root") {
+                std::string lo, hi;
+                if (!(fields >> lo >> hi)) throw std::runtime_error("invalid record");
+                return RootFinder::newton(p, FixedFloat(base, int_digit_len, dec_digit_len, lo), FixedFloat(base, int_digit_len, dec_digit_len, hi)).toString();
+            }
+            // every root is printed as re,im
+            std::string ret;
+            for (const RootFinder::Root &r : RootFinder::aberth(p)) {
+                append(ret, r.re);
+                ret += ',';
+                append(ret, r.im);
+                ret += ' ';
+            }
+            if (!ret.empty()) ret.pop_back();
+            return ret;
+        }
+        throw std::runtime_error("unknown record type");
+    } catch (std::exception &e) {
+        return std::string("error: ") + e.what();
+    }
+}
+
+void BatchRunner::write_loop(std::ostream &out) {
+    while (true) {
+        std::shared_ptr<Chunk> chunk;
+        bool idle;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [this] { return (!queue.empty() && queue.front()->done) || (finished && queue.empty()); });
+            if (queue.empty()) return;
+            chunk = queue.front();
+            queue.pop_front();
+            idle = queue.empty();
+        }
+        changed.notify_all(); // there is room for the reader again
+        out.write(chunk->output.data(), chunk->output.size());
+        // flush only when nothing else is waiting, so piped input still sees its results promptly
+        if (idle) out.flush();
+    }
+}
+
+size_t BatchRunner::run(std::istream &in, std::ostream &out) {
+    finished = false;
+    std::thread writer(&BatchRunner::write_loop, this, std::ref(out));
+    const size_t max_in_flight = MAX_IN_FLIGHT_PER_THREAD * (pool.size() + 1);
+    size_t records = 0;
+    std::string line;
+    bool eof = false;
+    while (!eof) {
+        // cut a chunk when it is full or when no more input is buffered, so slow producers are not held back
+        std::shared_ptr<Chunk> chunk = std::make_shared<Chunk>();
+        while (chunk->lines.size() < CHUNK_LINES) {
+            if (!chunk->lines.empty() && in.rdbuf()->in_avail() <= 0) break;
+            if (!std::getline(in, line)) {
+                eof = true;
+                break;
+            }
+            if (line.empty() || line[0] == '#') continue;
+            chunk->lines.push_back(std::move(line));
+        }
+        if (chunk->lines.empty()) continue;
+        records += chunk->lines.size();
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&] { return queue.size() < max_in_flight; });
+            queue.push_back(chunk);
+        }
+        pool.submit([this, chunk] (size_t) {
+            std::string output;
+            for (const std::string &l : chunk->lines) {
+                output += process(l);
+                output += '\n';
+            }
+            // notify under the lock, run() may return and destroy the runner as soon as the lock is released
+            std::lock_guard<std::mutex> lock(mutex);
+            chunk->output = std::move(output);
+            chunk->done = true;
+            changed.notify_all();
+        });
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished = true;
+    }
+    changed.notify_all();
+    writer.join();
+    return records;
+}
@@ -0,0 +1,57 @@
+#ifndef __BATCH_RUNNER_HPP__
+#define __BATCH_RUNNER_HPP__
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <istream>
+#include <ostream>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include "ThreadPool.hpp"
+
+// 非交互的批处理模式，每行一个任务，结果按输入顺序每行一个输出
+// 读取、计算和输出组成流水线：读取线程把行切成块，线程池并行地解析、求值和格式化各块，输出线程按顺序写出
+// 任务格式：
+//   eval <base> <int_digit_len> <dec_digit_len> <expression> <x1> [<x2> ...]
+//   adapt <base> <int_digit_len> <digits> <expression> <x1> [<x2> ...]
+//   conv <base> <int_digit_len> <dec_digit_len> <number> <base_to>
+//   root <base> <int_digit_len> <dec_digit_len> <polynomial> <lo> <hi>
+//   roots <base> <int_digit_len> <dec_digit_len> <polynomial>
+// 空行和以 # 开头的行被忽略，出错的任务输出 error: 加原因
+class BatchRunner {
+    public:
+        // 每个块最多包含的行数
+        static const size_t CHUNK_LINES = 256;
+        // 每个线程最多对应的未输出块数，超过时读取线程等待，以限制内存
+        static const size_t MAX_IN_FLIGHT_PER_THREAD = 4;
+        // 一个任务中 x 的个数不少于该值时交给 evalBatch 并行求值
+        static const size_t BATCH_MIN_POINTS = 64;
+        // 默认的单个任务最大位数，整数位数与小数位数（adapt 为正确位数）之和超过它的任务报错
+        static const uint64_t DEFAULT_MAX_DIGITS = 10000000;
+    private:
+        struct Chunk {
+            std::vector<std::string> lines;
+            std::string output;
+            bool done = false;
+        };
+        ThreadPool &pool;
+        uint64_t max_digits;
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::deque<std::shared_ptr<Chunk>> queue; // 按输入顺序排列的未输出块
+        bool finished = false;
+        // 输出线程，按顺序写出已完成的块，没有待输出的块时刷新
+        void write_loop(std::ostream &out);
+    public:
+        explicit BatchRunner(ThreadPool &pool = ThreadPool::shared(), uint64_t max_digits = DEFAULT_MAX_DIGITS);
+        // 处理 in 中的所有任务，结果写入 out，返回任务数
+        size_t run(std::istream &in, std::ostream &out);
+        // 处理一行任务，返回不带换行符的结果
+        std::string process(const std::string &line);
+};
+
+#endif
@@ -0,0 +1,150 @@
+#include "Divider.hpp"
+#include "LimbArith.hpp"
+#include "Multiplier.hpp"
+
+#include <algorithm>
+
+typedef std::vector<uint32_t> Limbs;
+
+// remove the leading zero limbs
+static void trim(Limbs &a) {
+    while (!a.empty() && !a.back()) a.pop_back();
+}
+
+static Limbs multiply(const Limbs &a, const Limbs &b, uint64_t limb_base) {
+    if (a.empty() || b.empty()) return Limbs();
+    Limbs r(a.size() + b.size());
+    Multiplier::mul(a.data(), a.size(), b.data(), b.size(), r.data(), limb_base);
+    trim(r);
+    return r;
+}
+
+// compare two trimmed numbers
+static int compare(const Limbs &a, const Limbs &b) {
+    if (a.size() != b.size()) return a.size() < b.size() ? -1 : 1;
+    return LimbArith::compare(a.data(), b.data(), a.size());
+}
+
+// a += b
+static void add_to(Limbs &a, const Limbs &b, uint64_t limb_base) {
+    if (a.size() < b.size()) a.resize(b.size(), 0);
+    a.push_back(0);
+    LimbArith::add_in(a.data(), a.size(), b.data(), b.size(), limb_base);
+    trim(a);
+}
+
+// a *= f for a single limb f
+static void mul_small(Limbs &a, uint32_t f, uint64_t limb_base) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < a.size(); i++) {
+        a[i] = LimbArith::split((uint64_t) a[i] * f + carry, limb_base, carry);
+    }
+    if (carry) a.push_back((uint32_t) carry);
+}
+
+// a -= b, a >= b is required
+static void sub_from(Limbs &a, const Limbs &b, uint64_t limb_base) {
+    LimbArith::sub_in(a.data(), a.size(), b.data(), b.size(), limb_base);
+    trim(a);
+}
+
+std::vector<uint32_t> Divider::reciprocal(const uint32_t *v, size_t n, uint64_t limb_base) {
+    if (n == 1) {
+        // B^2 fits in 128 bits for every limb base
+        unsigned __int128 q = (unsigned __int128) limb_base * limb_base / v[0];
+        Limbs z;
+        while (q) {
+            z.push_back((uint32_t) (q % limb_base));
+            q /= limb_base;
+        }
+        return z;
+    }
+
+    // the top h limbs of a normalized v are accurate to about h limbs, scale their reciprocal up as the first guess
+    const size_t h = (n + 1) / 2;
+    Limbs z = reciprocal(v + n - h, h, limb_base);
+    z.insert(z.begin(), n - h, 0);
+
+    // one Newton step doubles the accurate limbs: z = z + z * (B^(2n) - v * z) / B^(2n)
+    const Limbs vv(v, v + n);
+    Limbs one(1, 1), unit(2 * n + 1, 0);
+    unit[2 * n] = 1;
+    Limbs t = multiply(vv, z, limb_base);
+    bool over = compare(t, unit) > 0;
+    Limbs e = over ? t : unit;
+    sub_from(e, over ? unit : t, limb_base);
+    Limbs d = multiply(z, e, limb_base);
+    d.erase(d.begin(), d.begin() + std::min(d.size(), 2 * n));
+    if (over) sub_from(z, d, limb_base);
+    else add_to(z, d, limb_base);
+
+    // the step leaves an error of a few units since v is normalized, fix it so that v * z <= B^(2n) < v * (z + 1)
+    Limbs p = multiply(vv, z, limb_base);
+    while (compare(p, unit) > 0) {
+        sub_from(z, one, limb_base);
+        sub_from(p, vv, limb_base);
+    }
+    while (true) {
+        add_to(p, vv, limb_base);
+        if (compare(p, unit) > 0) break;
+        add_to(z, one, limb_base);
+    }
+    return z;
+}
+
+std::vector<uint32_t> Divider::divide(const uint32_t *u, size_t nu, const uint32_t *v, size_t nv, uint64_t limb_base) {
+    while (nv && !v[nv - 1]) nv--;
+    while (nu && !u[nu - 1]) nu--;
+    // floor(u / (v * B^t)) == floor(floor(u / B^t) / v), so the low zero limbs of v can be dropped
+    size_t t = 0;
+    while (t < nv && !v[t]) t++;
+    if (nu <= t) return Limbs();
+    u += t;
+    nu -= t;
+    v += t;
+    nv -= t;
+
+    Limbs uu(u, u + nu), vv(v, v + nv);
+    if (compare(uu, vv) < 0) return Limbs();
+
+    // a single limb divisor only needs one pass of long division
+    if (nv == 1) {
+        Limbs q(nu);
+        uint64_t r = 0;
+        for (size_t i = nu; i > 0; i--) {
+            uint64_t cur = r * limb_base + u[i - 1]; // r < v[0] < 2^32 so this fits in 64 bits
+            q[i - 1] = (uint32_t) (cur / v[0]);
+            r = cur % v[0];
+        }
+        trim(q);
+        return q;
+    }
+
+    // scale both by f so that the top limb of v is at least B / 2, the quotient does not change
+    const uint32_t f = (uint32_t) (limb_base / ((uint64_t) vv.back() + 1));
+    if (f > 1) {
+        mul_small(uu, f, limb_base);
+        mul_small(vv, f, limb_base);
+    }
+    nu = uu.size();
+    nv = vv.size();
+
+    // the reciprocal of an n limb divisor handles dividends up to 2n limbs, scale both up if needed
+    size_t s = nu > 2 * nv ? nu - 2 * nv : 0;
+    uu.insert(uu.begin(), s, 0);
+    vv.insert(vv.begin(), s, 0);
+    const size_t n = nv + s;
+    Limbs z = reciprocal(vv.data(), n, limb_base);
+
+    // q = u * z / B^(2n) never exceeds the true quotient and falls short of it by at most 2
+    Limbs q = multiply(uu, z, limb_base);
+    q.erase(q.begin(), q.begin() + std::min(q.size(), 2 * n));
+    Limbs r = uu;
+    sub_from(r, multiply(q, vv, limb_base), limb_base);
+    const Limbs one(1, 1);
+    while (compare(r, vv) >= 0) {
+        sub_from(r, vv, limb_base);
+        add_to(q, one, limb_base);
+    }
+    return q;
+}
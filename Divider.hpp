@@ -0,0 +1,17 @@
+#ifndef __DIVIDER_HPP__
+#define __DIVIDER_HPP__
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// 大数除法，先用 Newton 迭代求倒数，再用一次乘法得到商，所有乘法都交给 Multiplier
+class Divider {
+    public:
+        // 返回 floor(B^(2n) / v)，v 有 n 个 limb 且最高 limb 不小于 B / 2，B 为 limb_base
+        static std::vector<uint32_t> reciprocal(const uint32_t *v, size_t n, uint64_t limb_base);
+        // 返回 floor(u / v)，v 不能为 0，结果去掉了高位的 0
+        static std::vector<uint32_t> divide(const uint32_t *u, size_t nu, const uint32_t *v, size_t nv, uint64_t limb_base);
+};
+
+#endif
@@ -1,11 +1,20 @@
 #include <cstdint>
 #include <cmath>
+#include <cfloat>
 #include <stack>
 #include <queue>
 #include <stdexcept>
 #include <functional>
+#include <mutex>
+#include <map>
+#include <tuple>
+#include <algorithm>
+#include <optional>
 #include "FixedFloat.hpp"
 #include "Expression.hpp"
+#include "Profiler.hpp"
+
+static_assert((size_t) Expression::OpCode::POW == (size_t) Profiler::Op::POW, "profiler ops must follow the opcodes");
 
 
 uint32_t Expression::get_priority(const char c) const {
@@ -43,8 +52,103 @@ bool Expression::is_left_bracket(const char c) const {
 bool Expression::is_right_bracket(const char c) const {
     return c == ')';
 }
+// state that only lives while the expression is being compiled
+struct Expression::Builder {
+    std::vector<uint32_t> operands; // nodes not yet consumed by an operator
+    std::map<std::tuple<OpCode, uint32_t, uint32_t>, uint32_t> nodes;
+    std::map<std::string, uint32_t> literals;
+};
+uint32_t Expression::make_node(Builder& b, OpCode op, uint32_t lhs, uint32_t rhs) {
+    // a + b and b + a are the same node, so are a * b and b * a
+    if ((op == OpCode::ADD || op == OpCode::MUL) && lhs > rhs) std::swap(lhs, rhs);
+    auto it = b.nodes.find({op, lhs, rhs});
+    if (it != b.nodes.end()) return it->second;
+    const bool constant = op == OpCode::CONST || (op != OpCode::VAR && code[lhs].constant && code[rhs].constant);
+    code.push_back({op, constant, lhs, rhs});
+    b.nodes[{op, lhs, rhs}] = code.size() - 1;
+    return code.size() - 1;
+}
+void Expression::emit_num(Builder& b, const std::string& num) {
+    auto it = b.literals.find(num);
+    if (it == b.literals.end()) {
+        it = b.literals.emplace(num, literals.size()).first;
+        literals.push_back(num);
+    }
+    b.operands.push_back(make_node(b, OpCode::CONST, it->second, 0));
+}
+void Expression::emit_var(Builder& b) {
+    b.operands.push_back(make_node(b, OpCode::VAR, 0, 0));
+}
+void Expression::emit_op(Builder& b, const char c) {
+    // every operator pops two operands and pushes the result
+    if (b.operands.size() < 2) throw std::runtime_error("invalid expression");
+    const uint32_t rhs = b.operands.back();
+    b.operands.pop_back();
+    const uint32_t lhs = b.operands.back();
+    b.operands.pop_back();
+    switch (c) {
+        case '+': b.operands.push_back(make_node(b, OpCode::ADD, lhs, rhs)); break;
+        case '-': b.operands.push_back(make_node(b, OpCode::SUB, lhs, rhs)); break;
+        case '*': b.operands.push_back(make_node(b, OpCode::MUL, lhs, rhs)); break;
+        case '/': b.operands.push_back(make_node(b, OpCode::DIV, lhs, rhs)); break;
+        case '^': {
+            // x^k with a small integer literal k becomes the left-to-right square-and-multiply chain of FixedFloat::pow,
+            // so the result is the same and x^2 in x^3 + x^2 is computed once
+            const Instr &e = code[rhs];
+            const std::string *k_str = e.op == OpCode::CONST ? &literals[e.lhs] : nullptr;
+            uint32_t k = 0;
+            if (!code[lhs].constant && k_str && k_str->size() <= 3 && std::all_of(k_str->begin(), k_str->end(), [this] (char d) { return is_num(d); }))
+                k = std::stoul(*k_str);
+            if (k >= 1 && k < MAX_CHAIN_EXPONENT) {
+                uint32_t r = lhs;
+                for (int i = 30 - __builtin_clz(k); i >= 0; i--) {
+                    r = make_node(b, OpCode::MUL, r, r);
+                    if ((k >> i) & 1) r = make_node(b, OpCode::MUL, r, lhs);
+                }
+                b.operands.push_back(r);
+            } else {
+                b.operands.push_back(make_node(b, OpCode::POW, lhs, rhs));
+            }
+            break;
+        }
+        default: throw std::runtime_error("invalid expression");
+    }
+}
+void Expression::prune() {
+    // keep only the nodes the result depends on, and the literals they use
+    std::vector<bool> used(code.size(), false);
+    used[result] = true;
+    for (size_t i = code.size(); i > 0; i--) {
+        const Instr &ins = code[i - 1];
+        if (!used[i - 1] || ins.op == OpCode::CONST || ins.op == OpCode::VAR) continue;
+        used[ins.lhs] = used[ins.rhs] = true;
+    }
+    std::vector<uint32_t> reg(code.size()), lit(literals.size(), UINT32_MAX);
+    std::vector<Instr> kept;
+    std::vector<std::string> kept_literals;
+    for (size_t i = 0; i < code.size(); i++) {
+        if (!used[i]) continue;
+        Instr ins = code[i];
+        if (ins.op == OpCode::CONST) {
+            if (lit[ins.lhs] == UINT32_MAX) {
+                lit[ins.lhs] = kept_literals.size();
+                kept_literals.push_back(literals[ins.lhs]);
+            }
+            ins.lhs = lit[ins.lhs];
+        } else if (ins.op != OpCode::VAR) {
+            ins.lhs = reg[ins.lhs];
+            ins.rhs = reg[ins.rhs];
+        }
+        reg[i] = kept.size();
+        kept.push_back(ins);
+    }
+    result = reg[result];
+    code = std::move(kept);
+    literals = std::move(kept_literals);
+}
 Expression::Expression(const std::string& input) {
     const uint32_t len = input.length();
+    Builder builder;
     std::string num_str;
     std::stack<char> op_stack;
     bool add_mul = false; // add '*' operator when necessary, e.g. 2x -> 2*x
@@ -98,7 +202,7 @@ Expression::Expression(const std::string& input) {
         } 
         // if num_str is not empty, it means that the number has ended, then push it to the queue
         else if (!num_str.empty()) { 
-            expr.push(num_str);
+            emit_num(builder, num_str);
             num_str.clear();
             // no continue here
         }
@@ -113,7 +217,7 @@ Expression::Expression(const std::string& input) {
         // if c is a right bracket, then pop all operators from the stack until a left bracket is encountered
         else if (is_right_bracket(c)) {
             while (!op_stack.empty() && op_stack.top() != '(') {
-                expr.push(std::string(1, op_stack.top()));
+                emit_op(builder, op_stack.top());
                 op_stack.pop();
             }
             if (!op_stack.empty()) {
@@ -126,7 +230,7 @@ Expression::Expression(const std::string& input) {
 
         // if c is a variable, then push it to the queue
         if (is_variable(c)) {
-            expr.push("x");
+            emit_var(builder);
 
             last_c = c;
             continue;
@@ -135,7 +239,7 @@ Expression::Expression(const std::string& input) {
         // if c is an operator, then pop all operators from the stack whose priority is not less than c and push it to the queue
         if (is_op(c)) {
             while (!op_stack.empty() && get_priority(op_stack.top()) >= get_priority(c)) {
-                expr.push(std::string(1, op_stack.top()));
+                emit_op(builder, op_stack.top());
                 op_stack.pop();
             }
             op_stack.push(c);
@@ -148,80 +252,629 @@ Expression::Expression(const std::string& input) {
 
     // clear the remaining number
     if (!num_str.empty()) {
-        expr.push(num_str);
+        emit_num(builder, num_str);
     }
     // clear the remaining operators
     while (!op_stack.empty()) {
-        expr.push(std::string(1, op_stack.top()));
+        emit_op(builder, op_stack.top());
         op_stack.pop();
     }
+    if (builder.operands.size() != 1) {
+        throw std::runtime_error("invalid expression");
+    }
+    result = builder.operands[0];
+    prune();
+}
+Expression::Expression(std::vector<Instr> code, std::vector<std::string> literals, uint32_t result):
+                        code(std::move(code)),
+                        literals(std::move(literals)),
+                        result(result) {}
+uint64_t Expression::effective_digits(const FixedFloat& f) {
+    return f.is_zero() ? 0 : f.most_significant_digit() - f.least_significant_digit();
+}
+double Expression::log_magnitude(const FixedFloat& f) {
+    if (f.is_zero()) return -INFINITY;
+    // the value is the sum of arr[i] * limb_base^(i - dec_limb_len), the two leading limbs give the mantissa
+    const uint64_t top = f.hi_limb - 1;
+    double lead = f.arr[top];
+    if (top > 0) lead += (double) f.arr[top - 1] / f.limb_base;
+    return ((double) top - (double) f.dec_limb_len) * f.digit_per_limb + std::log(lead) / std::log((double) f.base);
+}
+void Expression::exec(size_t i, const FixedFloat& x, Context& ctx) const {
+    const Instr &ins = code[i];
+    std::vector<FixedFloat> &regs = ctx.regs;
+    // only measured while a Profiler::Scope is active on this thread
+    std::optional<Profiler::Timer> timer;
+    if (Profiler::Profile *profile = Profiler::active()) {
+        uint64_t lhs = 0, rhs = 0;
+        // a constant reports the digits of its folded register, which are known once it is computed
+        if (ins.op == OpCode::VAR) lhs = effective_digits(x);
+        else if (ins.op == OpCode::CONST) lhs = 0;
+        else {
+            lhs = effective_digits(regs[ins.lhs]);
+            rhs = effective_digits(regs[ins.rhs]);
+        }
+        timer.emplace(profile, (Profiler::Op) ins.op, (uint32_t) i, 1, lhs, rhs);
+    }
+    switch (ins.op) {
+        case OpCode::CONST: {
+            // literals are written in decimal
+            FixedFloat c(10, x.int_digit_len, x.dec_digit_len, literals[ins.lhs]);
+            regs[i] = x.base == 10 ? std::move(c) : c.baseTo(x.base);
+            if (timer) timer->setDigits(effective_digits(regs[i]), 0);
+            break;
+        }
+        case OpCode::VAR: {
+            regs[i] = x;
+            break;
+        }
+        case OpCode::ADD: {
+            regs[i] = regs[ins.lhs];
+            regs[i] += regs[ins.rhs];
+            break;
+        }
+        case OpCode::SUB: {
+            regs[i] = regs[ins.lhs];
+            regs[i] -= regs[ins.rhs];
+            break;
+        }
+        case OpCode::MUL: {
+            regs[i] = regs[ins.lhs];
+            regs[i] *= regs[ins.rhs];
+            break;
+        }
+        case OpCode::DIV: {
+            regs[i] = regs[ins.lhs] / regs[ins.rhs];
+            break;
+        }
+        case OpCode::POW: {
+            // negative exponents are the inverse of the positive power
+            int32_t n = regs[ins.rhs].intValue();
+            regs[i] = n >= 0 ? regs[ins.lhs].pow(n) : regs[ins.lhs].pow(-(int64_t) n).inverse();
+            break;
+        }
+    }
+}
+void Expression::prepare(const FixedFloat& x, Context& ctx, bool tracked) const {
+    if (ctx.ready && ctx.tracked == tracked && ctx.base == x.base && ctx.int_digit_len == x.int_digit_len && ctx.dec_digit_len == x.dec_digit_len)
+        return;
+    ctx.ready = false;
+    ctx.tracked = tracked;
+    ctx.base = x.base;
+    ctx.int_digit_len = x.int_digit_len;
+    ctx.dec_digit_len = x.dec_digit_len;
+    // constant subexpressions are folded once per format
+    ctx.regs.assign(code.size(), FixedFloat(x.base, x.int_digit_len, x.dec_digit_len));
+    for (size_t i = 0; i < code.size(); i++) {
+        if (code[i].constant) exec(i, x, ctx);
+    }
+    // error tracking needs every intermediate register, so the expression is not expanded
+    ctx.is_poly = !tracked && expand(x, ctx, ctx.poly, ctx.poly_errs);
+    ctx.errs.assign(tracked ? code.size() : 0, 0);
+    ctx.lanes_ready = false;
+    ctx.lanes.clear();
+    ctx.ready = true;
+}
+// bounds on the coefficients of an expanded subexpression, mag[k] >= |c_k| and err[k] is the error of c_k in ulps
+struct CoeffBound {
+    std::vector<double> mag;
+    std::vector<double> err;
+};
+static CoeffBound bound_add(const CoeffBound& a, const CoeffBound& b) {
+    const bool longer = a.mag.size() >= b.mag.size();
+    CoeffBound ret = longer ? a : b;
+    const CoeffBound &s = longer ? b : a;
+    for (size_t k = 0; k < s.mag.size(); k++) {
+        ret.mag[k] += s.mag[k];
+        ret.err[k] += s.err[k];
+    }
+    return ret;
+}
+static CoeffBound bound_mul(const CoeffBound& a, const CoeffBound& b) {
+    // every product of two coefficients that are not known to be 0 carries the errors of its factors,
+    // and Polynomial::operator* truncates the exact sum of each coefficient once
+    const size_t n = a.mag.size() + b.mag.size() - 1;
+    CoeffBound ret{std::vector<double>(n, 0), std::vector<double>(n, 0)};
+    std::vector<bool> truncated(n, false);
+    for (size_t i = 0; i < a.mag.size(); i++) {
+        for (size_t j = 0; j < b.mag.size(); j++) {
+            if ((a.mag[i] == 0 && a.err[i] == 0) || (b.mag[j] == 0 && b.err[j] == 0)) continue;
+            ret.mag[i + j] += a.mag[i] * b.mag[j];
+            ret.err[i + j] += a.mag[i] * b.err[j] + a.err[i] * b.mag[j];
+            truncated[i + j] = true;
+        }
+    }
+    for (size_t k = 0; k < n; k++) ret.err[k] += truncated[k];
+    return ret;
+}
+// integers convert exactly, fractions lose at most one digit when parsed and one more in baseTo
+static double literal_error(const std::string& literal, uint16_t base) {
+    if (literal.find('.') == std::string::npos) return 0;
+    return base == 10 ? 1 : 2;
+}
+double Expression::error_bound(size_t i, const FixedFloat& x, const Context& ctx, double ulp, double var_err) const {
+    const Instr &ins = code[i];
+    const std::vector<double> &errs = ctx.errs;
+    const auto mag = [&] (uint32_t r) { return std::fabs(ctx.regs[r].doubleValue()); };
+    const auto lg = [&] (uint32_t r) { return log_magnitude(ctx.regs[r]); };
+    // the register wraps around silently, so overflow is judged from the logarithms of the operands;
+    // an estimate within half a digit of the limit is settled by running the instruction one digit wider
+    const double top = (double) x.int_digit_len;
+    const auto check = [&] (double estimate) {
+        if (estimate < top - 0.5) return;
+        if (estimate >= top + 0.5 || overflows(i, ctx)) throw std::runtime_error("overflow");
+    };
+    switch (ins.op) {
+        case OpCode::CONST:
+            return literal_error(literals[ins.lhs], x.base);
+        case OpCode::VAR:
+            return var_err;
+        case OpCode::ADD:
+        case OpCode::SUB:
+            // |a| + |b| is only an upper bound, it never decides an overflow on its own
+            if (std::max(lg(ins.lhs), lg(ins.rhs)) + 1 / std::log2((double) x.base) >= top - 0.5 && overflows(i, ctx))
+                throw std::runtime_error("overflow");
+            return errs[ins.lhs] + errs[ins.rhs];
+        case OpCode::MUL: {
+            // |ab - AB| <= (|A| + |a - A|) |b - B| + |B| |a - A|, plus the truncated digit
+            const double a = mag(ins.lhs), b = mag(ins.rhs);
+            check(lg(ins.lhs) + lg(ins.rhs));
+            return (a + errs[ins.lhs] * ulp) * errs[ins.rhs] + b * errs[ins.lhs] + 1;
+        }
+        case OpCode::DIV: {
+            // |a/b - A/B| <= (|a - A| + |A/B| |b - B|) / |b|, where |b| is bounded below
+            const double a = mag(ins.lhs), b = mag(ins.rhs);
+            const double low = b - errs[ins.rhs] * ulp;
+            if (low <= 0) return INFINITY;
+            check(lg(ins.lhs) - lg(ins.rhs));
+            return (errs[ins.lhs] + a / b * errs[ins.rhs]) / low + 1;
+        }
+        case OpCode::POW: {
+            const FixedFloat &e = ctx.regs[ins.rhs];
+            if (errs[ins.rhs] > 0) {
+                // a computed exponent such as 1/3*3 may sit an ulp below the integer it stands for at any precision
+                if (code[ins.rhs].op != OpCode::CONST) return INFINITY;
+                // the exponent is truncated to an integer, which must be the same over its whole error interval;
+                // the distances to the integers on both sides are taken exactly, a double can not resolve an ulp next to them
+                FixedFloat frac = e.convertTo(e.base, std::max<uint64_t>(e.int_digit_len, 1), e.dec_digit_len);
+                frac.sign = false;
+                std::fill(frac.arr + frac.dec_limb_len, frac.arr + frac.len, 0);
+                frac.normalize();
+                const FixedFloat one(frac.base, frac.int_digit_len, frac.dec_digit_len, 1.0);
+                const double below = frac.doubleValue() / ulp, above = (one - frac).doubleValue() / ulp;
+                if (errs[ins.rhs] > below || errs[ins.rhs] >= above) return INFINITY;
+            }
+            const int32_t n = e.intValue();
+            if (n == 0) return 0;
+            const double m = std::fabs((double) n), a = mag(ins.lhs);
+            // a negative exponent inverts the positive power, which must fit as well
+            check(m * lg(ins.lhs));
+            // every product in the power chain adds one digit, amplified like the error of the base
+            const double grow = m * std::pow(std::max(1.0, a + errs[ins.lhs] * ulp), m - 1);
+            const double err = grow * (errs[ins.lhs] + 2);
+            if (n > 0) return err;
+            const double low = std::pow(a, m) - err * ulp;
+            if (low <= 0) return INFINITY;
+            return err / (low * low) + 1;
+        }
+    }
+    return INFINITY;
 }
-FixedFloat Expression::eval(FixedFloat x) const {
-    std::stack<FixedFloat> stack;
-    std::queue<std::string> expr = this->expr;
-    // parse postfix expression   
-    while (!expr.empty()) {
-        std::string ele = expr.front();
-        expr.pop();
-        switch (ele[0]) {
-            case '+': {
-                FixedFloat a = stack.top();
-                stack.pop();
-                FixedFloat b = stack.top();
-                stack.pop();
-                stack.push(a + b);
-                break;
-            }
-            case '-': {
-                FixedFloat a = stack.top();
-                stack.pop();
-                FixedFloat b = stack.top();
-                stack.pop();
-                stack.push(b - a);
-                break;
-            }
-            case '*': {
-                FixedFloat a = stack.top();
-                stack.pop();
-                FixedFloat b = stack.top();
-                stack.pop();
-                stack.push(a * b);
-                break;
-            }
-            case '/': {
-                FixedFloat a = stack.top();
-                stack.pop();
-                FixedFloat b = stack.top();
-                stack.pop();
-                stack.push(FixedFloat(10, x.int_digit_len, x.dec_digit_len, b.doubleValue() / a.doubleValue()));
-                break;
-            }
-            case '^': {
-                FixedFloat a = stack.top();
-                stack.pop();
-                FixedFloat b = stack.top();
-                stack.pop();
-                FixedFloat c = FixedFloat(10, x.int_digit_len, x.dec_digit_len, 1);
-                for (int32_t i = 0; i < a.intValue(); i++) {
-                    c = c * b;
+bool Expression::overflows(size_t i, const Context& ctx) const {
+    const Instr &ins = code[i];
+    const FixedFloat &a = ctx.regs[ins.lhs], &b = ctx.regs[ins.rhs];
+    const uint64_t n = a.int_digit_len;
+    // one more digit holds every result the caller could not rule out, and truncation never crosses base^n
+    FixedFloat r = a.convertTo(a.base, n + 1, a.dec_digit_len);
+    switch (ins.op) {
+        case OpCode::ADD:
+            r += b.convertTo(b.base, n + 1, b.dec_digit_len);
+            break;
+        case OpCode::SUB:
+            r -= b.convertTo(b.base, n + 1, b.dec_digit_len);
+            break;
+        case OpCode::MUL:
+            r *= b.convertTo(b.base, n + 1, b.dec_digit_len);
+            break;
+        case OpCode::DIV:
+            r = r / b.convertTo(b.base, n + 1, b.dec_digit_len);
+            break;
+        case OpCode::POW:
+            r = r.pow(std::abs((int64_t) b.intValue()));
+            break;
+        default:
+            return false;
+    }
+    return r.most_significant_digit() > r.dec_digit_len + n;
+}
+bool Expression::expand(const FixedFloat& x, const Context& ctx, Polynomial& out, std::vector<double>& errs) const {
+    // coefficients are as wide as x, a larger one would wrap around like any other overflow, so the
+    // bounds are checked before each node is expanded and such expressions stay on the bytecode
+    const double limit = std::pow((double) x.base, (double) x.int_digit_len);
+    const auto fits = [&] (const CoeffBound& b) {
+        return std::all_of(b.mag.begin(), b.mag.end(), [&] (double m) { return m < limit; });
+    };
+    std::vector<double> vals, const_errs;
+    estimate(x, ctx, vals, const_errs);
+    std::vector<Polynomial> polys(code.size());
+    std::vector<CoeffBound> bounds(code.size());
+    for (size_t i = 0; i < code.size(); i++) {
+        const Instr &ins = code[i];
+        if (ins.constant) {
+            polys[i] = Polynomial::constant(ctx.regs[i]);
+            bounds[i] = {{std::fabs(ctx.regs[i].doubleValue())}, {const_errs[i]}};
+            continue;
+        }
+        const Polynomial &b = polys[ins.lhs], &a = polys[ins.rhs];
+        const CoeffBound &bb = bounds[ins.lhs], &ab = bounds[ins.rhs];
+        switch (ins.op) {
+            case OpCode::VAR: {
+                polys[i] = Polynomial::variable(x);
+                bounds[i] = {{0, 1}, {0, 0}};
+                break;
+            }
+            case OpCode::ADD: {
+                bounds[i] = bound_add(bb, ab);
+                if (!fits(bounds[i])) return false;
+                polys[i] = b + a;
+                break;
+            }
+            case OpCode::SUB: {
+                bounds[i] = bound_add(bb, ab);
+                if (!fits(bounds[i])) return false;
+                polys[i] = b - a;
+                break;
+            }
+            case OpCode::MUL: {
+                if (b.degree() + a.degree() > MAX_POLY_DEGREE) return false;
+                bounds[i] = bound_mul(bb, ab);
+                if (!fits(bounds[i])) return false;
+                polys[i] = b * a;
+                break;
+            }
+            case OpCode::DIV: {
+                // only division by a constant keeps it a polynomial
+                if (!a.isConstant()) return false;
+                const double c = ab.mag[0], ec = ab.err[0];
+                if (c == 0) return false;
+                CoeffBound q = bb;
+                for (size_t k = 0; k < q.mag.size(); k++) {
+                    q.mag[k] /= c;
+                    q.err[k] = (q.err[k] + q.mag[k] * ec) / c + 1;
                 }
-                stack.push(c);
+                bounds[i] = std::move(q);
+                if (!fits(bounds[i])) return false;
+                polys[i] = b / a.coefficients()[0];
                 break;
             }
-            case 'x': {
-                stack.push(x);
+            case OpCode::POW: {
+                // the base is not constant here, so only non-negative exponents give a polynomial
+                if (!a.isConstant()) return false;
+                int32_t n = a.coefficients()[0].intValue();
+                if (n < 0 || b.degree() * n > MAX_POLY_DEGREE) return false;
+                // the same square and multiply steps as Polynomial::pow
+                CoeffBound ret{{1}, {0}}, sqr = bb;
+                for (uint32_t e = n; e; ) {
+                    if (e & 1) ret = bound_mul(ret, sqr);
+                    e >>= 1;
+                    if (e) sqr = bound_mul(sqr, sqr);
+                    if (!fits(ret) || !fits(sqr)) return false;
+                }
+                bounds[i] = std::move(ret);
+                polys[i] = b.pow(n);
                 break;
             }
-            // if it is a number
+            default:
+                break;
+        }
+    }
+    out = std::move(polys[result]);
+    errs = std::move(bounds[result].err);
+    errs.resize(out.coefficients().size());
+    return true;
+}
+void Expression::estimate(const FixedFloat& x, const Context& ctx, std::vector<double>& vals, std::vector<double>& errs) const {
+    // the same bounds as error_bound, with the values of the registers taken as doubles
+    vals.assign(code.size(), 0);
+    errs.assign(code.size(), 0);
+    for (size_t i = 0; i < code.size(); i++) {
+        const Instr &ins = code[i];
+        if (ins.op == OpCode::CONST) {
+            vals[i] = ctx.regs[i].doubleValue();
+            errs[i] = literal_error(literals[ins.lhs], x.base);
+            continue;
+        }
+        if (ins.op == OpCode::VAR) {
+            vals[i] = x.doubleValue();
+            continue;
+        }
+        const double a = vals[ins.lhs], b = vals[ins.rhs], ea = errs[ins.lhs], eb = errs[ins.rhs];
+        switch (ins.op) {
+            case OpCode::ADD:
+                vals[i] = a + b;
+                errs[i] = ea + eb;
+                break;
+            case OpCode::SUB:
+                vals[i] = a - b;
+                errs[i] = ea + eb;
+                break;
+            case OpCode::MUL:
+                vals[i] = a * b;
+                errs[i] = std::fabs(a) * eb + std::fabs(b) * ea + 1;
+                break;
+            case OpCode::DIV:
+                vals[i] = a / b;
+                errs[i] = b == 0 ? INFINITY : (ea + std::fabs(a / b) * eb) / std::fabs(b) + 1;
+                break;
+            case OpCode::POW: {
+                const double n = code[ins.rhs].constant ? ctx.regs[ins.rhs].intValue() : std::trunc(b);
+                const double m = std::fabs(n), err = m * std::pow(std::max(1.0, std::fabs(a)), m - 1) * (ea + 2);
+                vals[i] = std::pow(a, n);
+                errs[i] = n == 0 ? 0 : n > 0 ? err : err / std::pow(a, 2 * m) + 1;
+                break;
+            }
+            default:
+                break;
+        }
+        if (ins.constant) vals[i] = ctx.regs[i].doubleValue();
+    }
+}
+bool Expression::use_horner(const FixedFloat& x, Context& ctx) const {
+    // every Horner step truncates once, and whatever error is left in the coefficient of x^k grows by |x|^k,
+    // while the bytecode only sees the cancellation the expression itself has
+    const double ax = std::fabs(x.doubleValue());
+    double horner = 0;
+    for (size_t k = ctx.poly_errs.size(); k-- > 0; ) horner = horner * ax + ctx.poly_errs[k] + 1;
+    // the scratch vectors keep their capacity across calls, so this allocates nothing once the context is warm
+    estimate(x, ctx, ctx.est_vals, ctx.est_errs);
+    return horner <= HORNER_ERROR_RATIO * (ctx.est_errs[result] + 1);
+}
+void Expression::prepare_lanes(const FixedFloat& x, Context& ctx) const {
+    prepare(x, ctx);
+    if (ctx.lanes_ready) return;
+    if (ctx.is_poly) {
+        for (const FixedFloat &coeff : ctx.poly.coefficients()) ctx.lanes.push_back(FixedFloatBatch::broadcast(coeff));
+    } else {
+        ctx.lanes.assign(code.size(), FixedFloatBatch(x));
+        for (size_t i = 0; i < code.size(); i++) {
+            if (code[i].constant) ctx.lanes[i] = FixedFloatBatch::broadcast(ctx.regs[i]);
+        }
+    }
+    ctx.lanes_ready = true;
+}
+void Expression::eval_lanes(const FixedFloat *xs, FixedFloat *out, Context& ctx) const {
+    const size_t L = FixedFloatBatch::LANES;
+    prepare_lanes(xs[0], ctx);
+    FixedFloatBatch x(xs[0]);
+    for (size_t l = 0; l < L; l++) x.set(l, xs[l]);
+    Profiler::Profile *profile = Profiler::active();
+    // each lane reports the effective digits of its own operands, like the same instruction run on that point alone
+    const auto digits = [&] (const FixedFloatBatch& b, uint64_t &sum) {
+        uint64_t longest = 0;
+        for (size_t l = 0; l < L; l++) {
+            const uint64_t d = b.effectiveDigits(l);
+            sum += d;
+            longest = std::max(longest, d);
+        }
+        return longest;
+    };
+    if (ctx.is_poly) {
+        // the lanes only hold the coefficients, points that need the bytecode are evaluated one by one
+        if (!std::all_of(xs, xs + L, [&] (const FixedFloat& p) { return use_horner(p, ctx); })) {
+            for (size_t l = 0; l < L; l++) out[l] = eval(xs[l], ctx);
+            return;
+        }
+        std::optional<Profiler::Timer> timer;
+        if (profile) {
+            uint64_t sum = 0;
+            const uint64_t longest = digits(x, sum);
+            timer.emplace(profile, Profiler::Op::HORNER, result, L, longest, 0, sum);
+        }
+        // the same Horner steps as Polynomial::eval, on every lane at once
+        FixedFloatBatch ret = ctx.lanes.back();
+        for (size_t i = ctx.lanes.size() - 1; i > 0; i--) {
+            ret *= x;
+            ret += ctx.lanes[i - 1];
+        }
+        for (size_t l = 0; l < L; l++) out[l] = ret.get(l);
+        return;
+    }
+    std::vector<FixedFloatBatch> &regs = ctx.lanes;
+    for (size_t i = 0; i < code.size(); i++) {
+        const Instr &ins = code[i];
+        if (ins.constant) continue;
+        std::optional<Profiler::Timer> timer;
+        if (profile && ins.op <= OpCode::MUL) {
+            uint64_t sum = 0;
+            if (ins.op == OpCode::VAR) {
+                const uint64_t longest = digits(x, sum);
+                timer.emplace(profile, Profiler::Op::VAR, (uint32_t) i, L, longest, 0, sum);
+            } else {
+                const uint64_t lhs = digits(regs[ins.lhs], sum), rhs = digits(regs[ins.rhs], sum);
+                timer.emplace(profile, (Profiler::Op) ins.op, (uint32_t) i, L, lhs, rhs, sum);
+            }
+        }
+        switch (ins.op) {
+            case OpCode::VAR:
+                regs[i] = x;
+                break;
+            case OpCode::ADD:
+                regs[i] = regs[ins.lhs];
+                regs[i] += regs[ins.rhs];
+                break;
+            case OpCode::SUB:
+                regs[i] = regs[ins.lhs];
+                regs[i] -= regs[ins.rhs];
+                break;
+            case OpCode::MUL:
+                regs[i] = regs[ins.lhs];
+                regs[i] *= regs[ins.rhs];
+                break;
             default: {
-                stack.push(FixedFloat(10, x.int_digit_len, x.dec_digit_len, ele));
+                // division and powers have no lane kernels, run them lane by lane through the scalar registers
+                for (size_t l = 0; l < L; l++) {
+                    ctx.regs[ins.lhs] = regs[ins.lhs].get(l);
+                    ctx.regs[ins.rhs] = regs[ins.rhs].get(l);
+                    exec(i, xs[l], ctx);
+                    regs[i].set(l, ctx.regs[i]);
+                }
                 break;
             }
-        
         }
     }
-    if (stack.size() != 1) {
-        throw std::runtime_error("invalid expression");
+    for (size_t l = 0; l < L; l++) out[l] = regs[result].get(l);
+}
+std::vector<FixedFloat> Expression::evalBatch(std::span<const FixedFloat> xs, ThreadPool& pool) const {
+    std::vector<FixedFloat> ret(xs.begin(), xs.end());
+    if (xs.empty()) return ret;
+    // short numbers are evaluated LANES points at a time, with every point in one lane of a FixedFloatBatch
+    const size_t L = FixedFloatBatch::LANES;
+    const bool lanes = xs[0].len <= FixedFloatBatch::MAX_LIMBS;
+    // prepare once in the default context, which keeps it across calls, and hand a copy to each thread
+    Context master;
+    {
+        std::lock_guard<std::mutex> lock(context_mutex);
+        if (lanes) prepare_lanes(xs[0], context);
+        else prepare(xs[0], context);
+        master = context;
     }
-    return stack.top();
-}
\ No newline at end of file
+    const bool same_format = std::all_of(xs.begin(), xs.end(), [&] (const FixedFloat& x) {
+        return x.base == xs[0].base && x.int_digit_len == xs[0].int_digit_len && x.dec_digit_len == xs[0].dec_digit_len;
+    });
+    // long polynomials at many long points are evaluated degree + 1 points at a time by a remainder tree
+    const size_t block = master.is_poly ? master.poly.degree() + 1 : 0;
+    bool multipoint = false;
+    if (!lanes && same_format && block > MULTIPOINT_MIN_DEGREE && xs.size() >= block) {
+        double radius = 0;
+        for (const FixedFloat &x : xs) radius = std::max(radius, std::fabs(x.doubleValue()));
+        multipoint = useMultipoint(block - 1, block, xs[0].int_digit_len + xs[0].dec_digit_len, radius, xs[0].base);
+    }
+    // one context per thread number, parallelFor never runs two chunks of this call under the same number
+    std::vector<Context> ctxs(pool.size() + 1);
+    // the workers record into the profile of the calling thread
+    Profiler::Profile *profile = Profiler::active();
+    // the constant is copied, std::max takes references, which would need an out-of-line definition
+    const size_t grain = multipoint ? block : lanes ? std::max((size_t) BATCH_GRAIN, L) : BATCH_GRAIN;
+    pool.parallelFor(xs.size(), grain, [&] (size_t begin, size_t end, size_t thread) {
+        Profiler::Scope scope(profile);
+        Context &ctx = ctxs[thread];
+        if (!ctx.ready) ctx = master;
+        size_t i = begin;
+        if (lanes && same_format) {
+            for (; i + L <= end; i += L) eval_lanes(xs.data() + i, ret.data() + i, ctx);
+        }
+        if (multipoint) {
+            for (; i + block <= end; i += block) eval_multipoint(xs.data() + i, block, ret.data() + i, ctx);
+        }
+        for (; i < end; i++) ret[i] = eval(xs[i], ctx);
+    });
+    return ret;
+}
+void Expression::eval_multipoint(const FixedFloat *xs, size_t n, FixedFloat *out, Context& ctx) const {
+    prepare(xs[0], ctx);
+    // the tree evaluates the same expanded coefficients, so points where their errors grow too much still take the bytecode
+    std::vector<size_t> picked;
+    std::vector<FixedFloat> points;
+    uint64_t digits = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (!use_horner(xs[i], ctx)) {
+            out[i] = eval(xs[i], ctx);
+            continue;
+        }
+        picked.push_back(i);
+        points.push_back(xs[i]);
+        digits = std::max(digits, effective_digits(xs[i]));
+    }
+    if (points.empty()) return;
+    std::optional<Profiler::Timer> timer;
+    if (Profiler::Profile *profile = Profiler::active()) timer.emplace(profile, Profiler::Op::MULTIPOINT, result, points.size(), digits, 0);
+    std::vector<FixedFloat> values = ctx.poly.evalMultipoint(points);
+    for (size_t j = 0; j < picked.size(); j++) out[picked[j]] = std::move(values[j]);
+}
+bool Expression::useMultipoint(size_t degree, size_t points, uint64_t digits, double radius, uint16_t base) {
+    // the tree costs a constant number of polynomial products per level, against points * degree products for Horner;
+    // the guard digits it needs grow with the degree, and once they outnumber the digits of x it no longer pays
+    if (degree < MULTIPOINT_MIN_DEGREE || points < degree + 1 || digits < MULTIPOINT_MIN_DIGITS) return false;
+    return Polynomial::multipointGuard(degree, degree + 1, radius, base) <= digits;
+}
+bool Expression::toPolynomial(const FixedFloat& like, Polynomial& out) const {
+    Context ctx;
+    prepare(like, ctx);
+    if (!ctx.is_poly) return false;
+    out = std::move(ctx.poly);
+    return true;
+}
+FixedFloat Expression::eval(const FixedFloat& x) const {
+    std::lock_guard<std::mutex> lock(context_mutex);
+    return eval(x, context);
+}
+FixedFloat Expression::eval(const FixedFloat& x, Context& ctx) const {
+    prepare(x, ctx);
+    if (ctx.is_poly && use_horner(x, ctx)) {
+        std::optional<Profiler::Timer> timer;
+        if (Profiler::Profile *profile = Profiler::active()) timer.emplace(profile, Profiler::Op::HORNER, result, 1, effective_digits(x), 0);
+        return ctx.poly.eval(x);
+    }
+    for (size_t i = 0; i < code.size(); i++) {
+        if (!code[i].constant) exec(i, x, ctx);
+    }
+    return ctx.regs[result];
+}
+Expression::Adaptive Expression::evalAdaptive(const FixedFloat& x, uint64_t digits, uint64_t max_digits) const {
+    std::lock_guard<std::mutex> lock(context_mutex);
+    return evalAdaptive(x, digits, context, max_digits);
+}
+Expression::Adaptive Expression::evalAdaptive(const FixedFloat& x, uint64_t digits, Context& ctx, uint64_t max_digits) const {
+    const double log_base = std::log2((double) x.base);
+    const uint32_t guard = (uint32_t) std::ceil(ADAPTIVE_GUARD_BITS / log_base);
+    // the caller's cap bounds every evaluation, so a result that can not be settled fails instead of growing without end
+    const uint64_t cap = std::min(max_digits, FixedFloat::MAX_DIGIT_LEN);
+    if (x.int_digit_len > cap || digits > cap - x.int_digit_len) throw std::runtime_error("precision limit reached");
+    const uint64_t limit = std::min(std::max((uint64_t) ADAPTIVE_MAX_DIGITS, digits + guard), cap - x.int_digit_len);
+    uint64_t dec = std::min<uint64_t>(digits + guard, limit);
+    for (uint32_t rounds = 1; ; rounds++) {
+        const FixedFloat xw = x.convertTo(x.base, x.int_digit_len, dec);
+        prepare(xw, ctx, true);
+        // an ulp below the smallest double is rounded up, which only loosens the bounds
+        const double ulp = std::max(std::pow((double) x.base, -(double) dec), DBL_MIN);
+        const double var_err = x.dec_digit_len > dec ? 1 : 0;
+        bool unsettled = false;
+        for (size_t i = 0; i < code.size() && !unsettled; i++) {
+            // a divisor that is 0 only at this precision needs more digits, not an exception
+            const Instr &ins = code[i];
+            const bool inverts = ins.op == OpCode::DIV || (ins.op == OpCode::POW && ctx.regs[ins.rhs].intValue() < 0);
+            const uint32_t divisor = ins.op == OpCode::DIV ? ins.rhs : ins.lhs;
+            if (!ins.constant && inverts && ctx.regs[divisor].isZero() && ctx.errs[divisor] > 0) {
+                unsettled = true;
+                break;
+            }
+            if (!ins.constant) exec(i, xw, ctx);
+            ctx.errs[i] = error_bound(i, xw, ctx, ulp, var_err);
+        }
+        // the answer is settled once the error is below half a unit of the last requested digit
+        const double err = unsettled ? INFINITY : ctx.errs[result];
+        const double spare = (dec - digits) * log_base; // log2 of base^(dec - digits)
+        if (err == 0 || std::log2(2 * err) < spare) {
+            const FixedFloat &v = ctx.regs[result];
+            FixedFloat ret = v.convertTo(x.base, x.int_digit_len, digits);
+            // round to the nearest digit instead of truncating, so the total error stays below one unit
+            std::string unit_str = digits ? "0." + std::string(digits - 1, '0') + "1" : "1";
+            const FixedFloat unit(x.base, x.int_digit_len, digits, unit_str);
+            FixedFloat rest = v - ret.convertTo(x.base, x.int_digit_len, dec);
+            rest += rest;
+            if (!(rest.compare_abs(unit.convertTo(x.base, x.int_digit_len, dec)) < 0)) {
+                if (v.sign) ret -= unit;
+                else ret += unit;
+            }
+            return Adaptive{std::move(ret), dec, rounds};
+        }
+        if (dec == limit) throw std::runtime_error("precision limit reached");
+        // aim for the digits the bound says are missing, but at least double the guard digits
+        uint64_t next = dec + (dec - digits);
+        if (std::isfinite(err)) next = std::max<uint64_t>(next, digits + guard + (uint64_t) std::ceil(std::log2(2 * err) / log_base));
+        dec = std::min(next, limit);
+    }
+}
+size_t Expression::instructionCount() const {
+    return std::count_if(code.begin(), code.end(), [] (const Instr& ins) { return !ins.constant; });
+}
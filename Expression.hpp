@@ -7,12 +7,118 @@
 #include <queue>
 #include <stdexcept>
 #include <functional>
+#include <vector>
+#include <mutex>
+#include <span>
 #include "FixedFloat.hpp"
+#include "Polynomial.hpp"
+#include "FixedFloatBatch.hpp"
+#include "ThreadPool.hpp"
 
 class Expression {
+    public:
+        // 字节码的操作码
+        enum class OpCode : uint8_t { CONST, VAR, ADD, SUB, MUL, DIV, POW };
+        // 一条指令，结果写入与指令同下标的寄存器
+        // CONST 的 lhs 为字面量下标，其余运算的 lhs, rhs 为左右操作数所在的寄存器
+        struct Instr {
+            OpCode op;
+            bool constant; // 只依赖字面量，每种格式只计算一次
+            uint32_t lhs;
+            uint32_t rhs;
+        };
+        // 求值时使用的缓冲区，按 x 的格式算好的常量和其余寄存器，可在多次求值之间复用
+        class Context {
+            private:
+                friend class Expression;
+                bool ready = false;
+                uint16_t base = 0;
+                uint64_t int_digit_len = 0;
+                uint64_t dec_digit_len = 0;
+                std::vector<FixedFloat> regs;
+                // 表达式是多项式时，按当前格式展开后的系数
+                bool is_poly = false;
+                Polynomial poly;
+                // 展开后每个系数的误差上界，单位与 errs 相同，用于估计 Horner 法则在给定 x 处的误差
+                std::vector<double> poly_errs;
+                // use_horner 估计字节码误差时使用的缓冲区，求值时不再分配
+                std::vector<double> est_vals;
+                std::vector<double> est_errs;
+                // 自适应求值时不展开多项式，逐条执行字节码并记录每个寄存器的误差上界，单位为 base^-dec_digit_len
+                bool tracked = false;
+                std::vector<double> errs;
+                // 按 lane 同步求值时广播到所有 lane 的常量：多项式的系数，或者字节码的寄存器
+                bool lanes_ready = false;
+                std::vector<FixedFloatBatch> lanes;
+        };
+        // 自适应精度求值的结果
+        struct Adaptive {
+            FixedFloat value;    // 保留 digits 位小数，与真值之差小于 base^-digits
+            uint64_t precision;  // 最后一次求值使用的小数位数
+            uint32_t rounds;     // 求值的次数
+        };
+        // 展开为多项式时允许的最高次数，超过时退回逐条执行字节码
+        static const size_t MAX_POLY_DEGREE = 4096;
+        // 批量求值时每个任务至少处理的 x 的个数
+        static const size_t BATCH_GRAIN = 16;
+        // 指数为小于该值的整数字面量时，x^k 展开为与 FixedFloat::pow 相同的平方乘链，中间的幂可以共享
+        static const uint32_t MAX_CHAIN_EXPONENT = 256;
+        // Horner 法则的误差上界超过逐条执行字节码的该倍数时，这个 x 改为执行字节码
+        static const uint32_t HORNER_ERROR_RATIO = 1024;
+        // 多项式的次数和 x 的总位数都不低于这两个值时，批量求值每 degree + 1 个点用一次子积树和余式树
+        static const size_t MULTIPOINT_MIN_DEGREE = 128;
+        static const uint64_t MULTIPOINT_MIN_DIGITS = 4000;
+        // 自适应求值时在所需位数之外多算的保护位，以二进制位计
+        static const uint32_t ADAPTIVE_GUARD_BITS = 24;
+        // 自适应求值提高精度的上限，所需位数更多时以所需位数加保护位为上限
+        static const uint64_t ADAPTIVE_MAX_DIGITS = (uint64_t) 1 << 22;
     private:
-        // 经过解析后的后缀表达式
-        std::queue<std::string> expr;
+        friend class Serializer;
+        struct Builder;
+        // 按拓扑序排列的表达式 DAG，相同的子表达式只出现一次
+        std::vector<Instr> code;
+        // 表达式中的数字字面量，以十进制字符串保存
+        std::vector<std::string> literals;
+        // 结果所在的寄存器
+        uint32_t result = 0;
+        // 不传入 Context 时使用的默认缓冲区
+        mutable Context context;
+        mutable std::mutex context_mutex;
+        // 由已经编译好的字节码构造，供 Serializer 读取时使用，调用者负责检查字节码
+        Expression(std::vector<Instr> code, std::vector<std::string> literals, uint32_t result);
+        // 生成一个节点，与已有节点相同时直接复用
+        void emit_num(Builder& b, const std::string& num);
+        void emit_var(Builder& b);
+        void emit_op(Builder& b, const char c);
+        uint32_t make_node(Builder& b, OpCode op, uint32_t lhs, uint32_t rhs);
+        // 删除结果用不到的节点
+        void prune();
+        // 最高与最低的非零数字之间的位数，即运算实际处理的位数，为 0 时返回 0
+        static uint64_t effective_digits(const FixedFloat& f);
+        // 以 f 的基数为底的 log|f|，由最高的两个 limb 算出，为 0 时返回 -inf
+        static double log_magnitude(const FixedFloat& f);
+        // 执行第 i 条指令，当前线程开启了 Profiler 时记录耗时
+        void exec(size_t i, const FixedFloat& x, Context& ctx) const;
+        // 在 prepare 之外把常量广播到 ctx.lanes
+        void prepare_lanes(const FixedFloat& x, Context& ctx) const;
+        // 把 xs 中的 FixedFloatBatch::LANES 个点按 lane 同步求值，结果写入 out
+        void eval_lanes(const FixedFloat *xs, FixedFloat *out, Context& ctx) const;
+        // 按 x 的格式计算常量并分配寄存器，如果表达式是多项式且不需要跟踪误差则同时展开
+        void prepare(const FixedFloat& x, Context& ctx, bool tracked = false) const;
+        // 由操作数的误差上界推出第 i 个寄存器的误差上界，ulp 为当前格式的最低位，var_err 为 x 本身的误差
+        // 结果超出格式的整数部分时抛出 overflow 异常
+        double error_bound(size_t i, const FixedFloat& x, const Context& ctx, double ulp, double var_err) const;
+        // 在多一位整数的格式中重新执行第 i 条指令，判断其结果是否超出 ctx 中寄存器的整数部分
+        bool overflows(size_t i, const Context& ctx) const;
+        // 用 ctx 中的常量把 DAG 符号执行为多项式，errs 为每个系数的误差上界
+        // 不是多项式，或者系数的上界超出格式的整数部分时返回 false
+        bool expand(const FixedFloat& x, const Context& ctx, Polynomial& out, std::vector<double>& errs) const;
+        // 用 double 估计逐条执行字节码时每个寄存器的值和误差上界，不检查溢出
+        void estimate(const FixedFloat& x, const Context& ctx, std::vector<double>& vals, std::vector<double>& errs) const;
+        // 展开后的多项式在 x 处相消过多，Horner 法则的误差明显大于字节码时返回 false
+        bool use_horner(const FixedFloat& x, Context& ctx) const;
+        // 把 xs 中的 n 个点一起用子积树求值，结果写入 out，Horner 法则误差过大的点改为逐个求值
+        void eval_multipoint(const FixedFloat *xs, size_t n, FixedFloat *out, Context& ctx) const;
         // 获取运算符的优先级，比如 + - 为 1，* / 为 2，^ 为 3，优先级越高越先计算
         uint32_t get_priority(const char c) const;
         // 判断字符是否为数字
@@ -32,8 +138,25 @@ class Expression {
     public:
         // 通过输入的中缀表达式构造一个 Expression
         Expression(const std::string& input);
-        // 给定一个 x，计算表达式的值
-        FixedFloat eval(FixedFloat x) const;
+        // 给定一个 x，计算表达式的值，表达式是多项式时使用 Horner 法则
+        FixedFloat eval(const FixedFloat& x) const;
+        // 给定一个 x，使用调用者提供的缓冲区计算表达式的值，不同线程应使用不同的 Context
+        FixedFloat eval(const FixedFloat& x, Context& ctx) const;
+        // 对一批 x 并行求值，结果与输入的顺序相同，每个线程使用自己的 Context
+        // 精度不高时每个线程再把 FixedFloatBatch::LANES 个点放进一个 FixedFloatBatch 同步求值，
+        // 次数和精度都高的多项式由 useMultipoint 决定是否改用子积树，结果可能与 eval 在最后一位不同
+        std::vector<FixedFloat> evalBatch(std::span<const FixedFloat> xs, ThreadPool& pool = ThreadPool::shared()) const;
+        // 求出与真值之差小于 base^-digits 的结果，x 视为精确值，结果的基数和整数位数与 x 相同
+        // 先用略多于 digits 位的小数求值并跟踪误差上界，误差不足以确定结果时才提高精度重新求值
+        // 求值格式的整数位数与小数位数之和不超过 max_digits，到达上限仍不能确定结果时抛出 precision limit reached
+        Adaptive evalAdaptive(const FixedFloat& x, uint64_t digits, uint64_t max_digits = FixedFloat::MAX_DIGIT_LEN) const;
+        Adaptive evalAdaptive(const FixedFloat& x, uint64_t digits, Context& ctx, uint64_t max_digits = FixedFloat::MAX_DIGIT_LEN) const;
+        // 按 like 的格式把表达式展开为多项式，不是多项式时返回 false
+        bool toPolynomial(const FixedFloat& like, Polynomial& out) const;
+        // 次数为 degree 的多项式在 points 个绝对值不超过 radius、总位数为 digits 的点上求值时，子积树是否快于逐点 Horner
+        static bool useMultipoint(size_t degree, size_t points, uint64_t digits, double radius, uint16_t base);
+        // 每次求值需要执行的指令数，不包括常量
+        size_t instructionCount() const;
 };
 
 #endif
\ No newline at end of file
@@ -1,85 +1,134 @@
 #include "FixedFloat.hpp"
+#include "LimbArith.hpp"
+#include "Multiplier.hpp"
+#include "Divider.hpp"
+#include "BaseConverter.hpp"
+#include "LimbAllocator.hpp"
 
 #include <stdexcept>
-#include <functional>
 #include <iostream>
-
-uint32_t FixedFloat::read_n_bit(uint16_t i, uint16_t n) const {
-    if (n > 32) n = 32; // 位数不超过 32
-    if (i >= this->bit_len) return 0; // 超过最大位数
-    uint16_t h = i >> 5; // 32 位的 uint32_t 数组下标
-    uint16_t l = i & 31; // 32 位的 uint32_t 中的第几位
-    uint32_t ret = 0;
-    if (l + n <= 32) { // 位数不跨两个 uint32_t
-        ret = (this->arr[h] >> l) & (((uint64_t) 1 << n) - 1);
-    } else { // 位数跨两个 uint32_t
-        ret = (this->arr[h] >> l) & (((uint64_t) 1 << (32 - l)) - 1);
-        ret |= (this->arr[h + 1] & ((uint64_t) (1 << (n + l - 32)) - 1)) << (32 - l);
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <array>
+
+uint32_t FixedFloat::read_digit(uint64_t i) const {
+    if (i >= int_digit_len + dec_digit_len) return 0; // 超过最大位数
+    uint64_t pos = i + pad_digit_len;
+    uint32_t val = arr[pos / digit_per_limb];
+    for (uint32_t j = pos % digit_per_limb; j > 0; j--) val /= base;
+    return val % base;
+}
+uint32_t FixedFloat::write_digit(uint64_t i, uint32_t val) {
+    if (i >= int_digit_len + dec_digit_len) return 0; // 超过最大位数
+    val %= base;
+    uint64_t pos = i + pad_digit_len;
+    uint64_t unit = 1;
+    for (uint32_t j = pos % digit_per_limb; j > 0; j--) unit *= base;
+    uint32_t &limb = arr[pos / digit_per_limb];
+    uint32_t old = (uint32_t) (limb / unit % base);
+    limb = (uint32_t) (limb - old * unit + val * unit);
+    return val;
+}
+std::vector<uint16_t> FixedFloat::unpack_digits() const {
+    // every limb holds digit_per_limb digits, the lowest pad_digit_len ones are padding
+    std::vector<uint16_t> digits(len * digit_per_limb);
+    for (uint64_t i = 0; i < len; i++) {
+        uint32_t val = arr[i];
+        for (uint16_t j = 0; j < digit_per_limb; j++) {
+            digits[i * digit_per_limb + j] = val % base;
+            val /= base;
+        }
     }
-    return ret;
+    digits.erase(digits.begin(), digits.begin() + pad_digit_len);
+    digits.resize(int_digit_len + dec_digit_len);
+    return digits;
 }
-uint32_t FixedFloat::write_n_bit(uint16_t i, uint16_t n, uint32_t val) {
-    if (n > 32) n = 32; // 位数不超过 32
-    if (i >= this->bit_len) return 0; // 超过最大位数
-    val &= ((uint64_t) 1 << n) - 1; // 只取 n 位
-    uint16_t h = i >> 5; // 32 位的 uint32_t 数组下标
-    uint16_t l = i & 31; // 32 位的 uint32_t 中的第几位
-    if (l + n <= 32) { // 位数不跨两个 uint32_t
-        this->arr[h] &= ~((((uint64_t) 1 << n) - 1) << l);
-        this->arr[h] |= val << l;
-    } else { // 位数跨两个 uint32_t
-        this->arr[h] &= ((uint64_t) 1 << l) - 1;
-        this->arr[h] |= val << l;
-        this->arr[h + 1] &= ~(((uint64_t) 1 << (n + l - 32)) - 1);
-        this->arr[h + 1] |= val >> (32 - l);
+void FixedFloat::pack_digits(const uint16_t *digits) {
+    for (int64_t i = len - 1; i >= 0; i--) {
+        uint64_t val = 0;
+        for (int64_t j = digit_per_limb - 1; j >= 0; j--) {
+            int64_t k = i * digit_per_limb + j - pad_digit_len;
+            val = val * base + (k >= 0 && (uint64_t) k < int_digit_len + dec_digit_len ? digits[k] : 0);
+        }
+        arr[i] = (uint32_t) val;
     }
-    return val;
 }
-uint32_t FixedFloat::read_digit(uint16_t i) const {
-    return read_n_bit(i * bit_per_digit, bit_per_digit); // 读取第 i 位数字
+uint64_t FixedFloat::least_significant_digit() const {
+    if (is_zero()) return int_digit_len + dec_digit_len; // 如果都是 0，则返回最大位数
+    uint32_t val = arr[lo_limb]; // 第一个非零的 limb
+    uint64_t pos = lo_limb * digit_per_limb;
+    if (!(base & (base - 1))) { // 2 的幂的基数，每个数字正好是若干个二进制位
+        pos += __builtin_ctz(val) / __builtin_ctz(base);
+    } else {
+        while (val % base == 0) { // 找到 limb 中第一个非零的数字
+            val /= base;
+            pos++;
+        }
+    }
+    return pos - pad_digit_len;
 }
-uint32_t FixedFloat::write_digit(uint16_t i, uint32_t val) {
-    return write_n_bit(i * bit_per_digit, bit_per_digit, val); // 写入第 i 位数字
+void FixedFloat::normalize() {
+    normalize(0, len);
 }
-uint16_t FixedFloat::least_significant_bit() const {
-    uint16_t i = 0;
-    for (i = 0; i < len; i++) // 找到第一个非零的 uint32_t
-        if (arr[i]) break;
-    if (i == len) return bit_len; // 如果都是 0，则返回最大位数
-    for (uint16_t j = i * 32; j < (i + 1) * 32; j++) // 找到第一个非零的 bit
-        if (read_n_bit(j, 1))
-            return j;
-    return bit_len;
+void FixedFloat::normalize(uint64_t lo, uint64_t hi) {
+    arr[0] -= arr[0] % low_unit;
+    if (top_unit != limb_base) arr[len - 1] %= top_unit;
+    // shrink the window to its nonzero limbs, which costs nothing for dense values
+    while (lo < hi && !arr[lo]) lo++;
+    while (hi > lo && !arr[hi - 1]) hi--;
+    if (lo == hi) {
+        lo = hi = 0;
+        sign = false; // if all digits are 0, then it is positive
+    }
+    lo_limb = lo;
+    hi_limb = hi;
 }
-uint16_t FixedFloat::least_significant_digit() const{
-    return least_significant_bit() / bit_per_digit; // 最低有效数字，即最低有效位对应的数字
+int FixedFloat::compare_abs(const FixedFloat& other) const {
+    // the one with more nonzero limbs is larger, otherwise only the limbs above the lower window matter
+    if (hi_limb != other.hi_limb) return hi_limb < other.hi_limb ? -1 : 1;
+    const uint64_t lo = std::min(lo_limb, other.lo_limb);
+    return LimbArith::compare(arr + lo, other.arr + lo, hi_limb - lo);
 }
 void FixedFloat::clear_int() {
-    for (uint16_t i = 0; i < int_digit_len; i++) {
-        write_digit(dec_digit_len + i, 0);
+    for (uint64_t i = dec_limb_len; i < len; i++) {
+        arr[i] = 0;
     }
+    normalize(lo_limb, std::min(hi_limb, dec_limb_len));
 }
 void FixedFloat::clear_dec() {
-    for (uint16_t i = 0; i < dec_digit_len; i++) {
-        write_digit(i, 0);
+    for (uint64_t i = 0; i < dec_limb_len; i++) {
+        arr[i] = 0;
     }
-}
-bool FixedFloat::is_zero() const{
-    return least_significant_bit() == bit_len; // 最低有效位为最大位数，则为 0
+    normalize(std::max(lo_limb, dec_limb_len), hi_limb);
 }
 
-FixedFloat::FixedFloat(uint16_t base, uint16_t int_digit_len, uint16_t dec_digit_len): 
+FixedFloat::FixedFloat(uint16_t base, uint64_t int_digit_len, uint64_t dec_digit_len):
                         base(base),
                         int_digit_len(int_digit_len),
-                        dec_digit_len(dec_digit_len), 
-                        bit_per_digit(ceil(log2(base))), // 根据基数计算每个数字占用的最低 bit 数
-                        bit_len((int_digit_len + dec_digit_len) * bit_per_digit),
-                        len((bit_len + 31) >> 5) {
-    this->arr = (uint32_t *) calloc(this->len, 32);
+                        dec_digit_len(dec_digit_len) {
+    if (base < 2) throw std::runtime_error("base should be at least 2");
+    if (int_digit_len > MAX_DIGIT_LEN || dec_digit_len > MAX_DIGIT_LEN - int_digit_len) throw std::runtime_error("precision too large");
+    // 根据基数计算每个 limb 能存放的最多数字个数
+    digit_per_limb = 0;
+    limb_base = 1;
+    while (limb_base * base <= ((uint64_t) 1 << 32)) {
+        limb_base *= base;
+        digit_per_limb++;
+    }
+    dec_limb_len = (dec_digit_len + digit_per_limb - 1) / digit_per_limb;
+    pad_digit_len = dec_limb_len * digit_per_limb - dec_digit_len;
+    len = dec_limb_len + (int_digit_len + digit_per_limb - 1) / digit_per_limb;
+    if (len == 0) len = 1; // 至少分配一个 limb，此时它只能为 0
+    low_unit = 1;
+    for (uint16_t i = 0; i < pad_digit_len; i++) low_unit *= base;
+    top_unit = 1;
+    for (int64_t i = pad_digit_len + int_digit_len + dec_digit_len - (len - 1) * digit_per_limb; i > 0; i--) top_unit *= base;
+    this->arr = LimbAllocator::allocate(this->len);
 }
-FixedFloat::FixedFloat(uint16_t base, uint16_t int_digit_len, uint16_t dec_digit_len, double d): FixedFloat(base, int_digit_len, dec_digit_len) {
+FixedFloat::FixedFloat(uint16_t base, uint64_t int_digit_len, uint64_t dec_digit_len, double d): FixedFloat(base, int_digit_len, dec_digit_len) {
     // 输入的数字超过了最大值或最小值，则取最大值或最小值
-    const double MAX_VALUE = pow(base, int_digit_len) - 1;
+    const double MAX_VALUE = std::pow(base, int_digit_len) - 1;
     if (d > MAX_VALUE) d = MAX_VALUE;
     else if (d < -MAX_VALUE) d = -MAX_VALUE;
 
@@ -90,146 +139,183 @@ FixedFloat::FixedFloat(uint16_t base, uint16_t int_digit_len, uint16_t dec_digit
     }
 
     // write integer part
-    uint32_t i = (uint32_t) d;
+    double i = floor(d);
     d -= i;
-    for (uint16_t j = 0; j < int_digit_len && i; j++) {
-        write_digit(dec_digit_len + j, i % base);
-        i /= base;
+    for (uint64_t j = 0; j < int_digit_len && i > 0; j++) {
+        write_digit(dec_digit_len + j, (uint32_t) fmod(i, base));
+        i = floor(i / base);
     }
 
     // write decimal part
-    for (uint16_t j = 0; j < dec_digit_len && d; j++) {
+    for (uint64_t j = 0; j < dec_digit_len && d; j++) {
         d *= base;
-        i = (uint32_t) d;
-        write_digit(dec_digit_len - j - 1, i);
-        d -= i;
+        uint32_t val = (uint32_t) d;
+        write_digit(dec_digit_len - j - 1, val);
+        d -= val;
     }
 
-    if (is_zero()) sign = false; // if all digits are 0, then it is positive
+    normalize();
 }
 
-FixedFloat::FixedFloat(uint16_t base, uint16_t int_digit_len, uint16_t dec_digit_len, const std::string &str): FixedFloat(base, int_digit_len, dec_digit_len) {
+// the value of every character, letters of either case count from 10 and any other character wraps like the subtraction does
+static const std::array<uint32_t, 256> CHAR_VALUES = [] {
+    std::array<uint32_t, 256> ret{};
+    for (uint32_t c = 0; c < 256; c++) {
+        const char ch = (char) c;
+        ret[c] = ch >= '0' && ch <= '9' ? ch - '0' : ch >= 'a' && ch <= 'z' ? ch - 'a' + 10 : ch - 'A' + 10;
+    }
+    return ret;
+}();
+
+FixedFloat::FixedFloat(uint16_t base, uint64_t int_digit_len, uint64_t dec_digit_len, std::string_view str): FixedFloat(base, int_digit_len, dec_digit_len) {
     if (base > 36) throw std::runtime_error("base should be less than 36");
-    int16_t i = 0; // i is the first number character
-    uint32_t size = str.size();
-    const std::function<uint32_t(char)> ctoi = [] (char c) {
-        return c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'z' ? c - 'a' + 10 : c - 'A' + 10;
-    };
-    
+    size_t i = 0; // i is the first number character
+    size_t size = str.size();
+
     // trim leading and trailing spaces
     while (i < size && str[i] == ' ') i++;
     while (size > 0 && str[size - 1] == ' ') size--;
 
     // judge sign
-    if (str[i] == '-') {
+    if (i < size && str[i] == '-') {
         sign = true;
         i++;
-    } else if (str[i] == '+') {
+    } else if (i < size && str[i] == '+') {
         i++;
     }
     // skip leading zeros
-    while (str[i] == '0' && i < size) i++;
+    while (i < size && str[i] == '0') i++;
     // if all 0 or empty then return
-    if (i == size) return;
+    if (i >= size) {
+        sign = false;
+        return;
+    }
 
     // find decimal point
     size_t dot = str.find('.');
     // if not found
-    if (dot == std::string::npos) 
+    if (dot == std::string_view::npos)
         dot = size;
-    // parse integer part
-    for (int16_t j = 0; j < dot - i && j < int_digit_len; j++) {
-        write_digit(dec_digit_len + j, ctoi(str[dot - 1 - j]));
-    }
-
-    // if there isn't decimal point then return
-    if (dot == size) return;
-    // parse decimal part
-    for (int16_t j = 0; j < size - dot - 1 && j < dec_digit_len; j++) {
-        write_digit(dec_digit_len - j - 1, ctoi(str[dot + 1 + j]));
+    // the integer digits are str[i, dot) and the decimal digits str[dot + 1, size), both cut to the format
+    const uint64_t int_n = dot > i ? std::min<uint64_t>(dot - i, int_digit_len) : 0;
+    const uint64_t dec_n = size > dot + 1 ? std::min<uint64_t>(size - dot - 1, dec_digit_len) : 0;
+    const auto value = [base] (char c) {
+        const uint32_t d = CHAR_VALUES[(unsigned char) c];
+        return d < base ? d : d % base;
+    };
+    // digit k, where 0 is the lowest decimal digit
+    const auto digit = [&] (uint64_t k) -> uint32_t {
+        if (k < dec_digit_len) {
+            const uint64_t j = dec_digit_len - 1 - k;
+            return j < dec_n ? value(str[dot + 1 + j]) : 0;
+        }
+        const uint64_t j = k - dec_digit_len;
+        return j < int_n ? value(str[dot - 1 - j]) : 0;
+    };
+    // only the limbs holding the given digits are built, each one by a single pass over its digits
+    const uint64_t lo = (dec_digit_len - dec_n + pad_digit_len) / digit_per_limb;
+    const uint64_t hi = std::min<uint64_t>((dec_digit_len + int_n + pad_digit_len + digit_per_limb - 1) / digit_per_limb, len);
+    for (uint64_t l = lo; l < hi; l++) {
+        uint64_t val = 0;
+        for (int64_t j = digit_per_limb - 1; j >= 0; j--) {
+            const int64_t k = (int64_t) (l * digit_per_limb) + j - pad_digit_len;
+            val = val * base + (k >= 0 ? digit((uint64_t) k) : 0);
+        }
+        arr[l] = (uint32_t) val;
     }
 
-    if (is_zero()) sign = false; // if all digits are 0, then it is positive
+    normalize(lo, hi);
 }
 
 // copy constructor
-FixedFloat::FixedFloat(const FixedFloat &f) {
+void FixedFloat::copy_format(const FixedFloat &f) {
     this->sign = f.sign;
     this->base = f.base;
     this->int_digit_len = f.int_digit_len;
     this->dec_digit_len = f.dec_digit_len;
-    this->bit_per_digit = f.bit_per_digit;
-    this->bit_len = f.bit_len;
+    this->digit_per_limb = f.digit_per_limb;
+    this->limb_base = f.limb_base;
+    this->dec_limb_len = f.dec_limb_len;
+    this->pad_digit_len = f.pad_digit_len;
+    this->low_unit = f.low_unit;
+    this->top_unit = f.top_unit;
     this->len = f.len;
-    this->arr = (uint32_t *) calloc(this->len, 32);
-    for (uint16_t i = 0; i < len; i++) {
-        this->arr[i] = f.arr[i];
-    }
+    this->lo_limb = f.lo_limb;
+    this->hi_limb = f.hi_limb;
+}
+
+FixedFloat::FixedFloat(const FixedFloat &f) {
+    copy_format(f);
+    this->arr = LimbAllocator::allocate(this->len, false);
+    memcpy(this->arr, f.arr, this->len * sizeof(uint32_t));
 }
 
 FixedFloat& FixedFloat::operator=(const FixedFloat &f) {
     if (this == &f) return *this;
-    if (arr) free(arr);
-    this->sign = f.sign;
-    this->base = f.base;
-    this->int_digit_len = f.int_digit_len;
-    this->dec_digit_len = f.dec_digit_len;
-    this->bit_per_digit = f.bit_per_digit;
-    this->bit_len = f.bit_len;
-    this->len = f.len;
-    this->arr = (uint32_t *) calloc(this->len, 32);
-    for (uint16_t i = 0; i < len; i++) {
-        this->arr[i] = f.arr[i];
+    // the buffer is reused whenever the length matches
+    if (arr && len != f.len) {
+        LimbAllocator::release(arr, len);
+        arr = nullptr;
     }
+    copy_format(f);
+    if (!arr) arr = LimbAllocator::allocate(this->len, false);
+    memcpy(this->arr, f.arr, this->len * sizeof(uint32_t));
     return *this;
 }
 
 // move constructor
 FixedFloat::FixedFloat(FixedFloat &&f) {
-    this->sign = f.sign;
-    this->base = f.base;
-    this->int_digit_len = f.int_digit_len;
-    this->dec_digit_len = f.dec_digit_len;
-    this->bit_per_digit = f.bit_per_digit;
-    this->bit_len = f.bit_len;
-    this->len = f.len;
-    auto arr =  f.arr;
+    copy_format(f);
+    this->arr = f.arr;
+    f.arr = nullptr;
+}
+
+FixedFloat& FixedFloat::operator=(FixedFloat &&f) {
+    if (this == &f) return *this;
+    if (arr) LimbAllocator::release(arr, len);
+    copy_format(f);
+    this->arr = f.arr;
     f.arr = nullptr;
-    this->arr = arr;
+    return *this;
 }
 
 FixedFloat::~FixedFloat() {
-    if (arr) free(arr);
+    if (arr) LimbAllocator::release(arr, len);
+}
+
+FixedFloat::Footprint FixedFloat::footprint() const {
+    Footprint ret;
+    ret.limbs = len;
+    ret.used_limbs = hi_limb - lo_limb;
+    ret.bytes = sizeof(FixedFloat) + (arr ? LimbAllocator::capacity(len) * sizeof(uint32_t) : 0);
+    return ret;
 }
 
 int32_t FixedFloat::intValue() const {
     double d = 0;
-    int32_t ret = 0;
     // integer part
-    for (uint16_t i = int_digit_len + dec_digit_len - 1; i >= dec_digit_len; i--) {
-        d *= base;
-        d += read_digit(i);
+    for (int64_t i = len - 1; i >= (int64_t) dec_limb_len; i--) {
+        d *= limb_base;
+        d += arr[i];
         if (d > INT32_MAX) break;
     }
-    ret = d > INT32_MAX ? INT32_MAX : (int32_t) d; // if overflow, return INT32_MAX
-    return sign ? -d : d;
+    int32_t ret = d > INT32_MAX ? INT32_MAX : (int32_t) d; // if overflow, return INT32_MAX
+    return sign ? -ret : ret;
 }
 
 double FixedFloat::doubleValue() const {
     double int_ret = 0;
-    // integer part
-    for (uint16_t i = int_digit_len + dec_digit_len - 1; i >= dec_digit_len; i--) {
-        int_ret *= base;
-        int_ret += read_digit(i);
+    // integer part, the zero limbs above hi_limb add nothing
+    for (int64_t i = hi_limb - 1; i >= (int64_t) dec_limb_len; i--) {
+        int_ret *= limb_base;
+        int_ret += arr[i];
     }
     double dec_ret = 0;
-    // decimal part
-    uint16_t lsd = least_significant_digit();
-    for (uint16_t i = lsd; i < dec_digit_len; i++) {
-        dec_ret /= base;
-        dec_ret += read_digit(i);
+    // decimal part, from the lowest limb so that small values do not underflow
+    for (uint64_t i = lo_limb; i < dec_limb_len; i++) {
+        dec_ret += arr[i];
+        dec_ret /= limb_base;
     }
-    dec_ret /= base;
     double ret = int_ret + dec_ret;
     if (sign) ret = -ret;
     return ret;
@@ -237,7 +323,7 @@ double FixedFloat::doubleValue() const {
 
 FixedFloat FixedFloat::operator-() const{
     FixedFloat ret(*this);
-    ret.sign = !this->sign;
+    ret.sign = is_zero() ? false : !this->sign;
     return ret;
 }
 
@@ -250,17 +336,7 @@ bool FixedFloat::operator==(const FixedFloat& other) const {
     if (base != other.base || int_digit_len != other.int_digit_len || dec_digit_len != other.dec_digit_len)
         throw std::runtime_error("can not compare two FixedFloat with different base or length");
     if (this->sign != other.sign) return false;
-    // 从最低有效数字开始比较
-    uint16_t lsd1 = least_significant_digit();
-    uint16_t lsd2 = other.least_significant_digit();
-    // 如果最低有效数字不同，则两数不相等
-    if (lsd1 != lsd2) return false;
-    uint16_t end = lsd1 < lsd2 ? lsd1 : lsd2;
-    // 读取每一位数字进行比较
-    for (uint16_t i = int_digit_len + dec_digit_len - 1; i >= end; i--) {
-        if (read_digit(i) != other.read_digit(i)) return false;
-    }
-    return true;
+    return compare_abs(other) == 0;
 }
 
 bool FixedFloat::operator<(const FixedFloat& other) const {
@@ -273,47 +349,73 @@ bool FixedFloat::operator<(const FixedFloat& other) const {
     // 如果当前数是正数，而另一个数是负数，则当前数大于另一个数
     else if (!this->sign && other.sign)
         return false;
-    uint16_t lsd1 = least_significant_digit();
-    uint16_t lsd2 = other.least_significant_digit();
-    // 从最低有效数字开始比较
-    uint16_t end = lsd1 < lsd2 ? lsd1 : lsd2;
-    // 读取每一位数字进行比较
-    for (uint16_t i = int_digit_len + dec_digit_len - 1; i >= end; i--) {
-        if (read_digit(i) > other.read_digit(i)) {
-            if (this->sign) return true;
-            else return false;
-        } else if (read_digit(i) < other.read_digit(i)) {
-            if (this->sign) return false;
-            else return true;
+    // 符号相同时比较绝对值，负数的绝对值越大则越小
+    int cmp = compare_abs(other);
+    return this->sign ? cmp > 0 : cmp < 0;
+}
+
+void FixedFloat::add_limbs(const uint32_t *other, uint64_t other_lo, uint64_t other_hi, bool other_sign) {
+    if (other_lo >= other_hi) return;
+    // only the union of the two nonzero windows takes part, every limb outside it stays zero
+    const uint64_t lo = is_zero() ? other_lo : std::min(lo_limb, other_lo);
+    const uint64_t hi = std::max(hi_limb, other_hi);
+    if (this->sign == other_sign) {
+        // the limbs above hi are zero, so the carry out of the window just sets the next limb
+        // and the carry out of the highest limb overflows and is dropped
+        if (LimbArith::add(arr + lo, other + lo, arr + lo, hi - lo, limb_base) && hi < len) {
+            arr[hi] = 1;
+            normalize(lo, hi + 1);
+            return;
         }
+    } else if (hi_limb != other_hi ? hi_limb > other_hi : LimbArith::compare(arr + lo, other + lo, hi - lo) >= 0) {
+        // subtract the smaller magnitude from the larger one, the sign follows the larger one
+        LimbArith::sub(arr + lo, other + lo, arr + lo, hi - lo, limb_base);
+    } else {
+        this->sign = other_sign;
+        LimbArith::sub(other + lo, arr + lo, arr + lo, hi - lo, limb_base);
     }
-    return false;
+    normalize(lo, hi);
+}
+
+void FixedFloat::product_limbs(const FixedFloat& a, const FixedFloat& b, uint32_t *out, uint64_t &lo, uint64_t &hi) const {
+    if (a.is_zero() || b.is_zero()) {
+        memset(out, 0, len * sizeof(uint32_t));
+        lo = hi = 0;
+        return;
+    }
+    // only the nonzero windows of the operands are multiplied
+    const uint64_t lo1 = a.lo_limb, lo2 = b.lo_limb, hi1 = a.hi_limb, hi2 = b.hi_limb;
+    const size_t n = hi1 - lo1 + hi2 - lo2;
+    LimbAllocator::Buffer prod(n, false);
+    Multiplier::mul(a.arr + lo1, hi1 - lo1, b.arr + lo2, hi2 - lo2, prod.data(), limb_base);
+
+    // the full product is scaled by limb_base^(2 * dec_limb_len), so drop dec_limb_len limbs: prod[j] lands at out[j + shift]
+    const int64_t shift = (int64_t) (lo1 + lo2) - (int64_t) dec_limb_len;
+    const int64_t first = std::max<int64_t>(shift, 0), last = std::min<int64_t>(shift + (int64_t) n, len);
+    if (first >= last) {
+        memset(out, 0, len * sizeof(uint32_t));
+        lo = hi = 0;
+        return;
+    }
+    memset(out, 0, first * sizeof(uint32_t));
+    memcpy(out + first, prod.data() + (first - shift), (last - first) * sizeof(uint32_t));
+    memset(out + last, 0, (len - last) * sizeof(uint32_t));
+    // truncate the padding digits and the overflow like normalize does
+    out[0] -= out[0] % low_unit;
+    if (top_unit != limb_base) out[len - 1] %= top_unit;
+    lo = first;
+    hi = last;
+    while (lo < hi && !out[lo]) lo++;
+    while (hi > lo && !out[hi - 1]) hi--;
+    if (lo == hi) lo = hi = 0;
 }
 
 FixedFloat FixedFloat::operator+(const FixedFloat& other) const {
     // 如果基数或者整数部分位数或者小数部分位数不同，则无法相加
     if (base != other.base || int_digit_len != other.int_digit_len || dec_digit_len != other.dec_digit_len)
         throw std::runtime_error("can not add two FixedFloat with different base or length");
-    FixedFloat ret(base, int_digit_len, dec_digit_len);
-    // 如果两数符号不同，则转化为减法
-    if (this->sign != other.sign) {
-        return *this - (-other);
-    }
-    ret.sign = this->sign;
-    uint16_t lsd1 = least_significant_digit();
-    uint16_t lsd2 = other.least_significant_digit();
-    uint16_t i = lsd1 < lsd2 ? lsd1 : lsd2;
-    uint32_t carry = 0;
-    for (; i < int_digit_len + dec_digit_len; i++) {
-        int32_t val = read_digit(i) + other.read_digit(i) + carry;
-        if (val >= base) {
-            val -= base;
-            carry = 1;
-        } else {
-            carry = 0;
-        }
-        ret.write_digit(i, val);
-    }
+    FixedFloat ret(*this);
+    ret.add_limbs(other.arr, other.lo_limb, other.hi_limb, other.sign);
     return ret;
 }
 
@@ -321,37 +423,9 @@ FixedFloat FixedFloat::operator-(const FixedFloat& other) const {
     // 如果基数或者整数部分位数或者小数部分位数不同，则无法相减
     if (base != other.base || int_digit_len != other.int_digit_len || dec_digit_len != other.dec_digit_len)
         throw std::runtime_error("can not add two FixedFloat with different base or length");
-    FixedFloat ret(base, int_digit_len, dec_digit_len);
-    // 如果两数符号不同，则转化为加法
-    if (this->sign != other.sign) {
-        return *this + (-other);
-    }
-
-    // if both are zero, then return according to the sign
-    if (is_zero()) return -other;
-    else if (other.is_zero()) return *this;
-
-    // if this >= other and this is negative, then return -(other - this)
-    // else if this < other and this is positive, then return -(other - this)
-    if (*this < other != this->sign) {
-        return -(other - *this);
-    }
-    
-    ret.sign = this->sign;
-    uint16_t lsd1 = least_significant_digit();
-    uint16_t lsd2 = other.least_significant_digit();
-    uint16_t i = lsd1 < lsd2 ? lsd1 : lsd2;
-    uint32_t carry = 0;
-    for (; i < int_digit_len + dec_digit_len; i++) {
-        int32_t val = read_digit(i) - other.read_digit(i) - carry;
-        if (val < 0) {
-            val += base;
-            carry = 1;
-        } else {
-            carry = 0;
-        }
-        ret.write_digit(i, val);
-    }
+    // 减去一个数等于加上它的相反数
+    FixedFloat ret(*this);
+    ret.add_limbs(other.arr, other.lo_limb, other.hi_limb, !other.sign);
     return ret;
 }
 
@@ -360,52 +434,197 @@ FixedFloat FixedFloat::operator*(const FixedFloat& other) const {
     if (base != other.base || int_digit_len != other.int_digit_len || dec_digit_len != other.dec_digit_len)
         throw std::runtime_error("can not add two FixedFloat with different base or length");
     FixedFloat ret(base, int_digit_len, dec_digit_len);
+    uint64_t lo, hi;
+    product_limbs(*this, other, ret.arr, lo, hi);
     ret.sign = this->sign ^ other.sign;
-    uint16_t lsd1 = least_significant_digit();
-    uint16_t lsd2 = other.least_significant_digit();
-    // 从最低有效数字开始相乘
-    int16_t i = lsd1 < lsd2 ? lsd1 : lsd2;
-    // 对于每一位数字，计算乘积并加到 ret 上
-    for (; i < int_digit_len + dec_digit_len; i++) {
-        uint32_t carry = 0;
-        for (int16_t j = lsd2 < dec_digit_len - i ? lsd2 : dec_digit_len - i; j < int_digit_len + dec_digit_len; j++) {
-            uint32_t val = read_digit(i) * other.read_digit(j) + carry + ret.read_digit(i + j - dec_digit_len);
-            carry = val / base;
-            val %= base;
-            ret.write_digit(i + j - dec_digit_len, val);
+    ret.normalize(lo, hi);
+    return ret;
+}
+
+FixedFloat& FixedFloat::operator+=(const FixedFloat& other) {
+    if (base != other.base || int_digit_len != other.int_digit_len || dec_digit_len != other.dec_digit_len)
+        throw std::runtime_error("can not add two FixedFloat with different base or length");
+    add_limbs(other.arr, other.lo_limb, other.hi_limb, other.sign);
+    return *this;
+}
+
+FixedFloat& FixedFloat::operator-=(const FixedFloat& other) {
+    if (base != other.base || int_digit_len != other.int_digit_len || dec_digit_len != other.dec_digit_len)
+        throw std::runtime_error("can not add two FixedFloat with different base or length");
+    add_limbs(other.arr, other.lo_limb, other.hi_limb, !other.sign);
+    return *this;
+}
+
+FixedFloat& FixedFloat::operator*=(const FixedFloat& other) {
+    if (base != other.base || int_digit_len != other.int_digit_len || dec_digit_len != other.dec_digit_len)
+        throw std::runtime_error("can not add two FixedFloat with different base or length");
+    uint64_t lo, hi;
+    product_limbs(*this, other, arr, lo, hi);
+    this->sign ^= other.sign;
+    normalize(lo, hi);
+    return *this;
+}
+
+FixedFloat& FixedFloat::fma(const FixedFloat& a, const FixedFloat& b) {
+    if (base != a.base || int_digit_len != a.int_digit_len || dec_digit_len != a.dec_digit_len ||
+        base != b.base || int_digit_len != b.int_digit_len || dec_digit_len != b.dec_digit_len)
+        throw std::runtime_error("can not add two FixedFloat with different base or length");
+    LimbAllocator::Buffer prod(len, false);
+    uint64_t lo, hi;
+    product_limbs(a, b, prod.data(), lo, hi);
+    add_limbs(prod.data(), lo, hi, a.sign ^ b.sign);
+    return *this;
+}
+
+FixedFloat FixedFloat::operator/(const FixedFloat& other) const {
+    // 如果基数或者整数部分位数或者小数部分位数不同，则无法相除
+    if (base != other.base || int_digit_len != other.int_digit_len || dec_digit_len != other.dec_digit_len)
+        throw std::runtime_error("can not divide two FixedFloat with different base or length");
+    if (other.is_zero()) throw std::runtime_error("division by zero");
+    FixedFloat ret(base, int_digit_len, dec_digit_len);
+    // both operands are scaled by limb_base^dec_limb_len, so scale the dividend once more before dividing
+    std::vector<uint32_t> num(dec_limb_len + len, 0);
+    memcpy(num.data() + dec_limb_len, arr, len * sizeof(uint32_t));
+    std::vector<uint32_t> quot = Divider::divide(num.data(), num.size(), other.arr, other.len, limb_base);
+    // the part beyond the highest limb overflows and is dropped
+    std::copy_n(quot.begin(), std::min<size_t>(len, quot.size()), ret.arr);
+    ret.sign = this->sign ^ other.sign;
+    ret.normalize();
+    return ret;
+}
+
+FixedFloat FixedFloat::inverse() const {
+    if (is_zero()) throw std::runtime_error("division by zero");
+    FixedFloat ret(base, int_digit_len, dec_digit_len);
+    // the dividend is 1 scaled twice by limb_base^dec_limb_len, written as limbs since a format
+    // without integer digits can not hold 1 itself
+    std::vector<uint32_t> num(2 * dec_limb_len + 1, 0);
+    num[2 * dec_limb_len] = 1;
+    std::vector<uint32_t> quot = Divider::divide(num.data(), num.size(), arr, len, limb_base);
+    // like operator/, the part beyond the highest limb overflows and is dropped
+    std::copy_n(quot.begin(), std::min<size_t>(len, quot.size()), ret.arr);
+    ret.sign = sign;
+    ret.normalize();
+    return ret;
+}
+
+FixedFloat FixedFloat::pow(uint64_t n) const {
+    if (n == 0) return FixedFloat(base, int_digit_len, dec_digit_len, 1.0);
+    const int bits = 64 - __builtin_clzll(n);
+    FixedFloat ret(*this);
+    // small exponents: left-to-right binary exponentiation
+    if (bits <= 8) {
+        for (int i = bits - 2; i >= 0; i--) {
+            ret *= ret;
+            if ((n >> i) & 1) ret *= *this;
         }
+        return ret;
+    }
+
+    // large exponents: sliding window over the bits, with the odd powers x, x^3, ..., x^(2^w - 1) precomputed
+    const int w = bits <= 24 ? 3 : 4;
+    std::vector<FixedFloat> odd(1, *this);
+    const FixedFloat sqr = *this * *this;
+    for (int i = 1; i < (1 << (w - 1)); i++) odd.push_back(odd.back() * sqr);
+    bool started = false;
+    for (int i = bits - 1; i >= 0; ) {
+        if (!((n >> i) & 1)) {
+            ret *= ret;
+            i--;
+            continue;
+        }
+        // the longest window [l, i] of at most w bits that ends with a set bit
+        int l = i - w + 1 > 0 ? i - w + 1 : 0;
+        while (!((n >> l) & 1)) l++;
+        const uint64_t val = (n >> l) & ((1ULL << (i - l + 1)) - 1);
+        if (started) {
+            for (int j = l; j <= i; j++) ret *= ret;
+            ret *= odd[val >> 1];
+        } else {
+            ret = odd[val >> 1];
+            started = true;
+        }
+        i = l - 1;
     }
     return ret;
 }
 
-std::string FixedFloat::toString() const {
-    std::string ret = "";
-    if (sign) ret += "-";
-    bool flag = false; // flag to indicate if there is any non-zero digit
-    const std::function<char(uint32_t)> itoc = [] (uint32_t i) {
-        return i < 10 ? '0' + i : 'A' + i - 10;
-    };
-    // integer part
-    for (int16_t i = int_digit_len + dec_digit_len - 1; i >= dec_digit_len; i--) {
-        uint32_t val = read_digit(i);
-        if (!val && !flag) continue;
-        ret += itoc(val);
-        flag = true;
-    }
-    if (!flag) ret += "0";
-    flag = false;
-    ret += ".";
-    // store decimal by least significant digit
-    std::string tmp = ret;
-    for (int16_t i = dec_digit_len - 1 ; i >= 0; i--) {
-        uint32_t val = read_digit(i);
-        tmp += itoc(val);
-        if (val) {  // if there is any non-zero digit, then update ret
-            ret = tmp;
-            flag = true;
+// the character of one digit, through a table since a branch on d < 10 is unpredictable for random digits
+static const char DIGIT_CHARS[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+static inline char digit_char(uint32_t d) {
+    return d < 36 ? DIGIT_CHARS[d] : (char) ('A' + d - 10);
+}
+
+static const char DIGIT_PAIRS[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+// the n lowest digits of one limb, the most significant first
+static void limb_chars(uint32_t val, uint16_t base, uint16_t n, char *out) {
+    if (base == 10) {
+        // two digits per division by a constant
+        for (; n >= 2; n -= 2) {
+            memcpy(out + n - 2, DIGIT_PAIRS + 2 * (val % 100), 2);
+            val /= 100;
         }
+        if (n) out[0] = (char) ('0' + val % 10);
+    } else if (!(base & (base - 1))) {
+        const unsigned bits = __builtin_ctz(base);
+        for (; n > 0; n--, val >>= bits) out[n - 1] = digit_char(val & (base - 1));
+    } else {
+        for (; n > 0; n--, val /= base) out[n - 1] = digit_char(val % base);
+    }
+}
+
+uint64_t FixedFloat::most_significant_digit() const {
+    if (is_zero()) return 0;
+    uint32_t val = arr[hi_limb - 1];
+    uint64_t pos = (hi_limb - 1) * digit_per_limb;
+    for (; val; val /= base) pos++;
+    return pos - pad_digit_len;
+}
+
+void FixedFloat::write_chars(uint64_t lo, uint64_t hi, char *out) const {
+    char buf[32];
+    while (hi > lo) {
+        // digit hi - 1 sits at offset off of its limb, the limb is expanded once for all of its digits in the range
+        const uint64_t pos = hi - 1 + pad_digit_len;
+        const uint64_t off = pos % digit_per_limb;
+        const uint64_t take = std::min(off + 1, hi - lo);
+        limb_chars(arr[pos / digit_per_limb], base, digit_per_limb, buf);
+        memcpy(out, buf + (digit_per_limb - 1 - off), take);
+        out += take;
+        hi -= take;
+    }
+}
+
+std::to_chars_result FixedFloat::toChars(char *first, char *last) const {
+    // the integer digits start at the most significant nonzero digit, the decimal digits stop at the least significant one
+    uint64_t int_hi = dec_digit_len, dec_lo = dec_digit_len;
+    if (!is_zero()) {
+        int_hi = std::max(most_significant_digit(), dec_digit_len);
+        dec_lo = std::min(least_significant_digit(), dec_digit_len);
     }
-    if (!flag) ret += "0"; // if all digits are zero, then add a zero
+    const uint64_t int_n = int_hi - dec_digit_len, dec_n = dec_digit_len - dec_lo;
+    const uint64_t need = sign + std::max<uint64_t>(int_n, 1) + 1 + std::max<uint64_t>(dec_n, 1);
+    if ((uint64_t) (last - first) < need) return {last, std::errc::value_too_large};
+    if (sign) *first++ = '-';
+    // integer part
+    if (int_n) write_chars(dec_digit_len, int_hi, first);
+    else *first = '0';
+    first += std::max<uint64_t>(int_n, 1);
+    *first++ = '.';
+    // decimal part, trailing zeros are dropped, if all digits are zero then add a zero
+    if (dec_n) write_chars(dec_lo, dec_digit_len, first);
+    else *first = '0';
+    first += std::max<uint64_t>(dec_n, 1);
+    return {first, std::errc()};
+}
+
+std::string FixedFloat::toString() const {
+    std::string ret(maxChars(), '\0');
+    ret.resize(toChars(ret.data(), ret.data() + ret.size()).ptr - ret.data());
     return ret;
 }
 
@@ -413,7 +632,7 @@ FixedFloat FixedFloat::baseTo(uint16_t base) const{
     return this->convertTo(base, this->int_digit_len, this->dec_digit_len);
 }
 
-FixedFloat FixedFloat::convertTo(uint16_t base, uint16_t int_digit_len, uint16_t dec_digit_len) const {
+FixedFloat FixedFloat::convertTo(uint16_t base, uint64_t int_digit_len, uint64_t dec_digit_len) const {
     FixedFloat ret(base, int_digit_len, dec_digit_len);
 
     // if base, int_digit_len, dec_digit_len are the same, then return itself
@@ -422,34 +641,81 @@ FixedFloat FixedFloat::convertTo(uint16_t base, uint16_t int_digit_len, uint16_t
         return ret;
     }
 
-    FixedFloat tmp(*this), mul(base, int_digit_len, dec_digit_len, this->base), mul2(this->base, this->int_digit_len, this->dec_digit_len, base);
-    tmp.sign = false;
-
-    // calculate the most significant bit
-    uint16_t msb = this->dec_digit_len;
-    for (int16_t i = this->int_digit_len + this->dec_digit_len - 1; i >= this->dec_digit_len; i--)
-        if (read_digit(i)) {
-            msb = i;
-            break;
+    // with the same base only the digit window changes, so copy the digits that fit
+    if (base == this->base) {
+        const std::vector<uint16_t> src = unpack_digits();
+        std::vector<uint16_t> dst(int_digit_len + dec_digit_len, 0);
+        for (int64_t j = 0; j < (int64_t) dst.size(); j++) {
+            int64_t k = j - (int64_t) dec_digit_len + (int64_t) this->dec_digit_len;
+            if (k >= 0 && k < (int64_t) src.size()) dst[j] = src[k];
         }
-    // from the most significant digit to unit digit, update the return value to get the converted integer part
-    for (; msb >= this->dec_digit_len; msb--) {
-        ret = ret * mul + FixedFloat(base, int_digit_len, dec_digit_len, read_digit(msb));
+        ret.pack_digits(dst.data());
+        ret.sign = this->sign;
+        ret.normalize();
+        return ret;
     }
 
-    tmp = *this;
-    tmp.sign = false;
+    // when both bases are powers of one root, every digit is a group of root digits and the conversion only regroups them,
+    // dropping the root digits below the target precision like the general path does
+    const uint64_t root = BaseConverter::commonRoot(this->base, base);
+    if (root == 2) {
+        // the limbs already are bit fields, so the groups are cut straight out of them
+        const unsigned from_bits = __builtin_ctzll(limb_base), to_bits = __builtin_ctzll(ret.limb_base);
+        const int64_t shift = (int64_t) dec_limb_len * from_bits - (int64_t) ret.dec_limb_len * to_bits;
+        BaseConverter::regroupBits(arr, len, from_bits, shift, ret.arr, ret.len, to_bits);
+        ret.sign = this->sign;
+        ret.normalize();
+        return ret;
+    }
+    if (root) {
+        uint32_t from_width = 0, to_width = 0;
+        for (uint64_t p = 1; p < this->base; p *= root) from_width++;
+        for (uint64_t p = 1; p < base; p *= root) to_width++;
+        // root digits of the magnitude, index 0 is the lowest one of the source
+        const std::vector<uint16_t> src = unpack_digits();
+        std::vector<uint16_t> roots(src.size() * from_width);
+        for (size_t k = 0; k < src.size(); k++) {
+            uint32_t d = src[k];
+            for (uint32_t j = 0; j < from_width; j++) {
+                roots[k * from_width + j] = d % root;
+                d /= root;
+            }
+        }
+        std::vector<uint16_t> dst(int_digit_len + dec_digit_len, 0);
+        const int64_t shift = (int64_t) this->dec_digit_len * from_width - (int64_t) dec_digit_len * to_width;
+        for (size_t m = 0; m < dst.size(); m++) {
+            uint32_t d = 0;
+            for (int64_t j = to_width - 1; j >= 0; j--) {
+                const int64_t q = (int64_t) m * to_width + shift + j;
+                d = d * root + (q >= 0 && q < (int64_t) roots.size() ? roots[q] : 0);
+            }
+            dst[m] = d;
+        }
+        ret.pack_digits(dst.data());
+        ret.sign = this->sign;
+        ret.normalize();
+        return ret;
+    }
 
-    // from unit digit to the last digit, update the return value to get the converted decimal part
-    for (uint16_t i = 1; i <= dec_digit_len; i++) {
-        tmp.clear_int();
-        tmp = tmp * mul2;
-        int32_t val = tmp.intValue();
-        ret.write_digit(dec_digit_len - i,  val % base);
+    // the magnitude is arr / B^dec_limb_len, so the target digits are floor(arr * base^dec_digit_len / B^dec_limb_len),
+    // which turns both the integer and the fractional part into one integer conversion
+    const std::vector<uint32_t> scale = BaseConverter::power(base, dec_digit_len, limb_base);
+    std::vector<uint32_t> num(len + scale.size());
+    Multiplier::mul(arr, len, scale.data(), scale.size(), num.data(), limb_base);
+    num.erase(num.begin(), num.begin() + dec_limb_len);
+    // only the lowest ret.len limbs survive the overflow of the target format
+    const std::vector<uint32_t> digits = BaseConverter::convert(num.data(), num.size(), limb_base, ret.limb_base, ret.len);
+
+    // move the digits above the padding of the lowest limb
+    uint64_t carry = 0;
+    for (uint64_t i = 0; i < ret.len; i++) {
+        uint64_t val = (uint64_t) (i < digits.size() ? digits[i] : 0) * ret.low_unit + carry;
+        ret.arr[i] = LimbArith::split(val, ret.limb_base, carry);
     }
 
     // copy the sign
     ret.sign = this->sign;
+    ret.normalize();
 
     return ret;
 }
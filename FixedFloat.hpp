@@ -5,43 +5,91 @@
 #include <cstdlib>
 #include <cmath>
 #include <string>
+#include <string_view>
+#include <charconv>
+#include <vector>
 
 class FixedFloat {
     private:
         friend class Expression;
+        friend class Polynomial;
+        friend class ResultCache;
+        friend class FixedFloatBatch;
+        friend class Serializer;
+        template <uint16_t, uint64_t, uint64_t> friend class StaticFixedFloat;
         bool sign = false; // 符号位
         uint16_t base; // 基数
-        uint16_t int_digit_len; // 整数部分的位数
-        uint16_t dec_digit_len; // base^(-dec_digit_len) 为实际精度，dec_digit_len就是小数点后的位数
+        uint64_t int_digit_len; // 整数部分的位数
+        uint64_t dec_digit_len; // base^(-dec_digit_len) 为实际精度，dec_digit_len就是小数点后的位数
 
-        uint16_t bit_per_digit; // 每个数字占用的 bit 数
-        uint16_t bit_len; // 整个数字占用的 bit 数
+        // 数字按 limb 存储，每个 limb 存放 digit_per_limb 个数字，即一个以 base^digit_per_limb 为基数的“大数字”
+        // 小数点总是对齐到 limb 的边界，小数部分不足一个 limb 的部分在最低的 limb 中用 0 补齐
+        uint16_t digit_per_limb; // 每个 limb 存放的数字个数，满足 base^digit_per_limb <= 2^32
+        uint64_t limb_base; // limb 的基数，即 base^digit_per_limb
+        uint64_t dec_limb_len; // 小数部分占用的 limb 数
+        uint16_t pad_digit_len; // 最低 limb 中用于对齐的补齐数字个数
+        uint32_t low_unit; // base^pad_digit_len，最低 limb 必须是它的倍数
+        uint64_t top_unit; // 最高 limb 必须小于它，超出的部分即为溢出
 
-        uint16_t len; // 所分配的数组的长度
+        uint64_t len; // 所分配的数组的长度
         uint32_t *arr = nullptr; // 存储的数组
+        // 非零 limb 的范围 [lo_limb, hi_limb)，范围外的 limb 都为 0，且 arr[lo_limb] 与 arr[hi_limb - 1] 非零；值为 0 时两者都是 0
+        // 每次写入后由 normalize 在写入的范围内收紧，比较、加减和乘法只处理这个范围
+        uint64_t lo_limb = 0;
+        uint64_t hi_limb = 0;
 
-        uint32_t read_n_bit(uint16_t i, uint16_t n) const;          // 从 arr 中读取从 i 开始的 n bit 位
-        uint32_t write_n_bit(uint16_t i, uint16_t n, uint32_t val); // 从 arr 中写入从 i 开始的 n bit 位
-        uint32_t read_digit(uint16_t i) const;                      // 读取第 i 位数字
-        uint32_t write_digit(uint16_t i, uint32_t val);             // 写入第 i 位数字
-        uint16_t least_significant_bit() const;                     // 最低有效位，即数组中最低的非零 bit 位
-        uint16_t least_significant_digit() const;                   // 最低有效数字，即最低有效位对应的数字
+        uint32_t read_digit(uint64_t i) const;                      // 读取第 i 位数字
+        uint32_t write_digit(uint64_t i, uint32_t val);             // 写入第 i 位数字
+        std::vector<uint16_t> unpack_digits() const;                // 拆出所有数字，下标 0 为最低位的小数
+        void pack_digits(const uint16_t *digits);                   // 把 unpack_digits 格式的数字写回数组
+        uint64_t least_significant_digit() const;                   // 最低有效数字，即最低的非零数字
+        uint64_t most_significant_digit() const;                    // 最高的非零数字的下一位，为 0 时返回 0
+        void write_chars(uint64_t lo, uint64_t hi, char *out) const; // 把下标在 [lo, hi) 中的数字从高到低写成字符
+        void normalize();                                           // 清除补齐位和溢出位，修正 0 的符号，并重新计算非零 limb 的范围
+        void normalize(uint64_t lo, uint64_t hi);                   // 同上，但已知 [lo, hi) 之外的 limb 都为 0
+        int compare_abs(const FixedFloat& other) const;             // 比较两数绝对值的大小
+        void copy_format(const FixedFloat& f);                      // 复制 f 的格式，不包括数组
+        // 原地加上绝对值为 other、符号为 other_sign 的数，other 的非零 limb 的范围为 [other_lo, other_hi)
+        void add_limbs(const uint32_t *other, uint64_t other_lo, uint64_t other_hi, bool other_sign);
+        // 把截断后的 |a * b| 写入 out，out 可以与 a, b 重叠，[lo, hi) 为结果的非零 limb 的范围
+        void product_limbs(const FixedFloat& a, const FixedFloat& b, uint32_t *out, uint64_t &lo, uint64_t &hi) const;
         void clear_int();                                           // 清空整数部分
         void clear_dec();                                           // 清空小数部分
-        bool is_zero() const;                                             // 判断是否为 0
+        bool is_zero() const { return hi_limb == 0; }                    // 判断是否为 0
     public:
+        // 整数部分与小数部分的总位数上限，超过时构造函数抛出异常而不是让长度的计算溢出
+        static const uint64_t MAX_DIGIT_LEN = (uint64_t) 1 << 40;
+        // 一个数的内存占用
+        struct Footprint {
+            uint64_t limbs;      // 数组的 limb 数
+            uint64_t used_limbs; // 其中非零 limb 的范围的长度
+            uint64_t bytes;      // 对象本身与数组实际占用的字节数，数组按分配器分配的块大小计算
+        };
         // 通过基数，整数部分位数，小数部分位数构造一个 FixedFloat，并初始化可能的初值
-        FixedFloat(uint16_t base, uint16_t int_digit_len, uint16_t dec_digit_len);
-        FixedFloat(uint16_t base, uint16_t int_digit_len, uint16_t dec_digit_len, double d);
-        FixedFloat(uint16_t base, uint16_t int_digit_len, uint16_t dec_digit_len, const std::string &str);
+        FixedFloat(uint16_t base, uint64_t int_digit_len, uint64_t dec_digit_len);
+        FixedFloat(uint16_t base, uint64_t int_digit_len, uint64_t dec_digit_len, double d);
+        // 解析字符串，每个 limb 的数字一次累加完成，超出的整数高位和小数低位被截断
+        FixedFloat(uint16_t base, uint64_t int_digit_len, uint64_t dec_digit_len, std::string_view str);
         // 拷贝构造函数
         FixedFloat(const FixedFloat &f);
         // 赋值构造函数
         FixedFloat& operator=(const FixedFloat &f);
         // 移动构造函数
         FixedFloat(FixedFloat &&f);
+        // 移动赋值
+        FixedFloat& operator=(FixedFloat &&f);
         // 析构函数
         ~FixedFloat();
+        // 返回基数
+        uint16_t getBase() const { return base; }
+        // 返回整数部分的位数
+        uint64_t getIntDigitLen() const { return int_digit_len; }
+        // 返回小数部分的位数
+        uint64_t getDecDigitLen() const { return dec_digit_len; }
+        // 判断是否为 0
+        bool isZero() const { return is_zero(); }
+        // 返回内存占用
+        Footprint footprint() const;
         // 返回整数值
         int32_t intValue() const;
         // 返回浮点数值
@@ -60,12 +108,28 @@ class FixedFloat {
         FixedFloat operator-(const FixedFloat& other) const;
         // 两数相乘
         FixedFloat operator*(const FixedFloat& other) const;
+        // 原地加、减、乘，不分配新的数组
+        FixedFloat& operator+=(const FixedFloat& other);
+        FixedFloat& operator-=(const FixedFloat& other);
+        FixedFloat& operator*=(const FixedFloat& other);
+        // 原地加上 a * b，乘积先截断再相加
+        FixedFloat& fma(const FixedFloat& a, const FixedFloat& b);
+        // 两数相除，结果向零截断到 dec_digit_len 位小数
+        FixedFloat operator/(const FixedFloat& other) const;
+        // 求倒数，溢出的整数高位与除法一样被截断，整数部分为 0 位的格式也是如此
+        FixedFloat inverse() const;
+        // 求 n 次幂，只需 O(log n) 次乘法
+        FixedFloat pow(uint64_t n) const;
         // 获得该数的字符串表示
         std::string toString() const;
+        // 与 toString 相同的文本写入 [first, last)，不分配内存；空间不足时返回 {last, std::errc::value_too_large}
+        std::to_chars_result toChars(char *first, char *last) const;
+        // toChars 最多写入的字符数
+        uint64_t maxChars() const { return int_digit_len + dec_digit_len + 3; }
         // 将该数转换为指定基数
         FixedFloat baseTo(uint16_t base) const;
         // 将该数转换为指定基数，整数部分位数，小数部分位数
-        FixedFloat convertTo(uint16_t base, uint16_t int_digit_len, uint16_t dec_digit_len) const;
+        FixedFloat convertTo(uint16_t base, uint64_t int_digit_len, uint64_t dec_digit_len) const;
 };
 
-#endif
\ No newline at end of file
+#endif
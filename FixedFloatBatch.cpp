@@ -0,0 +1,234 @@
+#include "FixedFloatBatch.hpp"
+#include "LimbAllocator.hpp"
+
+#include <stdexcept>
+#include <cstring>
+
+// every kernel is compiled for AVX-512, AVX2 and plain x86-64, the loader picks the best one for the CPU
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__)
+#define LANE_KERNEL __attribute__((target_clones("arch=x86-64-v4", "avx2", "default")))
+#else
+#define LANE_KERNEL
+#endif
+
+static const size_t L = FixedFloatBatch::LANES;
+
+// x = x + y on lanes where sub is 0 and x = x - y where it is 1, all modulo B^len
+// neg receives the lanes that subtracted a larger magnitude, whose result is now B^len - |x - y|
+LANE_KERNEL static void add_sub_kernel(uint32_t *x, const uint32_t *y, const uint32_t *sub, uint32_t *neg, size_t len, uint64_t limb_base) {
+    uint64_t carry[L] = {0};
+    for (size_t k = 0; k < len; k++, x += L, y += L) {
+        for (size_t l = 0; l < L; l++) {
+            // both results are formed and one is selected, so the loop has no branches
+            const uint64_t s = (uint64_t) x[l] + y[l] + carry[l];
+            const uint64_t sc = s >= limb_base;
+            const uint64_t d = (uint64_t) x[l] - y[l] - carry[l];
+            const uint64_t dc = d >> 63;
+            x[l] = (uint32_t) (sub[l] ? d + dc * limb_base : s - sc * limb_base);
+            carry[l] = sub[l] ? dc : sc;
+        }
+    }
+    for (size_t l = 0; l < L; l++) neg[l] = sub[l] & (uint32_t) carry[l];
+}
+
+// x = B^len - x on the lanes where neg is set
+LANE_KERNEL static void negate_kernel(uint32_t *x, const uint32_t *neg, size_t len, uint64_t limb_base) {
+    uint64_t borrow[L] = {0};
+    for (size_t k = 0; k < len; k++, x += L) {
+        for (size_t l = 0; l < L; l++) {
+            const uint64_t d = 0 - (uint64_t) x[l] - borrow[l];
+            const uint64_t dc = d >> 63;
+            x[l] = neg[l] ? (uint32_t) (d + dc * limb_base) : x[l];
+            borrow[l] = dc;
+        }
+    }
+}
+
+// full len x len schoolbook products of every lane
+// each product is split into a quotient and remainder of the limb base on its own, and only the cheap
+// sum of a remainder, the previous quotient and a one-bit carry forms the dependency chain along a row
+// the division is estimated in double precision and corrected by one step, since no vector ISA has a
+// 64-bit high multiply
+LANE_KERNEL static void mul_kernel(const uint32_t *a, const uint32_t *b, uint32_t *prod, size_t len, uint64_t limb_base) {
+    memset(prod, 0, 2 * len * L * sizeof(uint32_t));
+    // t < B^2 <= 2^64, t >> 11 fits in a double exactly and the estimate is off by at most one
+    const double inv = 2048.0 / (double) limb_base;
+    const int64_t base = (int64_t) limb_base;
+    for (size_t i = 0; i < len; i++) {
+        uint64_t high[L] = {0}, carry[L] = {0};
+        const uint32_t *x = a + i * L;
+        for (size_t j = 0; j < len; j++) {
+            const uint32_t *y = b + j * L;
+            uint32_t *r = prod + (i + j) * L;
+            for (size_t l = 0; l < L; l++) {
+                const uint64_t t = (uint64_t) x[l] * y[l] + r[l];
+                int64_t q = (int64_t) ((double) (int64_t) (t >> 11) * inv);
+                int64_t rem = (int64_t) (t - (uint64_t) q * limb_base);
+                const int64_t lo = rem < 0;
+                rem += lo * base;
+                q -= lo;
+                const int64_t hi = rem >= base;
+                rem -= hi * base;
+                q += hi;
+                // rem + high + carry <= 2B - 1
+                const uint64_t v = (uint64_t) rem + high[l] + carry[l];
+                carry[l] = v >= limb_base;
+                r[l] = (uint32_t) (v - carry[l] * limb_base);
+                high[l] = (uint64_t) q;
+            }
+        }
+        uint32_t *r = prod + (i + len) * L;
+        for (size_t l = 0; l < L; l++) r[l] = (uint32_t) (high[l] + carry[l]);
+    }
+}
+
+// the same for power-of-two bases, whose limbs fill the whole word
+LANE_KERNEL static void mul_kernel_pow2(const uint32_t *a, const uint32_t *b, uint32_t *prod, size_t len) {
+    memset(prod, 0, 2 * len * L * sizeof(uint32_t));
+    for (size_t i = 0; i < len; i++) {
+        uint64_t high[L] = {0}, carry[L] = {0};
+        const uint32_t *x = a + i * L;
+        for (size_t j = 0; j < len; j++) {
+            const uint32_t *y = b + j * L;
+            uint32_t *r = prod + (i + j) * L;
+            for (size_t l = 0; l < L; l++) {
+                const uint64_t t = (uint64_t) x[l] * y[l] + r[l];
+                const uint64_t v = (t & 0xFFFFFFFF) + high[l] + carry[l];
+                carry[l] = v >> 32;
+                r[l] = (uint32_t) v;
+                high[l] = t >> 32;
+            }
+        }
+        uint32_t *r = prod + (i + len) * L;
+        for (size_t l = 0; l < L; l++) r[l] = (uint32_t) (high[l] + carry[l]);
+    }
+}
+
+// x = x - x % unit on every lane
+LANE_KERNEL static void floor_kernel(uint32_t *x, uint64_t unit) {
+    const double inv = 1.0 / (double) unit;
+    const int64_t u = (int64_t) unit;
+    for (size_t l = 0; l < L; l++) {
+        int64_t q = (int64_t) ((double) x[l] * inv);
+        int64_t rem = (int64_t) x[l] - q * u;
+        rem += (rem < 0) * u;
+        rem -= (rem >= u) * u;
+        x[l] -= (uint32_t) rem;
+    }
+}
+
+// x = x % unit on every lane
+LANE_KERNEL static void mod_kernel(uint32_t *x, uint64_t unit) {
+    const double inv = 1.0 / (double) unit;
+    const int64_t u = (int64_t) unit;
+    for (size_t l = 0; l < L; l++) {
+        int64_t q = (int64_t) ((double) x[l] * inv);
+        int64_t rem = (int64_t) x[l] - q * u;
+        rem += (rem < 0) * u;
+        rem -= (rem >= u) * u;
+        x[l] = (uint32_t) rem;
+    }
+}
+
+// clear the sign of the lanes that are zero
+LANE_KERNEL static void zero_sign_kernel(const uint32_t *x, uint32_t *signs, size_t len) {
+    uint32_t any[L] = {0};
+    for (size_t k = 0; k < len; k++, x += L) {
+        for (size_t l = 0; l < L; l++) any[l] |= x[l];
+    }
+    for (size_t l = 0; l < L; l++) signs[l] &= any[l] != 0;
+}
+
+FixedFloatBatch::FixedFloatBatch(const FixedFloat& like):
+                        base(like.base),
+                        int_digit_len(like.int_digit_len),
+                        dec_digit_len(like.dec_digit_len),
+                        limb_base(like.limb_base),
+                        dec_limb_len(like.dec_limb_len),
+                        low_unit(like.low_unit),
+                        top_unit(like.top_unit),
+                        len(like.len),
+                        limbs((size_t) like.len * LANES, 0) {}
+
+FixedFloatBatch FixedFloatBatch::broadcast(const FixedFloat& f) {
+    FixedFloatBatch ret(f);
+    for (size_t l = 0; l < LANES; l++) ret.set(l, f);
+    return ret;
+}
+
+void FixedFloatBatch::check_format(const FixedFloatBatch& other) const {
+    if (base != other.base || int_digit_len != other.int_digit_len || dec_digit_len != other.dec_digit_len)
+        throw std::runtime_error("can not add two FixedFloat with different base or length");
+}
+
+void FixedFloatBatch::set(size_t lane, const FixedFloat& f) {
+    if (base != f.base || int_digit_len != f.int_digit_len || dec_digit_len != f.dec_digit_len)
+        throw std::runtime_error("can not add two FixedFloat with different base or length");
+    for (size_t k = 0; k < len; k++) limbs[k * LANES + lane] = f.arr[k];
+    signs[lane] = f.sign;
+}
+
+FixedFloat FixedFloatBatch::get(size_t lane) const {
+    FixedFloat ret(base, int_digit_len, dec_digit_len);
+    for (size_t k = 0; k < len; k++) ret.arr[k] = limbs[k * LANES + lane];
+    ret.sign = signs[lane];
+    ret.normalize();
+    return ret;
+}
+
+uint64_t FixedFloatBatch::effectiveDigits(size_t lane) const {
+    size_t lo = 0, hi = len;
+    while (lo < len && !limbs[lo * LANES + lane]) lo++;
+    if (lo == len) return 0;
+    while (!limbs[(hi - 1) * LANES + lane]) hi--;
+    uint64_t digit_per_limb = 0;
+    for (uint64_t unit = 1; unit < limb_base; unit *= base) digit_per_limb++;
+    // the padding digits below the lowest limb cancel out in the difference
+    uint64_t top = (hi - 1) * digit_per_limb, bottom = lo * digit_per_limb;
+    for (uint32_t val = limbs[(hi - 1) * LANES + lane]; val; val /= base) top++;
+    for (uint32_t val = limbs[lo * LANES + lane]; val % base == 0; val /= base) bottom++;
+    return top - bottom;
+}
+
+void FixedFloatBatch::normalize() {
+    if (low_unit > 1) floor_kernel(limbs.data(), low_unit);
+    if (top_unit != limb_base) mod_kernel(limbs.data() + (len - 1) * LANES, top_unit);
+    zero_sign_kernel(limbs.data(), signs.data(), len);
+}
+
+void FixedFloatBatch::add_signed(const FixedFloatBatch& other, bool negate) {
+    check_format(other);
+    // lanes whose effective signs differ subtract magnitudes, like FixedFloat::add_limbs
+    uint32_t sub[LANES], neg[LANES];
+    bool any = false;
+    for (size_t l = 0; l < LANES; l++) sub[l] = signs[l] ^ other.signs[l] ^ (uint32_t) negate;
+    add_sub_kernel(limbs.data(), other.limbs.data(), sub, neg, len, limb_base);
+    for (size_t l = 0; l < LANES; l++) {
+        signs[l] ^= neg[l];
+        any |= neg[l] != 0;
+    }
+    if (any) negate_kernel(limbs.data(), neg, len, limb_base);
+    normalize();
+}
+
+FixedFloatBatch& FixedFloatBatch::operator+=(const FixedFloatBatch& other) {
+    add_signed(other, false);
+    return *this;
+}
+
+FixedFloatBatch& FixedFloatBatch::operator-=(const FixedFloatBatch& other) {
+    add_signed(other, true);
+    return *this;
+}
+
+FixedFloatBatch& FixedFloatBatch::operator*=(const FixedFloatBatch& other) {
+    check_format(other);
+    LimbAllocator::Buffer prod(2 * len * LANES, false);
+    if (limb_base == ((uint64_t) 1 << 32)) mul_kernel_pow2(limbs.data(), other.limbs.data(), prod.data(), len);
+    else mul_kernel(limbs.data(), other.limbs.data(), prod.data(), len, limb_base);
+    // keep the limbs at the scale of the operands and drop the overflowing ones, like FixedFloat::product_limbs
+    memcpy(limbs.data(), prod.data() + dec_limb_len * LANES, len * LANES * sizeof(uint32_t));
+    for (size_t l = 0; l < LANES; l++) signs[l] ^= other.signs[l];
+    normalize();
+    return *this;
+}
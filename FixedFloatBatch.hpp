@@ -0,0 +1,52 @@
+#ifndef __FIXED_FLOAT_BATCH_HPP__
+#define __FIXED_FLOAT_BATCH_HPP__
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <vector>
+#include "FixedFloat.hpp"
+
+// LANES 个格式相同的 FixedFloat 按结构数组存放：第 k 个 limb 的所有 lane 连续存放在 limbs[k * LANES, (k + 1) * LANES)
+// 同一个运算在所有 lane 上同步执行，内层循环遍历 lane，编译为 AVX-512、AVX2 和标量三个版本，运行时按 CPU 选择
+// 每个 lane 的结果与对应的 FixedFloat 运算逐位相同
+class FixedFloatBatch {
+    public:
+        static const size_t LANES = 16;
+        // limb 数不超过该值时按 lane 同步求值更快，更长的数由 Karatsuba 和 NTT 逐个计算
+        static const size_t MAX_LIMBS = 48;
+    private:
+        uint16_t base = 0;
+        uint64_t int_digit_len = 0;
+        uint64_t dec_digit_len = 0;
+        uint64_t limb_base = 0;
+        uint64_t dec_limb_len = 0;
+        uint32_t low_unit = 1;
+        uint64_t top_unit = 0;
+        uint64_t len = 0;
+        std::vector<uint32_t> limbs;
+        std::array<uint32_t, LANES> signs{}; // 每个 lane 的符号，1 为负
+        void check_format(const FixedFloatBatch& other) const;
+        // 原地加上 other，negate 为 true 时减去 other
+        void add_signed(const FixedFloatBatch& other, bool negate);
+        // 清除补齐位和溢出位，并修正 0 的符号
+        void normalize();
+    public:
+        FixedFloatBatch() = default;
+        // 与 like 格式相同、所有 lane 为 0 的一批数
+        explicit FixedFloatBatch(const FixedFloat& like);
+        // 所有 lane 都等于 f
+        static FixedFloatBatch broadcast(const FixedFloat& f);
+        // 读写第 lane 个数，格式必须相同
+        void set(size_t lane, const FixedFloat& f);
+        FixedFloat get(size_t lane) const;
+        // 第 lane 个数从最低到最高的非零数字的位数，与 Expression::effective_digits 相同，不分配内存
+        uint64_t effectiveDigits(size_t lane) const;
+        // 每个数的 limb 数
+        size_t limbCount() const { return len; }
+        FixedFloatBatch& operator+=(const FixedFloatBatch& other);
+        FixedFloatBatch& operator-=(const FixedFloatBatch& other);
+        FixedFloatBatch& operator*=(const FixedFloatBatch& other);
+};
+
+#endif
@@ -0,0 +1,142 @@
+#include "LimbAllocator.hpp"
+
+#include <atomic>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+static std::atomic<LimbAllocator::Strategy> default_strategy(LimbAllocator::Strategy::POOL);
+static std::atomic<uint64_t> heap_allocs(0), heap_frees(0), pool_hits(0), pool_returns(0);
+// the same counts for this thread only, plain integers since no other thread touches them
+static thread_local LimbAllocator::Stats thread_stats{0, 0, 0, 0};
+
+// set once the pool of this thread is destroyed, so late releases from static objects go straight to the heap
+static thread_local bool pool_dead = false;
+
+namespace {
+// free lists of one thread, the blocks are returned to the heap when the thread exits
+struct Pool {
+    std::vector<uint32_t*> free_list[LimbAllocator::MAX_CLASS + 1];
+    size_t cached_bytes = 0;
+    bool scoped = false;
+    LimbAllocator::Strategy strategy = LimbAllocator::Strategy::POOL;
+    ~Pool() {
+        pool_dead = true;
+        for (std::vector<uint32_t*> &list : free_list) {
+            for (uint32_t *p : list) {
+                free(p);
+                heap_frees.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+};
+}
+
+static thread_local Pool pool;
+
+// blocks are rounded up to a power of two so that any block of a class fits every request of it
+static size_t size_class(size_t n) {
+    size_t c = 0;
+    while (((size_t) 1 << c) < n) c++;
+    return c;
+}
+
+uint32_t *LimbAllocator::allocate(size_t n, bool zero) {
+    if (n == 0) n = 1;
+    const size_t c = size_class(n);
+    uint32_t *p = nullptr;
+    if (c <= MAX_CLASS && !pool_dead && strategy() == Strategy::POOL && !pool.free_list[c].empty()) {
+        p = pool.free_list[c].back();
+        pool.free_list[c].pop_back();
+        pool.cached_bytes -= ((size_t) 1 << c) * sizeof(uint32_t);
+        pool_hits.fetch_add(1, std::memory_order_relaxed);
+        thread_stats.pool_hits++;
+    } else {
+        p = (uint32_t *) malloc((c <= MAX_CLASS ? (size_t) 1 << c : n) * sizeof(uint32_t));
+        if (!p) throw std::bad_alloc();
+        heap_allocs.fetch_add(1, std::memory_order_relaxed);
+        thread_stats.heap_allocs++;
+    }
+    if (zero) memset(p, 0, n * sizeof(uint32_t));
+    return p;
+}
+
+size_t LimbAllocator::capacity(size_t n) {
+    if (n == 0) n = 1;
+    const size_t c = size_class(n);
+    return c <= MAX_CLASS ? (size_t) 1 << c : n;
+}
+
+void LimbAllocator::release(uint32_t *p, size_t n) {
+    if (!p) return;
+    if (n == 0) n = 1;
+    const size_t c = size_class(n);
+    // the byte budget keeps a thread that once touched many large numbers from holding on to them
+    const size_t bytes = c <= MAX_CLASS ? ((size_t) 1 << c) * sizeof(uint32_t) : 0;
+    if (c <= MAX_CLASS && !pool_dead && strategy() == Strategy::POOL && pool.free_list[c].size() < MAX_CACHED
+        && pool.cached_bytes + bytes <= MAX_CACHED_BYTES) {
+        pool.free_list[c].push_back(p);
+        pool.cached_bytes += bytes;
+        pool_returns.fetch_add(1, std::memory_order_relaxed);
+        thread_stats.pool_returns++;
+        return;
+    }
+    free(p);
+    heap_frees.fetch_add(1, std::memory_order_relaxed);
+    thread_stats.heap_frees++;
+}
+
+void LimbAllocator::setStrategy(Strategy strategy) {
+    default_strategy = strategy;
+}
+
+LimbAllocator::Strategy LimbAllocator::strategy() {
+    if (pool_dead) return Strategy::HEAP;
+    return pool.scoped ? pool.strategy : default_strategy.load(std::memory_order_relaxed);
+}
+
+void LimbAllocator::trim() {
+    if (pool_dead) return;
+    for (std::vector<uint32_t*> &list : pool.free_list) {
+        for (uint32_t *p : list) {
+            free(p);
+            heap_frees.fetch_add(1, std::memory_order_relaxed);
+        }
+        list.clear();
+    }
+    pool.cached_bytes = 0;
+}
+
+LimbAllocator::Stats LimbAllocator::stats() {
+    return {heap_allocs.load(), heap_frees.load(), pool_hits.load(), pool_returns.load()};
+}
+
+LimbAllocator::Stats LimbAllocator::threadStats() {
+    return thread_stats;
+}
+
+void LimbAllocator::resetStats() {
+    heap_allocs = 0;
+    heap_frees = 0;
+    pool_hits = 0;
+    pool_returns = 0;
+}
+
+LimbAllocator::Scope::Scope(Strategy strategy): was_scoped(pool.scoped), saved(pool.strategy) {
+    pool.scoped = true;
+    pool.strategy = strategy;
+}
+
+LimbAllocator::Scope::~Scope() {
+    // nested scopes restore the outer strategy, and whatever was cached is dropped once pooling ends
+    pool.scoped = was_scoped;
+    pool.strategy = saved;
+    if (LimbAllocator::strategy() != Strategy::POOL) trim();
+}
+
+LimbAllocator::Buffer::Buffer(size_t n, bool zero): ptr(LimbAllocator::allocate(n, zero)), n(n) {}
+
+LimbAllocator::Buffer::~Buffer() {
+    LimbAllocator::release(ptr, n);
+}
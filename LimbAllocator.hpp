@@ -0,0 +1,72 @@
+#ifndef __LIMB_ALLOCATOR_HPP__
+#define __LIMB_ALLOCATOR_HPP__
+
+#include <cstdint>
+#include <cstddef>
+
+// limb 数组的分配器，释放的数组按大小分级缓存在线程局部的池中，稳定的求值循环因此不再访问堆
+class LimbAllocator {
+    public:
+        enum class Strategy {
+            HEAP, // 每次都向堆申请和释放
+            POOL  // 优先复用线程局部池中的数组
+        };
+        // 分配统计，所有线程共享
+        struct Stats {
+            uint64_t heap_allocs;  // 向堆申请的次数
+            uint64_t heap_frees;   // 归还给堆的次数
+            uint64_t pool_hits;    // 从池中复用的次数
+            uint64_t pool_returns; // 放回池中的次数
+        };
+        // 大小分级为 2 的幂，超过最大一级的数组不进入池
+        static const size_t MAX_CLASS = 20;
+        // 每个线程每一级最多缓存的数组数
+        static const size_t MAX_CACHED = 64;
+        // 每个线程缓存的数组总字节数上限，超出时直接归还给堆
+        static const size_t MAX_CACHED_BYTES = (size_t) 4 << 20;
+
+        // 在作用域内为当前线程切换分配策略，离开时恢复；恢复后不再使用池时把缓存的数组归还给堆，可作为一次求值的 arena
+        class Scope {
+            private:
+                bool was_scoped;
+                Strategy saved;
+            public:
+                explicit Scope(Strategy strategy);
+                ~Scope();
+                Scope(const Scope&) = delete;
+                Scope& operator=(const Scope&) = delete;
+        };
+        // 独占一段 limb 的临时缓冲区，析构时释放
+        class Buffer {
+            private:
+                uint32_t *ptr;
+                size_t n;
+            public:
+                explicit Buffer(size_t n, bool zero = true);
+                ~Buffer();
+                Buffer(const Buffer&) = delete;
+                Buffer& operator=(const Buffer&) = delete;
+                uint32_t *data() { return ptr; }
+                size_t size() const { return n; }
+                uint32_t& operator[](size_t i) { return ptr[i]; }
+        };
+
+        // 分配 n 个 limb，zero 为 true 时清零
+        static uint32_t *allocate(size_t n, bool zero = true);
+        // allocate(n) 实际分配的 limb 数
+        static size_t capacity(size_t n);
+        // 释放 allocate(n) 得到的数组，可以在任意线程释放
+        static void release(uint32_t *p, size_t n);
+        // 设置默认策略，对没有 Scope 的线程生效
+        static void setStrategy(Strategy strategy);
+        // 当前线程使用的策略
+        static Strategy strategy();
+        // 把当前线程池中的数组全部归还给堆
+        static void trim();
+        static Stats stats();
+        // 当前线程的分配统计，不受 resetStats 影响，用两次读数之差统计一段代码
+        static Stats threadStats();
+        static void resetStats();
+};
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef __LIMB_ARITH_HPP__
+#define __LIMB_ARITH_HPP__
+
+#include <cstdint>
+#include <cstddef>
+
+// 以 limb_base 为基数的无符号大数的基本运算，数组从低位到高位存储
+class LimbArith {
+    public:
+        // 把一个宽整数拆分为当前 limb 和向高位的进位
+        static inline uint32_t split(uint64_t val, uint64_t limb_base, uint64_t &carry) {
+            if (limb_base == ((uint64_t) 1 << 32)) { // power-of-two bases fill the whole word
+                carry = val >> 32;
+                return (uint32_t) val;
+            }
+            carry = val / limb_base;
+            return (uint32_t) (val - carry * limb_base);
+        }
+        // r = a + b，长度均为 n，返回最高位的进位
+        static inline uint32_t add(const uint32_t *a, const uint32_t *b, uint32_t *r, size_t n, uint64_t limb_base) {
+            uint64_t carry = 0;
+            for (size_t i = 0; i < n; i++) {
+                uint64_t val = (uint64_t) a[i] + b[i] + carry;
+                carry = val >= limb_base;
+                r[i] = (uint32_t) (val - (carry ? limb_base : 0));
+            }
+            return (uint32_t) carry;
+        }
+        // r = a - b，长度均为 n，返回最高位的借位
+        static inline uint32_t sub(const uint32_t *a, const uint32_t *b, uint32_t *r, size_t n, uint64_t limb_base) {
+            uint64_t borrow = 0;
+            for (size_t i = 0; i < n; i++) {
+                uint64_t sub = (uint64_t) b[i] + borrow;
+                borrow = a[i] < sub;
+                r[i] = (uint32_t) (a[i] + (borrow ? limb_base : 0) - sub);
+            }
+            return (uint32_t) borrow;
+        }
+        // r += a，r 的长度为 rn，a 的长度为 an <= rn，返回溢出的进位
+        static inline uint32_t add_in(uint32_t *r, size_t rn, const uint32_t *a, size_t an, uint64_t limb_base) {
+            uint64_t carry = 0;
+            size_t i = 0;
+            for (; i < an; i++) {
+                uint64_t val = (uint64_t) r[i] + a[i] + carry;
+                carry = val >= limb_base;
+                r[i] = (uint32_t) (val - (carry ? limb_base : 0));
+            }
+            for (; carry && i < rn; i++) {
+                uint64_t val = (uint64_t) r[i] + carry;
+                carry = val >= limb_base;
+                r[i] = (uint32_t) (val - (carry ? limb_base : 0));
+            }
+            return (uint32_t) carry;
+        }
+        // r -= a，r 的长度为 rn，a 的长度为 an <= rn，返回溢出的借位
+        static inline uint32_t sub_in(uint32_t *r, size_t rn, const uint32_t *a, size_t an, uint64_t limb_base) {
+            uint64_t borrow = 0;
+            size_t i = 0;
+            for (; i < an; i++) {
+                uint64_t sub = (uint64_t) a[i] + borrow;
+                borrow = r[i] < sub;
+                r[i] = (uint32_t) (r[i] + (borrow ? limb_base : 0) - sub);
+            }
+            for (; borrow && i < rn; i++) {
+                borrow = r[i] == 0;
+                r[i] = (uint32_t) (borrow ? limb_base - 1 : r[i] - 1);
+            }
+            return (uint32_t) borrow;
+        }
+        // 比较两个长度为 n 的大数，返回 -1, 0, 1
+        static inline int compare(const uint32_t *a, const uint32_t *b, size_t n) {
+            for (size_t i = n; i > 0; i--) {
+                if (a[i - 1] != b[i - 1]) return a[i - 1] < b[i - 1] ? -1 : 1;
+            }
+            return 0;
+        }
+};
+
+#endif
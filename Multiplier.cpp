@@ -0,0 +1,244 @@
+#include "Multiplier.hpp"
+#include "LimbArith.hpp"
+#include "LimbAllocator.hpp"
+
+#include <vector>
+#include <cstring>
+#include <chrono>
+#include <random>
+#include <algorithm>
+
+size_t Multiplier::karatsuba_threshold = 32;
+size_t Multiplier::ntt_threshold = 1024;
+
+// the three NTT primes, each of the form c * 2^k + 1 with primitive root 3
+static const uint32_t NTT_PRIMES[3] = {998244353, 167772161, 469762049};
+// the longest transform supported by all three primes
+static const size_t NTT_MAX_LEN = (size_t) 1 << 23;
+// with at most 2^21 terms per coefficient the convolution stays below p1 * p2 * p3 (about 2^86)
+static const size_t NTT_MAX_TERMS = (size_t) 1 << 21;
+
+static uint64_t pow_mod(uint64_t a, uint64_t e, uint64_t m) {
+    uint64_t ret = 1;
+    a %= m;
+    while (e) {
+        if (e & 1) ret = ret * a % m;
+        a = a * a % m;
+        e >>= 1;
+    }
+    return ret;
+}
+
+// in-place iterative number theoretic transform modulo p
+static void transform(std::vector<uint32_t> &v, uint32_t p, bool invert) {
+    const size_t n = v.size();
+    for (size_t i = 1, j = 0; i < n; i++) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) std::swap(v[i], v[j]);
+    }
+    // twiddles with their Shoup factors floor(w * 2^32 / p), so each butterfly needs no division
+    std::vector<uint32_t> roots(n / 2 + 1), shoup(n / 2 + 1);
+    for (size_t len = 2; len <= n; len <<= 1) {
+        uint64_t w = pow_mod(3, (p - 1) / len, p);
+        if (invert) w = pow_mod(w, p - 2, p);
+        const size_t half = len >> 1;
+        roots[0] = 1;
+        for (size_t i = 1; i < half; i++) roots[i] = (uint32_t) ((uint64_t) roots[i - 1] * w % p);
+        for (size_t i = 0; i < half; i++) shoup[i] = (uint32_t) (((uint64_t) roots[i] << 32) / p);
+        for (size_t i = 0; i < n; i += len) {
+            for (size_t j = 0; j < half; j++) {
+                uint32_t u = v[i + j], x = v[i + j + half];
+                uint32_t q = (uint32_t) (((uint64_t) x * shoup[j]) >> 32);
+                uint32_t t = x * roots[j] - q * p; // in [0, 2p)
+                if (t >= p) t -= p;
+                v[i + j] = u + t >= p ? u + t - p : u + t;
+                v[i + j + half] = u >= t ? u - t : u + p - t;
+            }
+        }
+    }
+    if (invert) {
+        uint64_t inv_n = pow_mod(n, p - 2, p);
+        for (size_t i = 0; i < n; i++) v[i] = (uint32_t) (v[i] * inv_n % p);
+    }
+}
+
+void Multiplier::mul(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *r, uint64_t limb_base) {
+    size_t n = std::min(na, nb);
+    if (n < karatsuba_threshold) schoolbook(a, na, b, nb, r, limb_base);
+    else if (n < ntt_threshold) karatsuba(a, na, b, nb, r, limb_base);
+    else ntt(a, na, b, nb, r, limb_base);
+}
+
+void Multiplier::schoolbook(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *r, uint64_t limb_base) {
+    memset(r, 0, (na + nb) * sizeof(uint32_t));
+    for (size_t i = 0; i < na; i++) {
+        if (!a[i]) continue;
+        uint64_t carry = 0;
+        for (size_t j = 0; j < nb; j++) {
+            // (B - 1)^2 + 2(B - 1) = B^2 - 1 always fits in 64 bits
+            uint64_t val = (uint64_t) a[i] * b[j] + r[i + j] + carry;
+            r[i + j] = LimbArith::split(val, limb_base, carry);
+        }
+        r[i + nb] = (uint32_t) carry;
+    }
+}
+
+void Multiplier::karatsuba_rec(const uint32_t *a, const uint32_t *b, size_t n, uint32_t *r, uint64_t limb_base) {
+    if (n < karatsuba_threshold || n < 2) {
+        schoolbook(a, n, b, n, r, limb_base);
+        return;
+    }
+    // a = a1 * B^m + a0, b = b1 * B^m + b0
+    const size_t m = n / 2, h = n - m;
+    // z0 = a0 * b0 goes to r[0, 2m), z2 = a1 * b1 goes to r[2m, 2n)
+    karatsuba_rec(a, b, m, r, limb_base);
+    if (m == h) karatsuba_rec(a + m, b + m, h, r + 2 * m, limb_base);
+    else mul(a + m, h, b + m, h, r + 2 * m, limb_base);
+
+    // z1 = (a0 + a1)(b0 + b1) - z0 - z2
+    LimbAllocator::Buffer sa(h + 1), sb(h + 1), z1(2 * h + 2);
+    memcpy(sa.data(), a + m, h * sizeof(uint32_t));
+    memcpy(sb.data(), b + m, h * sizeof(uint32_t));
+    LimbArith::add_in(sa.data(), h + 1, a, m, limb_base);
+    LimbArith::add_in(sb.data(), h + 1, b, m, limb_base);
+    size_t sn = sa[h] || sb[h] ? h + 1 : h;
+    if (sn == h && h == m) karatsuba_rec(sa.data(), sb.data(), h, z1.data(), limb_base);
+    else mul(sa.data(), sn, sb.data(), sn, z1.data(), limb_base);
+    LimbArith::sub_in(z1.data(), z1.size(), r, 2 * m, limb_base);
+    LimbArith::sub_in(z1.data(), z1.size(), r + 2 * m, 2 * h, limb_base);
+
+    // r += z1 * B^m, z1 is less than B^(n + 1) so it never carries out of r
+    size_t zn = z1.size();
+    while (zn && !z1[zn - 1]) zn--;
+    LimbArith::add_in(r + m, 2 * n - m, z1.data(), std::min(zn, 2 * n - m), limb_base);
+}
+
+void Multiplier::karatsuba(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *r, uint64_t limb_base) {
+    if (na < nb) {
+        std::swap(a, b);
+        std::swap(na, nb);
+    }
+    if (na == nb) {
+        karatsuba_rec(a, b, na, r, limb_base);
+        return;
+    }
+    // unbalanced operands are cut into nb-sized chunks of a
+    memset(r, 0, (na + nb) * sizeof(uint32_t));
+    LimbAllocator::Buffer tmp(2 * nb, false);
+    for (size_t i = 0; i < na; i += nb) {
+        size_t chunk = std::min(nb, na - i);
+        if (chunk == nb) karatsuba_rec(a + i, b, nb, tmp.data(), limb_base);
+        else mul(a + i, chunk, b, nb, tmp.data(), limb_base);
+        LimbArith::add_in(r + i, na + nb - i, tmp.data(), chunk + nb, limb_base);
+    }
+}
+
+void Multiplier::ntt(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *r, uint64_t limb_base) {
+    size_t n = 1;
+    while (n < na + nb) n <<= 1;
+    if (n > NTT_MAX_LEN || std::min(na, nb) > NTT_MAX_TERMS) {
+        karatsuba(a, na, b, nb, r, limb_base);
+        return;
+    }
+
+    // convolve the limbs modulo each prime
+    std::vector<uint32_t> res[3];
+    for (int k = 0; k < 3; k++) {
+        const uint32_t p = NTT_PRIMES[k];
+        std::vector<uint32_t> fa(n, 0), fb(n, 0);
+        for (size_t i = 0; i < na; i++) fa[i] = a[i] % p;
+        for (size_t i = 0; i < nb; i++) fb[i] = b[i] % p;
+        transform(fa, p, false);
+        transform(fb, p, false);
+        for (size_t i = 0; i < n; i++) fa[i] = (uint32_t) ((uint64_t) fa[i] * fb[i] % p);
+        transform(fa, p, true);
+        res[k] = std::move(fa);
+    }
+
+    // recombine with the chinese remainder theorem and propagate the carries in limb_base
+    const uint64_t p0 = NTT_PRIMES[0], p1 = NTT_PRIMES[1], p2 = NTT_PRIMES[2];
+    const uint64_t inv_p0 = pow_mod(p0, p1 - 2, p1);
+    const uint64_t inv_p01 = pow_mod(p0 * p1 % p2, p2 - 2, p2);
+    const unsigned __int128 p01 = (unsigned __int128) p0 * p1;
+    unsigned __int128 carry = 0;
+    for (size_t i = 0; i < na + nb; i++) {
+        uint64_t x0 = res[0][i];
+        uint64_t t1 = (res[1][i] + p1 - x0 % p1) % p1 * inv_p0 % p1;
+        uint64_t x01 = x0 + p0 * t1; // < p0 * p1
+        uint64_t t2 = (res[2][i] + p2 - x01 % p2) % p2 * inv_p01 % p2;
+        carry += x01 + p01 * t2;
+        if (limb_base == ((uint64_t) 1 << 32)) {
+            r[i] = (uint32_t) carry;
+            carry >>= 32;
+        } else {
+            unsigned __int128 q = carry / limb_base;
+            r[i] = (uint32_t) (carry - q * limb_base);
+            carry = q;
+        }
+    }
+}
+
+void Multiplier::tune(std::ostream &out) {
+    typedef void (*MulFn)(const uint32_t *, size_t, const uint32_t *, size_t, uint32_t *, uint64_t);
+    const uint64_t limb_base = 1000000000; // decimal limbs are the common case
+    std::mt19937 rng(12345);
+    // average time of one n x n multiplication in microseconds
+    const auto measure = [&] (MulFn fn, size_t n) {
+        std::vector<uint32_t> a(n), b(n), r(2 * n);
+        for (size_t i = 0; i < n; i++) {
+            a[i] = rng() % limb_base;
+            b[i] = rng() % limb_base;
+        }
+        size_t reps = 0;
+        auto start = std::chrono::steady_clock::now();
+        double elapsed = 0;
+        do {
+            fn(a.data(), n, b.data(), n, r.data(), limb_base);
+            reps++;
+            elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        } while (elapsed < 20000 && reps < 100000);
+        return elapsed / reps;
+    };
+
+    const size_t old_karatsuba = karatsuba_threshold, old_ntt = ntt_threshold;
+    std::vector<size_t> sizes;
+    for (size_t n = 8; n <= 8192; n *= 2) {
+        sizes.push_back(n);
+        sizes.push_back(n * 3 / 2);
+    }
+
+    // one level of karatsuba over schoolbook halves against plain schoolbook
+    size_t karatsuba_cross = 0;
+    ntt_threshold = SIZE_MAX;
+    out << "algorithm,limbs,baseline_us,candidate_us" << '\n';
+    for (size_t n : sizes) {
+        if (n > 1024) break;
+        karatsuba_threshold = n;
+        double s = measure(schoolbook, n);
+        double k = measure(karatsuba, n);
+        out << "karatsuba," << n << ',' << s << ',' << k << '\n';
+        if (k < s) {
+            karatsuba_cross = n;
+            break;
+        }
+    }
+    karatsuba_threshold = karatsuba_cross ? karatsuba_cross : old_karatsuba;
+
+    // full karatsuba with the new threshold against NTT
+    size_t ntt_cross = 0;
+    for (size_t n : sizes) {
+        if (n < karatsuba_threshold) continue;
+        double k = measure(karatsuba, n);
+        double t = measure(ntt, n);
+        out << "ntt," << n << ',' << k << ',' << t << '\n';
+        if (t < k) {
+            ntt_cross = n;
+            break;
+        }
+    }
+    ntt_threshold = ntt_cross ? ntt_cross : old_ntt;
+    out << "karatsuba_threshold," << karatsuba_threshold << '\n';
+    out << "ntt_threshold," << ntt_threshold << '\n';
+}
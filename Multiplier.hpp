@@ -0,0 +1,31 @@
+#ifndef __MULTIPLIER_HPP__
+#define __MULTIPLIER_HPP__
+
+#include <cstdint>
+#include <cstddef>
+#include <ostream>
+
+// 大数乘法引擎，根据操作数的 limb 数自动在朴素乘法、Karatsuba 和 NTT 之间选择
+class Multiplier {
+    private:
+        // 对 a, b 逐项做 Karatsuba 递归，na == nb
+        static void karatsuba_rec(const uint32_t *a, const uint32_t *b, size_t n, uint32_t *r, uint64_t limb_base);
+    public:
+        // 较短的操作数达到该 limb 数时使用 Karatsuba
+        static size_t karatsuba_threshold;
+        // 较短的操作数达到该 limb 数时使用 NTT
+        static size_t ntt_threshold;
+
+        // r = a * b，r 必须有 na + nb 个 limb，且不能与 a, b 重叠
+        static void mul(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *r, uint64_t limb_base);
+        // 朴素乘法，O(na * nb)
+        static void schoolbook(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *r, uint64_t limb_base);
+        // Karatsuba 乘法，O(n^1.585)，长度不同时按短的操作数分块
+        static void karatsuba(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *r, uint64_t limb_base);
+        // 三模数 NTT 乘法，O(n log n)，操作数过长时退回 Karatsuba
+        static void ntt(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *r, uint64_t limb_base);
+        // 在本机上测量各算法的交叉点，更新阈值并把测量结果输出到 out
+        static void tune(std::ostream &out);
+};
+
+#endif
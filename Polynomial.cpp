@@ -0,0 +1,294 @@
+#include "Polynomial.hpp"
+#include "LimbArith.hpp"
+#include "Multiplier.hpp"
+#include "LimbAllocator.hpp"
+
+#include <utility>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+void Polynomial::trim() {
+    // the constant term is kept even if it is zero so that the format is not lost
+    while (coeffs.size() > 1 && coeffs.back().isZero()) coeffs.pop_back();
+}
+
+FixedFloat Polynomial::zero() const {
+    return FixedFloat(coeffs[0].base, coeffs[0].int_digit_len, coeffs[0].dec_digit_len);
+}
+
+Polynomial::Polynomial(std::vector<FixedFloat> coeffs): coeffs(std::move(coeffs)) {
+    trim();
+}
+
+Polynomial Polynomial::constant(const FixedFloat& c) {
+    return Polynomial(std::vector<FixedFloat>(1, c));
+}
+
+Polynomial Polynomial::variable(const FixedFloat& like) {
+    std::vector<FixedFloat> coeffs(2, FixedFloat(like.getBase(), like.getIntDigitLen(), like.getDecDigitLen()));
+    coeffs[1] = FixedFloat(like.getBase(), like.getIntDigitLen(), like.getDecDigitLen(), 1.0);
+    return Polynomial(std::move(coeffs));
+}
+
+size_t Polynomial::degree() const {
+    return coeffs.empty() ? 0 : coeffs.size() - 1;
+}
+
+bool Polynomial::isConstant() const {
+    return coeffs.size() <= 1;
+}
+
+const std::vector<FixedFloat>& Polynomial::coefficients() const {
+    return coeffs;
+}
+
+Polynomial Polynomial::operator+(const Polynomial& other) const {
+    const Polynomial &longer = coeffs.size() >= other.coeffs.size() ? *this : other;
+    const Polynomial &shorter = coeffs.size() >= other.coeffs.size() ? other : *this;
+    std::vector<FixedFloat> ret = longer.coeffs;
+    for (size_t i = 0; i < shorter.coeffs.size(); i++) ret[i] += shorter.coeffs[i];
+    return Polynomial(std::move(ret));
+}
+
+Polynomial Polynomial::operator-(const Polynomial& other) const {
+    std::vector<FixedFloat> ret = coeffs;
+    for (size_t i = 0; i < other.coeffs.size(); i++) {
+        if (i < ret.size()) ret[i] -= other.coeffs[i];
+        else ret.push_back(-other.coeffs[i]);
+    }
+    return Polynomial(std::move(ret));
+}
+
+Polynomial Polynomial::operator*(const Polynomial& other) const {
+    if (coeffs.empty() || other.coeffs.empty()) return Polynomial();
+    if (std::min(coeffs.size(), other.coeffs.size()) > KRONECKER_THRESHOLD) return mul_kronecker(*this, other);
+    return mul_schoolbook(*this, other);
+}
+
+Polynomial Polynomial::mul_schoolbook(const Polynomial& a, const Polynomial& b) {
+    const FixedFloat &like = a.coeffs[0];
+    const uint64_t limb_base = like.limb_base;
+    const size_t len = like.len, n = a.coeffs.size() + b.coeffs.size() - 1, w = 2 * len + 2;
+    // the exact products are summed into slots like mul_kronecker builds them, so both paths truncate once per coefficient
+    std::vector<uint32_t> pos(n * w, 0), neg(n * w, 0);
+    LimbAllocator::Buffer prod(2 * len, false);
+    for (size_t i = 0; i < a.coeffs.size(); i++) {
+        const FixedFloat &x = a.coeffs[i];
+        if (x.isZero()) continue;
+        for (size_t j = 0; j < b.coeffs.size(); j++) {
+            const FixedFloat &y = b.coeffs[j];
+            if (y.isZero()) continue;
+            // only the nonzero limb windows are multiplied
+            const size_t xn = x.hi_limb - x.lo_limb, yn = y.hi_limb - y.lo_limb;
+            Multiplier::mul(x.arr + x.lo_limb, xn, y.arr + y.lo_limb, yn, prod.data(), limb_base);
+            const size_t off = x.lo_limb + y.lo_limb;
+            uint32_t *slot = (x.sign != y.sign ? neg : pos).data() + (i + j) * w;
+            LimbArith::add_in(slot + off, w - off, prod.data(), xn + yn, limb_base);
+        }
+    }
+    return truncate_slots(pos.data(), neg.data(), w, n, like);
+}
+
+Polynomial Polynomial::mul_kronecker(const Polynomial& a, const Polynomial& b) {
+    const FixedFloat &like = a.coeffs[0];
+    const uint64_t limb_base = like.limb_base;
+    const size_t len = like.len, n = a.coeffs.size() + b.coeffs.size() - 1;
+    // each slot holds a sum of at most min(na, nb) < limb_base products of two len-limb numbers, so it fits in w - 1 limbs
+    const size_t w = 2 * len + 2;
+    // a polynomial evaluated at limb_base^w as one signed integer, the difference of its positive and negative coefficients
+    const auto pack = [&] (const Polynomial& p, std::vector<uint32_t>& out) {
+        std::vector<uint32_t> pos(p.coeffs.size() * w, 0), neg(p.coeffs.size() * w, 0);
+        for (size_t i = 0; i < p.coeffs.size(); i++) {
+            const FixedFloat &c = p.coeffs[i];
+            memcpy((c.sign ? neg : pos).data() + i * w, c.arr, len * sizeof(uint32_t));
+        }
+        out.resize(pos.size());
+        const bool negative = LimbArith::compare(pos.data(), neg.data(), pos.size()) < 0;
+        if (negative) LimbArith::sub(neg.data(), pos.data(), out.data(), out.size(), limb_base);
+        else LimbArith::sub(pos.data(), neg.data(), out.data(), out.size(), limb_base);
+        return negative;
+    };
+    std::vector<uint32_t> ap, bp;
+    const bool negative = pack(a, ap) != pack(b, bp);
+    std::vector<uint32_t> prod(ap.size() + bp.size());
+    Multiplier::mul(ap.data(), ap.size(), bp.data(), bp.size(), prod.data(), limb_base);
+
+    // the slots of the product are balanced digits: a slot with a nonzero top limb stands for slot - limb_base^w
+    // and borrows one from the slot above, which is the case exactly when its coefficient has the other sign
+    std::vector<uint32_t> pos(n * w, 0), neg(n * w, 0), zero(w, 0), slot(w);
+    uint32_t borrow = 0;
+    for (size_t k = 0; k < n; k++) {
+        memcpy(slot.data(), prod.data() + k * w, w * sizeof(uint32_t));
+        // a slot of all limb_base - 1 plus the borrow wraps to 0 and passes the borrow on
+        const uint32_t carry = borrow ? LimbArith::add_in(slot.data(), w, &borrow, 1, limb_base) : 0;
+        const bool flip = slot[w - 1] != 0;
+        borrow = carry || flip;
+        uint32_t *dst = (flip != negative ? neg : pos).data() + k * w;
+        if (flip) LimbArith::sub(zero.data(), slot.data(), dst, w, limb_base);
+        else memcpy(dst, slot.data(), w * sizeof(uint32_t));
+    }
+    return truncate_slots(pos.data(), neg.data(), w, n, like);
+}
+
+Polynomial Polynomial::truncate_slots(const uint32_t *pos, const uint32_t *neg, size_t w, size_t n, const FixedFloat& like) {
+    std::vector<FixedFloat> ret(n, FixedFloat(like.base, like.int_digit_len, like.dec_digit_len));
+    std::vector<uint32_t> diff(w);
+    for (size_t k = 0; k < n; k++) {
+        const uint32_t *p = pos + k * w, *q = neg + k * w;
+        bool negative = LimbArith::compare(p, q, w) < 0;
+        if (negative) LimbArith::sub(q, p, diff.data(), w, like.limb_base);
+        else LimbArith::sub(p, q, diff.data(), w, like.limb_base);
+        // the slot is scaled twice, drop dec_limb_len limbs and the overflowing high limbs like operator*
+        FixedFloat &c = ret[k];
+        memcpy(c.arr, diff.data() + like.dec_limb_len, like.len * sizeof(uint32_t));
+        c.sign = negative;
+        c.normalize();
+    }
+    return Polynomial(std::move(ret));
+}
+
+Polynomial Polynomial::operator/(const FixedFloat& c) const {
+    std::vector<FixedFloat> ret = coeffs;
+    for (FixedFloat &coeff : ret) coeff = coeff / c;
+    return Polynomial(std::move(ret));
+}
+
+Polynomial Polynomial::pow(uint64_t n) const {
+    // constants keep the precision of FixedFloat::pow
+    if (coeffs.empty()) return Polynomial();
+    if (isConstant()) return constant(coeffs[0].pow(n));
+    Polynomial ret = constant(FixedFloat(coeffs[0].getBase(), coeffs[0].getIntDigitLen(), coeffs[0].getDecDigitLen(), 1.0));
+    Polynomial sqr = *this;
+    while (n) {
+        if (n & 1) ret = ret * sqr;
+        n >>= 1;
+        if (n) sqr = sqr * sqr;
+    }
+    return ret;
+}
+
+FixedFloat Polynomial::eval(const FixedFloat& x) const {
+    if (coeffs.empty()) return FixedFloat(x.getBase(), x.getIntDigitLen(), x.getDecDigitLen());
+    FixedFloat ret = coeffs.back();
+    for (size_t i = coeffs.size() - 1; i > 0; i--) {
+        ret *= x;
+        ret += coeffs[i - 1];
+    }
+    return ret;
+}
+
+void Polynomial::evalWithDerivative(const FixedFloat& x, FixedFloat& value, FixedFloat& derivative) const {
+    derivative = FixedFloat(x.getBase(), x.getIntDigitLen(), x.getDecDigitLen());
+    if (coeffs.empty()) {
+        value = derivative;
+        return;
+    }
+    // the derivative takes the partial Horner value before it is advanced, (q * x + c)' = q' * x + q
+    value = coeffs.back();
+    for (size_t i = coeffs.size() - 1; i > 0; i--) {
+        derivative *= x;
+        derivative += value;
+        value *= x;
+        value += coeffs[i - 1];
+    }
+}
+
+Polynomial Polynomial::truncated(size_t k) const {
+    if (coeffs.size() <= k) return *this;
+    return Polynomial(std::vector<FixedFloat>(coeffs.begin(), coeffs.begin() + k));
+}
+
+Polynomial Polynomial::reversed(size_t n) const {
+    std::vector<FixedFloat> ret(n + 1, zero());
+    for (size_t i = 0; i < coeffs.size() && i <= n; i++) ret[n - i] = coeffs[i];
+    return Polynomial(std::move(ret));
+}
+
+Polynomial Polynomial::inverse_series(const Polynomial& f, size_t k) {
+    const FixedFloat &like = f.coeffs[0];
+    const Polynomial one = constant(FixedFloat(like.base, like.int_digit_len, like.dec_digit_len, 1.0));
+    // g <- g + g (1 - f g) doubles the number of correct terms, 1 - f g starts at the first wrong one
+    Polynomial g = one;
+    for (size_t prec = 1; prec < k; ) {
+        prec = std::min(2 * prec, k);
+        const Polynomial e = one - (f.truncated(prec) * g).truncated(prec);
+        g = g + (g * e).truncated(prec);
+    }
+    return g;
+}
+
+Polynomial Polynomial::mod_monic(const Polynomial& m) const {
+    const size_t d = m.coeffs.size() - 1;
+    if (coeffs.size() <= d) return *this;
+    // p = q m + r with deg r < d, reversed this is rev(p) = rev(q) rev(m) mod x^k, and rev(m) starts with 1
+    const size_t n = coeffs.size() - 1, k = n - d + 1;
+    const Polynomial q = (reversed(n).truncated(k) * inverse_series(m.reversed(d).truncated(k), k)).truncated(k).reversed(k - 1);
+    return (*this - q * m).truncated(d);
+}
+
+void Polynomial::build_subproducts(std::vector<Polynomial>& tree, size_t k, const FixedFloat *xs, size_t lo, size_t hi) {
+    if (hi - lo <= MULTIPOINT_LEAF) {
+        const FixedFloat one(xs[lo].base, xs[lo].int_digit_len, xs[lo].dec_digit_len, 1.0);
+        Polynomial r = constant(one);
+        for (size_t i = lo; i < hi; i++) r = r * Polynomial(std::vector<FixedFloat>{-xs[i], one});
+        tree[k] = std::move(r);
+        return;
+    }
+    const size_t mid = lo + (hi - lo) / 2;
+    build_subproducts(tree, 2 * k + 1, xs, lo, mid);
+    build_subproducts(tree, 2 * k + 2, xs, mid, hi);
+    tree[k] = tree[2 * k + 1] * tree[2 * k + 2];
+}
+
+void Polynomial::descend_remainders(const std::vector<Polynomial>& tree, size_t k, const Polynomial& r, const FixedFloat *xs, size_t lo, size_t hi, FixedFloat *out) {
+    if (hi - lo <= MULTIPOINT_LEAF) {
+        for (size_t i = lo; i < hi; i++) out[i] = r.eval(xs[i]);
+        return;
+    }
+    const size_t mid = lo + (hi - lo) / 2;
+    descend_remainders(tree, 2 * k + 1, r.mod_monic(tree[2 * k + 1]), xs, lo, mid, out);
+    descend_remainders(tree, 2 * k + 2, r.mod_monic(tree[2 * k + 2]), xs, mid, hi, out);
+}
+
+std::vector<FixedFloat> Polynomial::evalMultipoint(std::span<const FixedFloat> xs) const {
+    std::vector<FixedFloat> ret;
+    if (xs.empty()) return ret;
+    const FixedFloat &like = xs[0];
+    ret.reserve(xs.size());
+    if (coeffs.empty()) {
+        for (const FixedFloat &x : xs) ret.push_back(eval(x));
+        return ret;
+    }
+    double radius = 0;
+    for (const FixedFloat &x : xs) radius = std::max(radius, std::fabs(x.doubleValue()));
+    // the subproducts, quotients and remainders are computed with guard digits on both sides of the point
+    const uint64_t guard = multipointGuard(degree(), xs.size(), radius, like.base);
+    const uint64_t int_len = like.int_digit_len + guard, dec_len = like.dec_digit_len + guard;
+    std::vector<FixedFloat> wide;
+    wide.reserve(xs.size());
+    for (const FixedFloat &x : xs) wide.push_back(x.convertTo(like.base, int_len, dec_len));
+    std::vector<Polynomial> tree(4 * (xs.size() / MULTIPOINT_LEAF + 1));
+    build_subproducts(tree, 0, wide.data(), 0, wide.size());
+    std::vector<FixedFloat> out(wide.size(), FixedFloat(like.base, int_len, dec_len));
+    descend_remainders(tree, 0, convertTo(like.base, int_len, dec_len).mod_monic(tree[0]), wide.data(), 0, wide.size(), out.data());
+    for (const FixedFloat &v : out) ret.push_back(v.convertTo(like.base, like.int_digit_len, like.dec_digit_len));
+    return ret;
+}
+
+uint64_t Polynomial::multipointGuard(size_t degree, size_t points, double radius, uint16_t base) {
+    // with every point in [-r, r] the subproducts have coefficients below (1 + r)^n, the series inverses and quotients
+    // below (2 (1 + r))^(2n) on each level, and the levels below the root add up to less than the root;
+    // every truncation error is amplified by no more than that growth
+    const double n = (double) std::max<size_t>(degree + 1, points);
+    const double digits = (6 * n * std::log(2 * (1 + radius)) + std::log(2 * n)) / std::log((double) base) + 2;
+    if (!(digits < (double) FixedFloat::MAX_DIGIT_LEN)) return FixedFloat::MAX_DIGIT_LEN;
+    return (uint64_t) std::ceil(digits);
+}
+
+Polynomial Polynomial::convertTo(uint16_t base, uint64_t int_digit_len, uint64_t dec_digit_len) const {
+    std::vector<FixedFloat> ret;
+    ret.reserve(coeffs.size());
+    for (const FixedFloat &c : coeffs) ret.push_back(c.convertTo(base, int_digit_len, dec_digit_len));
+    return Polynomial(std::move(ret));
+}
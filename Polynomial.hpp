@@ -0,0 +1,80 @@
+#ifndef __POLYNOMIAL_HPP__
+#define __POLYNOMIAL_HPP__
+
+#include <cstdint>
+#include <vector>
+#include <span>
+#include "FixedFloat.hpp"
+
+// 以 FixedFloat 为系数的一元多项式，所有系数的格式相同
+class Polynomial {
+    public:
+        // 两个因子的次数都不低于该值时使用 Kronecker 代换做乘法
+        static const size_t KRONECKER_THRESHOLD = 12;
+        // 子积树的叶子最多包含的点数，叶子上的余式直接用 Horner 法则求值
+        static const size_t MULTIPOINT_LEAF = 8;
+    private:
+        // coeffs[i] 为 x^i 的系数，为空时表示没有格式的 0
+        std::vector<FixedFloat> coeffs;
+        // 去掉为 0 的最高次系数，常数项总是保留
+        void trim();
+        // 与系数格式相同的 0
+        FixedFloat zero() const;
+        // 朴素乘法，O(n * m) 次系数乘法，每个系数的精确乘积之和只截断一次
+        static Polynomial mul_schoolbook(const Polynomial& a, const Polynomial& b);
+        // Kronecker 代换，把系数打包为大整数后只做 4 次大数乘法，结果与 mul_schoolbook 逐位相同
+        static Polynomial mul_kronecker(const Polynomial& a, const Polynomial& b);
+        // 把 n 个宽为 w 的槽中的 pos - neg 截断为与 like 格式相同的系数，槽中的值带两次小数部分的缩放
+        static Polynomial truncate_slots(const uint32_t *pos, const uint32_t *neg, size_t w, size_t n, const FixedFloat& like);
+        // 只保留 x^0 到 x^(k-1) 的系数
+        Polynomial truncated(size_t k) const;
+        // 把 x^0 到 x^n 的系数倒序，即 x^n p(1/x)
+        Polynomial reversed(size_t n) const;
+        // 常数项为 1 的 f 的幂级数倒数的前 k 项，用 Newton 迭代求出
+        static Polynomial inverse_series(const Polynomial& f, size_t k);
+        // 除以首一多项式 m 的余式，商由倒序后的幂级数倒数求出，只需常数次多项式乘法
+        Polynomial mod_monic(const Polynomial& m) const;
+        // 子积树中 [lo, hi) 的点的节点，tree[k] 为 (x - xs[lo]) ... (x - xs[hi - 1])
+        static void build_subproducts(std::vector<Polynomial>& tree, size_t k, const FixedFloat *xs, size_t lo, size_t hi);
+        // 余式树：r 已经对 tree[k] 取过余，向下取余直到叶子，再在叶子的点上求值
+        static void descend_remainders(const std::vector<Polynomial>& tree, size_t k, const Polynomial& r, const FixedFloat *xs, size_t lo, size_t hi, FixedFloat *out);
+    public:
+        // 构造 0 多项式
+        Polynomial() = default;
+        // 通过系数构造，coeffs[i] 为 x^i 的系数
+        Polynomial(std::vector<FixedFloat> coeffs);
+        // 构造常数多项式
+        static Polynomial constant(const FixedFloat& c);
+        // 构造多项式 x，系数的格式与 like 相同
+        static Polynomial variable(const FixedFloat& like);
+        // 返回次数，0 多项式的次数为 0
+        size_t degree() const;
+        // 判断是否为常数
+        bool isConstant() const;
+        // 返回所有系数
+        const std::vector<FixedFloat>& coefficients() const;
+        // 两多项式相加
+        Polynomial operator+(const Polynomial& other) const;
+        // 两多项式相减
+        Polynomial operator-(const Polynomial& other) const;
+        // 两多项式相乘
+        Polynomial operator*(const Polynomial& other) const;
+        // 除以一个常数
+        Polynomial operator/(const FixedFloat& c) const;
+        // 求 n 次幂
+        Polynomial pow(uint64_t n) const;
+        // 用 Horner 法则求值，n 次多项式只需 n 次乘法和 n 次加法
+        FixedFloat eval(const FixedFloat& x) const;
+        // 用一次 Horner 同时求 p(x) 和 p'(x)
+        void evalWithDerivative(const FixedFloat& x, FixedFloat& value, FixedFloat& derivative) const;
+        // 用子积树和余式树在所有 xs 处求值，结果与 xs 同序，xs 的格式必须与系数相同
+        // 在加宽 multipointGuard 位的格式中计算后截断，因此结果可能与 eval 在最后一位不同
+        std::vector<FixedFloat> evalMultipoint(std::span<const FixedFloat> xs) const;
+        // 次数为 degree 的多项式在 points 个绝对值不超过 radius 的点求值时，整数和小数部分各自加宽的位数
+        // 按子积、幂级数倒数和商的系数增长的保守上界选取
+        static uint64_t multipointGuard(size_t degree, size_t points, double radius, uint16_t base);
+        // 把所有系数转换为指定的格式
+        Polynomial convertTo(uint16_t base, uint64_t int_digit_len, uint64_t dec_digit_len) const;
+};
+
+#endif
@@ -0,0 +1,201 @@
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+
+static std::atomic<uint32_t> next_thread(0);
+// small stable numbers for the trace, in the order the threads first record something
+static thread_local uint32_t thread_id = next_thread.fetch_add(1, std::memory_order_relaxed);
+
+static const char *OP_NAMES[Profiler::OP_COUNT] = {"CONST", "VAR", "ADD", "SUB", "MUL", "DIV", "POW", "HORNER", "MULTIPOINT"};
+
+static std::string json_string(const std::string& s) {
+    std::string ret = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            ret += '\\';
+            ret += c;
+        } else if ((unsigned char) c < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", c);
+            ret += buf;
+        } else {
+            ret += c;
+        }
+    }
+    return ret + "\"";
+}
+
+const char *Profiler::name(Op op) {
+    return op < Op::COUNT ? OP_NAMES[(size_t) op] : "?";
+}
+
+Profiler::Profile::Profile(std::string label, bool trace, size_t max_events):
+                        label(std::move(label)),
+                        trace(trace),
+                        max_events(max_events),
+                        origin(std::chrono::steady_clock::now()) {}
+
+void Profiler::Profile::record(Op op, uint32_t instr, uint64_t lanes, uint64_t lhs_digits, uint64_t rhs_digits, uint64_t operand_digits,
+                               std::chrono::steady_clock::time_point start, uint64_t nanos, const LimbAllocator::Stats& allocs) {
+    std::lock_guard<std::mutex> lock(mutex);
+    OpStats &s = ops[(size_t) op];
+    s.count += lanes;
+    s.nanos += nanos;
+    s.operand_digits += operand_digits;
+    s.max_operand_digits = std::max({s.max_operand_digits, lhs_digits, rhs_digits});
+    s.heap_allocs += allocs.heap_allocs;
+    s.pool_hits += allocs.pool_hits;
+    if (!trace) return;
+    if (events.size() >= max_events) {
+        dropped++;
+        return;
+    }
+    const uint64_t at = (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(start - origin).count();
+    events.push_back({op, instr, thread_id, at, nanos, lhs_digits, rhs_digits});
+}
+
+Profiler::OpStats Profiler::Profile::stats(Op op) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return ops[(size_t) op];
+}
+
+Profiler::OpStats Profiler::Profile::total() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    OpStats ret;
+    for (const OpStats &s : ops) {
+        ret.count += s.count;
+        ret.nanos += s.nanos;
+        ret.operand_digits += s.operand_digits;
+        ret.max_operand_digits = std::max(ret.max_operand_digits, s.max_operand_digits);
+        ret.heap_allocs += s.heap_allocs;
+        ret.pool_hits += s.pool_hits;
+    }
+    return ret;
+}
+
+std::vector<Profiler::Event> Profiler::Profile::timeline() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return events;
+}
+
+void Profiler::Profile::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    ops = {};
+    events.clear();
+    dropped = 0;
+    origin = std::chrono::steady_clock::now();
+}
+
+std::string Profiler::Profile::toText() const {
+    std::array<OpStats, OP_COUNT> s;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        s = ops;
+    }
+    const OpStats sum = total();
+    std::vector<size_t> order;
+    for (size_t i = 0; i < OP_COUNT; i++) {
+        if (s[i].count) order.push_back(i);
+    }
+    std::stable_sort(order.begin(), order.end(), [&] (size_t a, size_t b) { return s[a].nanos > s[b].nanos; });
+    std::string ret = "profile of " + label + "\n";
+    char line[256];
+    snprintf(line, sizeof(line), "%-10s %12s %12s %7s %12s %12s %12s %12s %12s\n",
+             "op", "count", "total_us", "share", "avg_ns", "avg_digits", "max_digits", "heap_allocs", "pool_hits");
+    ret += line;
+    for (size_t i : order) {
+        // every operation has at most two operands, CONST and VAR report the digits of their result
+        const uint64_t operands = (i == (size_t) Op::CONST || i == (size_t) Op::VAR || i == (size_t) Op::HORNER || i == (size_t) Op::MULTIPOINT) ? 1 : 2;
+        snprintf(line, sizeof(line), "%-10s %12llu %12.1f %6.1f%% %12.0f %12.0f %12llu %12llu %12llu\n",
+                 OP_NAMES[i], (unsigned long long) s[i].count, s[i].nanos / 1e3,
+                 sum.nanos ? 100.0 * s[i].nanos / sum.nanos : 0.0,
+                 (double) s[i].nanos / s[i].count,
+                 (double) s[i].operand_digits / (s[i].count * operands),
+                 (unsigned long long) s[i].max_operand_digits,
+                 (unsigned long long) s[i].heap_allocs, (unsigned long long) s[i].pool_hits);
+        ret += line;
+    }
+    snprintf(line, sizeof(line), "%-10s %12llu %12.1f %6.1f%% %12s %12s %12llu %12llu %12llu\n",
+             "total", (unsigned long long) sum.count, sum.nanos / 1e3, sum.nanos ? 100.0 : 0.0, "", "",
+             (unsigned long long) sum.max_operand_digits, (unsigned long long) sum.heap_allocs, (unsigned long long) sum.pool_hits);
+    ret += line;
+    return ret;
+}
+
+std::string Profiler::Profile::toJson() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string ret = "{\"label\": " + json_string(label) + ", \"ops\": [";
+    bool first = true;
+    for (size_t i = 0; i < OP_COUNT; i++) {
+        const OpStats &s = ops[i];
+        if (!s.count) continue;
+        if (!first) ret += ", ";
+        first = false;
+        ret += "{\"op\": \"" + std::string(OP_NAMES[i]) + "\""
+               ", \"count\": " + std::to_string(s.count) +
+               ", \"nanos\": " + std::to_string(s.nanos) +
+               ", \"operand_digits\": " + std::to_string(s.operand_digits) +
+               ", \"max_operand_digits\": " + std::to_string(s.max_operand_digits) +
+               ", \"heap_allocs\": " + std::to_string(s.heap_allocs) +
+               ", \"pool_hits\": " + std::to_string(s.pool_hits) + "}";
+    }
+    ret += "], \"events\": " + std::to_string(events.size()) + ", \"dropped_events\": " + std::to_string(dropped) + "}";
+    return ret;
+}
+
+std::string Profiler::Profile::toChromeTrace() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    // complete events ("ph": "X") with timestamps in microseconds, one row per thread
+    std::string ret = "{\"displayTimeUnit\": \"ns\", \"otherData\": {\"label\": " + json_string(label) + "}, \"traceEvents\": [";
+    char buf[320];
+    for (size_t i = 0; i < events.size(); i++) {
+        const Event &e = events[i];
+        snprintf(buf, sizeof(buf),
+                 "%s\n{\"name\": \"%s\", \"cat\": \"expression\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": %u, "
+                 "\"args\": {\"instr\": %u, \"lhs_digits\": %llu, \"rhs_digits\": %llu}}",
+                 i ? "," : "", OP_NAMES[(size_t) e.op], e.start / 1e3, e.nanos / 1e3, e.thread, e.instr,
+                 (unsigned long long) e.lhs_digits, (unsigned long long) e.rhs_digits);
+        ret += buf;
+    }
+    ret += "\n]}\n";
+    return ret;
+}
+
+Profiler::Scope::Scope(Profile *profile): saved(current) {
+    current = profile;
+}
+
+Profiler::Scope::~Scope() {
+    current = saved;
+}
+
+Profiler::Timer::Timer(Profile *profile, Op op, uint32_t instr, uint64_t lanes, uint64_t lhs_digits, uint64_t rhs_digits):
+                        Timer(profile, op, instr, lanes, lhs_digits, rhs_digits, (lhs_digits + rhs_digits) * lanes) {}
+
+Profiler::Timer::Timer(Profile *profile, Op op, uint32_t instr, uint64_t lanes, uint64_t lhs_digits, uint64_t rhs_digits, uint64_t operand_digits):
+                        profile(profile),
+                        op(op),
+                        instr(instr),
+                        lanes(lanes),
+                        lhs_digits(lhs_digits),
+                        rhs_digits(rhs_digits),
+                        operand_digits(operand_digits),
+                        allocs(LimbAllocator::threadStats()),
+                        start(std::chrono::steady_clock::now()) {}
+
+void Profiler::Timer::setDigits(uint64_t lhs_digits, uint64_t rhs_digits) {
+    this->lhs_digits = lhs_digits;
+    this->rhs_digits = rhs_digits;
+    operand_digits = (lhs_digits + rhs_digits) * lanes;
+}
+
+Profiler::Timer::~Timer() {
+    const auto end = std::chrono::steady_clock::now();
+    const LimbAllocator::Stats now = LimbAllocator::threadStats();
+    const LimbAllocator::Stats delta{now.heap_allocs - allocs.heap_allocs, now.heap_frees - allocs.heap_frees,
+                                     now.pool_hits - allocs.pool_hits, now.pool_returns - allocs.pool_returns};
+    const uint64_t nanos = (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    profile->record(op, instr, lanes, lhs_digits, rhs_digits, operand_digits, start, nanos, delta);
+}
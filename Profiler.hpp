@@ -0,0 +1,119 @@
+#ifndef __PROFILER_HPP__
+#define __PROFILER_HPP__
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "LimbAllocator.hpp"
+
+// Expression 求值的逐条指令统计，默认关闭
+// 线程上存在 Profiler::Scope 时，该线程执行的每条指令都记录到 Scope 指定的 Profile 中：次数、耗时、操作数的有效位数和分配次数，
+// 需要时还记录每条指令的时间线，导出为 Chrome trace；没有 Scope 时每条指令只多读一次线程局部变量
+class Profiler {
+    public:
+        // 被记录的操作：字节码的各个操作码，表达式展开为多项式后的一次 Horner 求值，以及一组点的子积树求值
+        enum class Op : uint8_t { CONST, VAR, ADD, SUB, MUL, DIV, POW, HORNER, MULTIPOINT, COUNT };
+        static const size_t OP_COUNT = (size_t) Op::COUNT;
+        // 默认最多保留的时间线事件数，超出的事件只计入统计
+        static const size_t DEFAULT_MAX_EVENTS = (size_t) 1 << 20;
+
+        // 一种操作的累计统计
+        struct OpStats {
+            uint64_t count = 0;              // 执行次数，按 lane 同步执行时每个 lane 算一次
+            uint64_t nanos = 0;              // 总耗时
+            uint64_t operand_digits = 0;     // 所有操作数的有效位数之和
+            uint64_t max_operand_digits = 0; // 最长的操作数的有效位数
+            uint64_t heap_allocs = 0;        // 向堆申请 limb 数组的次数
+            uint64_t pool_hits = 0;          // 从线程局部池复用 limb 数组的次数
+        };
+        // 时间线上的一条指令
+        struct Event {
+            Op op;
+            uint32_t instr;      // 指令的下标
+            uint32_t thread;     // 执行的线程的编号
+            uint64_t start;      // 相对 Profile 创建时刻的开始时间，以纳秒计
+            uint64_t nanos;
+            uint64_t lhs_digits;
+            uint64_t rhs_digits;
+        };
+
+        // 一个表达式的统计结果，可以被多个线程同时写入
+        class Profile {
+            private:
+                mutable std::mutex mutex;
+                std::string label;
+                bool trace;
+                size_t max_events;
+                std::chrono::steady_clock::time_point origin;
+                std::array<OpStats, OP_COUNT> ops{};
+                std::vector<Event> events;
+                uint64_t dropped = 0;
+            public:
+                // label 通常为表达式的文本，trace 为 true 时保留时间线
+                explicit Profile(std::string label, bool trace = false, size_t max_events = DEFAULT_MAX_EVENTS);
+                Profile(const Profile&) = delete;
+                Profile& operator=(const Profile&) = delete;
+                // 记录一条在 start 开始、耗时 nanos 的指令，它执行了 lanes 次，操作数没有时有效位数为 0
+                // lhs_digits 和 rhs_digits 为各 lane 中最长的操作数的有效位数，operand_digits 为所有 lane 的操作数的有效位数之和
+                void record(Op op, uint32_t instr, uint64_t lanes, uint64_t lhs_digits, uint64_t rhs_digits, uint64_t operand_digits,
+                            std::chrono::steady_clock::time_point start, uint64_t nanos, const LimbAllocator::Stats& allocs);
+                OpStats stats(Op op) const;
+                // 所有操作合计
+                OpStats total() const;
+                std::vector<Event> timeline() const;
+                // 清空统计和时间线
+                void reset();
+                // 每种操作一行的文本表格，按总耗时从高到低排列
+                std::string toText() const;
+                std::string toJson() const;
+                // Chrome trace 的 JSON，可在 chrome://tracing 或 Perfetto 中打开，没有开启 trace 时为空的时间线
+                std::string toChromeTrace() const;
+        };
+
+        // 在作用域内把当前线程的指令记录到 profile，离开时恢复；profile 为 nullptr 时在作用域内关闭记录
+        class Scope {
+            private:
+                Profile *saved;
+            public:
+                explicit Scope(Profile *profile);
+                ~Scope();
+                Scope(const Scope&) = delete;
+                Scope& operator=(const Scope&) = delete;
+        };
+
+        // 一条指令的计时器，析构时把耗时和期间的分配次数记入 profile
+        class Timer {
+            private:
+                Profile *profile;
+                Op op;
+                uint32_t instr;
+                uint64_t lanes;
+                uint64_t lhs_digits;
+                uint64_t rhs_digits;
+                uint64_t operand_digits;
+                LimbAllocator::Stats allocs;
+                std::chrono::steady_clock::time_point start;
+            public:
+                // 每个 lane 的操作数的有效位数都相同
+                Timer(Profile *profile, Op op, uint32_t instr, uint64_t lanes, uint64_t lhs_digits, uint64_t rhs_digits);
+                // 各 lane 的有效位数不同，lhs_digits 和 rhs_digits 取最长的，operand_digits 为所有 lane 之和
+                Timer(Profile *profile, Op op, uint32_t instr, uint64_t lanes, uint64_t lhs_digits, uint64_t rhs_digits, uint64_t operand_digits);
+                ~Timer();
+                // 操作数的有效位数在计时开始后才知道时，例如 CONST 的结果，在结束前更新
+                void setDigits(uint64_t lhs_digits, uint64_t rhs_digits);
+                Timer(const Timer&) = delete;
+                Timer& operator=(const Timer&) = delete;
+        };
+
+        // 当前线程记录到的 Profile，没有开启时为 nullptr
+        static Profile *active() { return current; }
+        static const char *name(Op op);
+    private:
+        static inline thread_local Profile *current = nullptr;
+};
+
+#endif
@@ -0,0 +1,122 @@
+#include "ResultCache.hpp"
+
+#include <cctype>
+#include <cstring>
+#include <atomic>
+
+// ids are unique across all caches, results of different caches never share a key
+static std::atomic<uint64_t> next_id{1};
+
+ResultCache::ResultCache(size_t max_expressions, size_t max_result_bytes): expressions(max_expressions), results(max_result_bytes) {}
+
+std::string ResultCache::normalize(const std::string& src) {
+    std::string ret;
+    ret.reserve(src.size());
+    bool gap = false;
+    for (char c : src) {
+        if (isspace((unsigned char) c)) {
+            gap = true;
+            continue;
+        }
+        // "1 2" must not turn into "12"
+        const bool num = isdigit((unsigned char) c) || c == '.';
+        if (gap && num && !ret.empty() && (isdigit((unsigned char) ret.back()) || ret.back() == '.')) ret.push_back(' ');
+        ret.push_back(c);
+        gap = false;
+    }
+    return ret;
+}
+
+std::string ResultCache::result_key(uint64_t id, const FixedFloat& x) {
+    // the format fields and the raw limbs identify x exactly, without formatting it
+    std::string key(3 * sizeof(uint64_t) + sizeof(uint16_t) + 1 + x.len * sizeof(uint32_t), '\0');
+    char *p = key.data();
+    memcpy(p, &id, sizeof(uint64_t));
+    p += sizeof(uint64_t);
+    memcpy(p, &x.base, sizeof(uint16_t));
+    p += sizeof(uint16_t);
+    memcpy(p, &x.int_digit_len, sizeof(uint64_t));
+    memcpy(p + sizeof(uint64_t), &x.dec_digit_len, sizeof(uint64_t));
+    p += 2 * sizeof(uint64_t);
+    *p++ = x.sign;
+    memcpy(p, x.arr, x.len * sizeof(uint32_t));
+    return key;
+}
+
+std::shared_ptr<const ResultCache::Compiled> ResultCache::compile(const std::string& src) {
+    const std::string key = normalize(src);
+    std::shared_ptr<const Compiled> ret;
+    if (expressions.get(key, ret)) return ret;
+    // compile outside the lock, if another thread got there first its copy wins
+    return expressions.put(key, std::make_shared<const Compiled>(next_id++, key));
+}
+
+FixedFloat ResultCache::eval(const std::string& src, const FixedFloat& x) {
+    return eval(*compile(src), x);
+}
+
+FixedFloat ResultCache::eval(const Compiled& e, const FixedFloat& x) {
+    const std::string key = result_key(e.id, x);
+    FixedFloat ret(x.base, x.int_digit_len, x.dec_digit_len);
+    if (results.get(key, ret)) return ret;
+    // a shared expression would serialize on its default context, so the evaluation borrows one of the expression's
+    // own contexts, which stays prepared for the next call however the expressions interleave on this thread
+    std::unique_ptr<Expression::Context> ctx;
+    {
+        std::lock_guard<std::mutex> lock(e.contexts_mutex);
+        if (!e.contexts.empty()) {
+            ctx = std::move(e.contexts.back());
+            e.contexts.pop_back();
+        }
+    }
+    if (!ctx) ctx = std::make_unique<Expression::Context>();
+    struct Return {
+        const Compiled &e;
+        std::unique_ptr<Expression::Context> &ctx;
+        ~Return() {
+            std::lock_guard<std::mutex> lock(e.contexts_mutex);
+            e.contexts.push_back(std::move(ctx));
+        }
+    } give_back{e, ctx};
+    ret = e.expr.eval(x, *ctx);
+    // the key holds every limb of x and is stored in both the list and the index,
+    // so a long entry costs about three times the size of the number
+    const size_t cost = 2 * key.size() + ret.footprint().bytes + RESULT_ENTRY_OVERHEAD;
+    results.put(key, ret, cost);
+    return ret;
+}
+
+void ResultCache::clear() {
+    expressions.clear();
+    results.clear();
+}
+
+ResultCache::Stats ResultCache::expressionStats() const {
+    return expressions.stats();
+}
+
+ResultCache::Stats ResultCache::resultStats() const {
+    return results.stats();
+}
+
+void ResultCache::resetStats() {
+    expressions.resetStats();
+    results.resetStats();
+}
+
+size_t ResultCache::expressionCount() const {
+    return expressions.size();
+}
+
+size_t ResultCache::resultCount() const {
+    return results.size();
+}
+
+size_t ResultCache::resultBytes() const {
+    return results.cost();
+}
+
+ResultCache& ResultCache::shared() {
+    static ResultCache cache;
+    return cache;
+}
@@ -0,0 +1,146 @@
+#ifndef __RESULT_CACHE_HPP__
+#define __RESULT_CACHE_HPP__
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "FixedFloat.hpp"
+#include "Expression.hpp"
+
+// 线程安全的 LRU 缓存，放在表达式的编译和求值之前
+// 已编译的表达式按规范化后的源码缓存，求值结果按 (表达式编号, x 的数字, 基数, 整数位数, 小数位数) 缓存
+// 表达式按条数限制，求值结果的键和值都随精度变长，所以按两者占用的字节数限制
+class ResultCache {
+    public:
+        // 命中统计
+        struct Stats {
+            uint64_t hits;      // 命中次数
+            uint64_t misses;    // 未命中次数
+            uint64_t evictions; // 因容量不足淘汰的条目数
+        };
+        // 已编译的表达式，编号在进程内唯一，表达式被淘汰后重新编译会得到新的编号
+        // 求值用的 Context 归表达式所有：每次求值借出一个，用完归还，所以按格式算好的常量和展开的多项式
+        // 在不同表达式交替求值时也保留下来，并随表达式一起被淘汰；Context 的个数不超过同时求值的线程数
+        struct Compiled {
+            uint64_t id;
+            Expression expr;
+            mutable std::mutex contexts_mutex;
+            mutable std::vector<std::unique_ptr<Expression::Context>> contexts;
+            Compiled(uint64_t id, const std::string& src): id(id), expr(src) {}
+        };
+        static const size_t DEFAULT_MAX_EXPRESSIONS = 256;
+        static const size_t DEFAULT_MAX_RESULT_BYTES = (size_t) 64 << 20;
+        // 每个结果条目在键和值的数据之外的开销：链表节点、哈希表节点和两个键的字符串对象
+        static const size_t RESULT_ENTRY_OVERHEAD = 128;
+    private:
+        // 带互斥锁的 LRU 表，最近使用的条目在链表头部
+        // 每个条目有一个代价，所有条目的代价之和不超过 capacity，代价大于 capacity 的条目不缓存
+        template <typename V>
+        class Lru {
+            private:
+                struct Entry {
+                    std::string key;
+                    V val;
+                    size_t cost;
+                };
+                typedef std::list<Entry> List;
+                mutable std::mutex mutex;
+                size_t capacity;
+                size_t used = 0;
+                List entries;
+                std::unordered_map<std::string, typename List::iterator> index;
+                Stats counters = {0, 0, 0};
+            public:
+                explicit Lru(size_t capacity): capacity(capacity) {}
+                // 命中时把值写入 out 并移到头部
+                bool get(const std::string& key, V& out) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    auto it = index.find(key);
+                    if (it == index.end()) {
+                        counters.misses++;
+                        return false;
+                    }
+                    counters.hits++;
+                    entries.splice(entries.begin(), entries, it->second);
+                    out = it->second->val;
+                    return true;
+                }
+                // 插入一个代价为 cost 的条目，键已存在时保留已有的值，返回缓存中的值
+                V put(const std::string& key, V val, size_t cost = 1) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    auto it = index.find(key);
+                    if (it != index.end()) {
+                        entries.splice(entries.begin(), entries, it->second);
+                        return it->second->val;
+                    }
+                    if (cost > capacity) return val;
+                    while (used + cost > capacity) {
+                        used -= entries.back().cost;
+                        index.erase(entries.back().key);
+                        entries.pop_back();
+                        counters.evictions++;
+                    }
+                    entries.push_front({key, std::move(val), cost});
+                    index.emplace(key, entries.begin());
+                    used += cost;
+                    return entries.front().val;
+                }
+                void clear() {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    entries.clear();
+                    index.clear();
+                    used = 0;
+                }
+                size_t size() const {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    return entries.size();
+                }
+                // 所有条目的代价之和
+                size_t cost() const {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    return used;
+                }
+                Stats stats() const {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    return counters;
+                }
+                void resetStats() {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    counters = {0, 0, 0};
+                }
+        };
+        Lru<std::shared_ptr<const Compiled>> expressions;
+        Lru<FixedFloat> results;
+        // x 与其格式组成的结果键
+        static std::string result_key(uint64_t id, const FixedFloat& x);
+    public:
+        // 最多缓存 max_expressions 个表达式，求值结果的键和值共占 max_result_bytes 字节
+        explicit ResultCache(size_t max_expressions = DEFAULT_MAX_EXPRESSIONS, size_t max_result_bytes = DEFAULT_MAX_RESULT_BYTES);
+        ResultCache(const ResultCache&) = delete;
+        ResultCache& operator=(const ResultCache&) = delete;
+        // 规范化表达式源码：去掉空白，两个数字之间的空白保留为一个空格，使其仍然不合法
+        static std::string normalize(const std::string& src);
+        // 返回编译好的表达式，规范化后相同的源码只编译一次
+        std::shared_ptr<const Compiled> compile(const std::string& src);
+        // 求表达式在 x 处的值，与 Expression::eval 的结果相同
+        FixedFloat eval(const std::string& src, const FixedFloat& x);
+        FixedFloat eval(const Compiled& e, const FixedFloat& x);
+        // 清空两个缓存，统计保留
+        void clear();
+        Stats expressionStats() const;
+        Stats resultStats() const;
+        void resetStats();
+        size_t expressionCount() const;
+        size_t resultCount() const;
+        // 缓存的求值结果按键、值和条目开销计算的字节数
+        size_t resultBytes() const;
+        // 进程共享的缓存
+        static ResultCache& shared();
+};
+
+#endif
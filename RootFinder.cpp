@@ -0,0 +1,217 @@
+#include "RootFinder.hpp"
+
+#include <cmath>
+#include <complex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace {
+struct Complex {
+    FixedFloat re;
+    FixedFloat im;
+};
+}
+
+static FixedFloat zero_like(const FixedFloat& like) {
+    return FixedFloat(like.getBase(), like.getIntDigitLen(), like.getDecDigitLen());
+}
+
+static FixedFloat abs_of(const FixedFloat& x) {
+    return x < zero_like(x) ? -x : x;
+}
+
+static Complex mul(const Complex& a, const Complex& b) {
+    FixedFloat re = a.re * b.re, im = a.re * b.im;
+    re -= a.im * b.im;
+    im.fma(a.im, b.re);
+    return {std::move(re), std::move(im)};
+}
+
+// Smith's division, it divides by the larger component instead of squaring, so small divisors keep their digits
+static Complex div(const Complex& a, const Complex& b) {
+    if (b.re.isZero() && b.im.isZero()) throw std::runtime_error("division by zero");
+    if (!(abs_of(b.re) < abs_of(b.im))) {
+        const FixedFloat r = b.im / b.re;
+        FixedFloat den = b.re;
+        den.fma(b.im, r);
+        FixedFloat re = a.re, im = a.im;
+        re.fma(a.im, r);
+        im -= a.re * r;
+        return {re / den, im / den};
+    }
+    const FixedFloat r = b.re / b.im;
+    FixedFloat den = b.im;
+    den.fma(b.re, r);
+    FixedFloat re = a.im, im = a.im * r;
+    re.fma(a.re, r);
+    im -= a.re;
+    return {re / den, im / den};
+}
+
+FixedFloat RootFinder::unit(const FixedFloat& like, uint64_t dec_digit_len, uint64_t k) {
+    std::string s = k ? "0." + std::string(k - 1, '0') + "1" : "1";
+    return FixedFloat(like.getBase(), like.getIntDigitLen(), dec_digit_len, s);
+}
+
+std::vector<uint64_t> RootFinder::precisions(uint16_t base, uint64_t target) {
+    std::vector<uint64_t> ret;
+    uint64_t d = (uint64_t) std::ceil(START_BITS / std::log2((double) base));
+    for (; d < target; d *= 2) ret.push_back(d);
+    ret.push_back(target);
+    return ret;
+}
+
+FixedFloat RootFinder::newton(const Polynomial& p, const FixedFloat& lo_in, const FixedFloat& hi_in) {
+    const uint16_t base = lo_in.getBase();
+    const uint64_t int_len = lo_in.getIntDigitLen(), target = lo_in.getDecDigitLen();
+    const FixedFloat outer_lo = lo_in < hi_in ? lo_in : hi_in, outer_hi = lo_in < hi_in ? hi_in : lo_in;
+    // the signs at the ends are checked once at full precision, every later step only compares against them
+    const Polynomial full = p.convertTo(base, int_len, target);
+    const FixedFloat zero = zero_like(outer_lo), v_lo = full.eval(outer_lo), v_hi = full.eval(outer_hi);
+    if (v_lo.isZero()) return outer_lo;
+    if (v_hi.isZero()) return outer_hi;
+    const bool lo_negative = v_lo < zero;
+    if (lo_negative == (v_hi < zero)) throw std::runtime_error("no sign change in the interval");
+
+    const std::vector<uint64_t> levels = precisions(base, target);
+    FixedFloat lo = outer_lo, hi = outer_hi, x = zero;
+    for (size_t level = 0; level < levels.size(); level++) {
+        const uint64_t d = levels[level];
+        const bool last = level + 1 == levels.size();
+        const Polynomial q = last ? full : p.convertTo(base, int_len, d);
+        const FixedFloat two(base, int_len, d, 2.0), z = zero_like(two), eps = unit(two, d, d > 2 ? d - 2 : d);
+        if (level == 0) {
+            lo = outer_lo.convertTo(base, int_len, d);
+            hi = outer_hi.convertTo(base, int_len, d);
+            x = (lo + hi) / two;
+        } else {
+            // values near the root may have had the wrong sign at the lower precision, so give the bracket a few
+            // units of slack, never beyond the interval that was checked
+            const FixedFloat slack = unit(two, d, levels[level - 1] > 2 ? levels[level - 1] - 2 : 0);
+            x = x.convertTo(base, int_len, d);
+            lo = lo.convertTo(base, int_len, d) - slack;
+            hi = hi.convertTo(base, int_len, d) + slack;
+            const FixedFloat olo = outer_lo.convertTo(base, int_len, d), ohi = outer_hi.convertTo(base, int_len, d);
+            if (lo < olo) lo = olo;
+            if (ohi < hi) hi = ohi;
+        }
+
+        FixedFloat v = z, dv = z;
+        for (size_t it = 0; it < MAX_ITERATIONS; it++) {
+            q.evalWithDerivative(x, v, dv);
+            if (v.isZero()) break;
+            if ((v < z) == lo_negative) lo = x;
+            else hi = x;
+            // take the Newton step when it stays inside the bracket, otherwise bisect
+            FixedFloat next = z;
+            bool inside = false;
+            if (!dv.isZero()) {
+                const FixedFloat step = v / dv;
+                next = x - step;
+                inside = !(next < lo) && !(hi < next);
+                // a step within the last digits means this precision is done, even if rounding put it just outside
+                if (!(eps < abs_of(step))) {
+                    if (inside) x = std::move(next);
+                    break;
+                }
+            }
+            if (!inside) next = (lo + hi) / two;
+            const FixedFloat step = abs_of(next - x);
+            x = std::move(next);
+            if (!(eps < step)) break;
+        }
+    }
+    return x;
+}
+
+std::vector<RootFinder::Root> RootFinder::aberth(const Polynomial& p) {
+    const std::vector<FixedFloat> &c = p.coefficients();
+    const size_t n = p.degree();
+    if (c.empty() || n == 0) return std::vector<Root>();
+    const FixedFloat &like = c[0];
+    const uint16_t base = like.getBase();
+    const uint64_t int_len = like.getIntDigitLen(), target = like.getDecDigitLen();
+
+    // first approximations in long double, starting on a circle of the Fujiwara bound
+    typedef std::complex<long double> C;
+    std::vector<long double> a(n + 1);
+    for (size_t i = 0; i <= n; i++) a[i] = c[i].doubleValue();
+    long double radius = 0;
+    for (size_t k = 1; k <= n; k++) radius = std::max(radius, std::pow(std::abs(a[n - k] / a[n]), 1.0L / k));
+    if (radius == 0) radius = 1;
+    std::vector<C> z(n);
+    for (size_t k = 0; k < n; k++) z[k] = std::polar(radius, (long double) (2 * M_PI * k / n + 0.4));
+    for (size_t it = 0; it < 50 * MAX_ITERATIONS; it++) {
+        long double worst = 0;
+        for (size_t k = 0; k < n; k++) {
+            C v = a[n], dv = 0;
+            for (size_t i = n; i > 0; i--) {
+                dv = dv * z[k] + v;
+                v = v * z[k] + a[i - 1];
+            }
+            if (v == C(0) || dv == C(0)) continue;
+            const C w = v / dv;
+            C s = 0;
+            for (size_t j = 0; j < n; j++) {
+                if (j != k && z[k] != z[j]) s += 1.0L / (z[k] - z[j]);
+            }
+            const C delta = w / (1.0L - w * s);
+            z[k] -= delta;
+            worst = std::max(worst, std::abs(delta) / std::max(1.0L, std::abs(z[k])));
+        }
+        if (worst < 1e-17L) break;
+    }
+
+    // refine in FixedFloat, doubling the precision each time the corrections reach the last digits
+    std::vector<Complex> roots;
+    const std::vector<uint64_t> levels = precisions(base, target);
+    for (size_t level = 0; level < levels.size(); level++) {
+        const uint64_t d = levels[level];
+        const Polynomial q = p.convertTo(base, int_len, d);
+        const FixedFloat one(base, int_len, d, 1.0), zero = zero_like(one), eps = unit(one, d, d > 2 ? d - 2 : d);
+        if (level == 0) {
+            for (const C &r : z) roots.push_back({FixedFloat(base, int_len, d, (double) r.real()), FixedFloat(base, int_len, d, (double) r.imag())});
+        } else {
+            for (Complex &r : roots) r = {r.re.convertTo(base, int_len, d), r.im.convertTo(base, int_len, d)};
+        }
+        const std::vector<FixedFloat> &qc = q.coefficients();
+        for (size_t it = 0; it < MAX_ITERATIONS; it++) {
+            bool converged = true;
+            for (size_t k = 0; k < n; k++) {
+                // p and p' at a complex point in one Horner pass
+                Complex v = {qc.back(), zero}, dv = {zero, zero};
+                for (size_t i = qc.size() - 1; i > 0; i--) {
+                    dv = mul(dv, roots[k]);
+                    dv.re += v.re;
+                    dv.im += v.im;
+                    v = mul(v, roots[k]);
+                    v.re += qc[i - 1];
+                }
+                if ((v.re.isZero() && v.im.isZero()) || (dv.re.isZero() && dv.im.isZero())) continue;
+                const Complex w = div(v, dv);
+                Complex s = {zero, zero};
+                for (size_t j = 0; j < n; j++) {
+                    if (j == k) continue;
+                    Complex diff = {roots[k].re - roots[j].re, roots[k].im - roots[j].im};
+                    if (diff.re.isZero() && diff.im.isZero()) continue;
+                    const Complex inv = div({one, zero}, diff);
+                    s.re += inv.re;
+                    s.im += inv.im;
+                }
+                Complex den = mul(w, s);
+                den = {one - den.re, -den.im};
+                if (den.re.isZero() && den.im.isZero()) continue;
+                const Complex delta = div(w, den);
+                roots[k].re -= delta.re;
+                roots[k].im -= delta.im;
+                if (eps < abs_of(delta.re) || eps < abs_of(delta.im)) converged = false;
+            }
+            if (converged) break;
+        }
+    }
+
+    std::vector<Root> ret;
+    for (Complex &r : roots) ret.push_back({std::move(r.re), std::move(r.im)});
+    return ret;
+}
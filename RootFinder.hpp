@@ -0,0 +1,35 @@
+#ifndef __ROOT_FINDER_HPP__
+#define __ROOT_FINDER_HPP__
+
+#include <cstdint>
+#include <vector>
+#include "FixedFloat.hpp"
+#include "Polynomial.hpp"
+
+// 多项式求根，用同一次 Horner 求出 p(x) 和 p'(x)，从低精度开始迭代，每次收敛后把精度加倍
+class RootFinder {
+    public:
+        // 复数根，im 为 0 时是实根
+        struct Root {
+            FixedFloat re;
+            FixedFloat im;
+        };
+        // 起始精度的二进制位数，约为 double 的精度
+        static const uint32_t START_BITS = 50;
+        // 每个精度下最多迭代的次数
+        static const size_t MAX_ITERATIONS = 100;
+    private:
+        // 与 like 格式相同、小数点后只有 dec_digit_len 位的格式下的 base^(-k)
+        static FixedFloat unit(const FixedFloat& like, uint64_t dec_digit_len, uint64_t k);
+        // 从 START_BITS 开始加倍直到 target 的各级小数位数
+        static std::vector<uint64_t> precisions(uint16_t base, uint64_t target);
+    public:
+        // 在 [lo, hi] 中求 p 的一个实根，p(lo) 与 p(hi) 必须异号，Newton 步越出区间时改为二分
+        // 结果的格式与 lo 相同
+        static FixedFloat newton(const Polynomial& p, const FixedFloat& lo, const FixedFloat& hi);
+        // 用 Aberth 迭代同时求 p 的全部复数根，先用 long double 得到初值，再用 FixedFloat 逐级加倍精度
+        // 结果的格式与 p 的系数相同，整数部分必须能容纳根的模
+        static std::vector<Root> aberth(const Polynomial& p);
+};
+
+#endif
@@ -0,0 +1,220 @@
+#include "Serializer.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char FIXED_MAGIC[4] = {'F', 'X', 'F', 'L'};
+static const char EXPR_MAGIC[4] = {'F', 'X', 'E', 'X'};
+static const size_t FIXED_HEADER = 40;
+static const size_t EXPR_HEADER = 24;
+static const size_t INSTR_SIZE = 12;
+
+// the words are stored as they are in memory, which is the little-endian layout of the format
+static void check_byte_order() {
+    if (std::endian::native != std::endian::little) throw std::runtime_error("unsupported byte order");
+}
+
+static size_t pad8(size_t n) {
+    return (n + 7) & ~(size_t) 7;
+}
+
+template <typename T>
+static void put(char *p, T val) {
+    memcpy(p, &val, sizeof(T));
+}
+
+template <typename T>
+static T get(const char *p) {
+    T val;
+    memcpy(&val, p, sizeof(T));
+    return val;
+}
+
+// the record at data[offset, size) must have a header of at least n bytes with the given magic and a known version
+static const char *header(const char *data, size_t size, size_t offset, size_t n, const char *magic) {
+    check_byte_order();
+    if (offset > size || size - offset < n) throw std::runtime_error("truncated record");
+    const char *p = data + offset;
+    if (memcmp(p, magic, 4)) throw std::runtime_error("invalid record");
+    if (get<uint16_t>(p + 4) != Serializer::VERSION) throw std::runtime_error("unsupported record version");
+    return p;
+}
+
+// the number of limbs FixedFloat(base, int_digit_len, dec_digit_len) allocates, worked out without allocating them,
+// so a header with hostile lengths is rejected before anything of its size is built
+static uint64_t limb_count(uint16_t base, uint64_t int_digit_len, uint64_t dec_digit_len) {
+    if (base < 2) throw std::runtime_error("invalid record");
+    if (int_digit_len > FixedFloat::MAX_DIGIT_LEN || dec_digit_len > FixedFloat::MAX_DIGIT_LEN - int_digit_len)
+        throw std::runtime_error("invalid record");
+    uint64_t digit_per_limb = 0;
+    for (uint64_t limb_base = 1; limb_base * base <= ((uint64_t) 1 << 32); limb_base *= base) digit_per_limb++;
+    const uint64_t len = (dec_digit_len + digit_per_limb - 1) / digit_per_limb + (int_digit_len + digit_per_limb - 1) / digit_per_limb;
+    return std::max<uint64_t>(len, 1);
+}
+
+size_t Serializer::size(const FixedFloat& f) {
+    return FIXED_HEADER + pad8(f.len * sizeof(uint32_t));
+}
+
+void Serializer::write(const FixedFloat& f, std::string& out) {
+    check_byte_order();
+    const size_t at = out.size();
+    out.resize(at + size(f), '\0');
+    char *p = out.data() + at;
+    memcpy(p, FIXED_MAGIC, 4);
+    put<uint16_t>(p + 4, VERSION);
+    put<uint16_t>(p + 6, f.base);
+    put<uint32_t>(p + 8, f.sign);
+    put<uint64_t>(p + 16, f.int_digit_len);
+    put<uint64_t>(p + 24, f.dec_digit_len);
+    put<uint64_t>(p + 32, f.len);
+    memcpy(p + FIXED_HEADER, f.arr, f.len * sizeof(uint32_t));
+}
+
+Serializer::View Serializer::view(const char *data, size_t size, size_t& offset) {
+    const char *p = header(data, size, offset, FIXED_HEADER, FIXED_MAGIC);
+    View ret;
+    ret.base = get<uint16_t>(p + 6);
+    ret.sign = get<uint32_t>(p + 8) != 0;
+    ret.int_digit_len = get<uint64_t>(p + 16);
+    ret.dec_digit_len = get<uint64_t>(p + 24);
+    ret.len = get<uint64_t>(p + 32);
+    if (ret.len > (size - offset - FIXED_HEADER) / sizeof(uint32_t)) throw std::runtime_error("truncated record");
+    if (ret.len != limb_count(ret.base, ret.int_digit_len, ret.dec_digit_len)) throw std::runtime_error("invalid record");
+    if ((uintptr_t) (p + FIXED_HEADER) % alignof(uint32_t)) throw std::runtime_error("misaligned record");
+    ret.limbs = (const uint32_t *) (p + FIXED_HEADER);
+    // the padding of the last record may be missing at the very end of the data
+    offset = std::min(size, offset + FIXED_HEADER + pad8(ret.len * sizeof(uint32_t)));
+    return ret;
+}
+
+FixedFloat Serializer::View::toFixedFloat() const {
+    if (len != limb_count(base, int_digit_len, dec_digit_len)) throw std::runtime_error("invalid record");
+    FixedFloat ret(base, int_digit_len, dec_digit_len);
+    for (uint64_t i = 0; i < len; i++) {
+        if (limbs[i] >= ret.limb_base) throw std::runtime_error("invalid record");
+    }
+    memcpy(ret.arr, limbs, len * sizeof(uint32_t));
+    ret.sign = sign;
+    // padding or overflow digits that a valid writer never produces are dropped here
+    ret.normalize();
+    return ret;
+}
+
+FixedFloat Serializer::read(const char *data, size_t size, size_t& offset) {
+    return view(data, size, offset).toFixedFloat();
+}
+
+std::vector<Serializer::View> Serializer::viewAll(const char *data, size_t size) {
+    std::vector<View> ret;
+    for (size_t offset = 0; offset < size; ) ret.push_back(view(data, size, offset));
+    return ret;
+}
+
+void Serializer::write(const Expression& e, std::string& out) {
+    check_byte_order();
+    size_t n = EXPR_HEADER + e.code.size() * INSTR_SIZE;
+    for (const std::string &lit : e.literals) n += sizeof(uint32_t) + lit.size();
+    const size_t at = out.size();
+    out.resize(at + pad8(n), '\0');
+    char *p = out.data() + at;
+    memcpy(p, EXPR_MAGIC, 4);
+    put<uint16_t>(p + 4, VERSION);
+    put<uint32_t>(p + 8, e.result);
+    put<uint32_t>(p + 12, (uint32_t) e.code.size());
+    put<uint32_t>(p + 16, (uint32_t) e.literals.size());
+    p += EXPR_HEADER;
+    for (const Expression::Instr &ins : e.code) {
+        put<uint8_t>(p, (uint8_t) ins.op);
+        put<uint32_t>(p + 4, ins.lhs);
+        put<uint32_t>(p + 8, ins.rhs);
+        p += INSTR_SIZE;
+    }
+    for (const std::string &lit : e.literals) {
+        put<uint32_t>(p, (uint32_t) lit.size());
+        memcpy(p + sizeof(uint32_t), lit.data(), lit.size());
+        p += sizeof(uint32_t) + lit.size();
+    }
+}
+
+Expression Serializer::readExpression(const char *data, size_t size, size_t& offset) {
+    const char *p = header(data, size, offset, EXPR_HEADER, EXPR_MAGIC);
+    const char *end = data + size;
+    const uint32_t result = get<uint32_t>(p + 8), code_len = get<uint32_t>(p + 12), literal_len = get<uint32_t>(p + 16);
+    if ((size_t) (end - p - EXPR_HEADER) / INSTR_SIZE < code_len) throw std::runtime_error("truncated record");
+    p += EXPR_HEADER;
+
+    // the program must be in topological order with every reference in range, like the compiler emits it
+    std::vector<Expression::Instr> code;
+    code.reserve(code_len);
+    for (uint32_t i = 0; i < code_len; i++, p += INSTR_SIZE) {
+        const uint8_t op = get<uint8_t>(p);
+        const uint32_t lhs = get<uint32_t>(p + 4), rhs = get<uint32_t>(p + 8);
+        if (op > (uint8_t) Expression::OpCode::POW) throw std::runtime_error("invalid record");
+        const Expression::OpCode opcode = (Expression::OpCode) op;
+        bool constant = true;
+        if (opcode == Expression::OpCode::CONST) {
+            if (lhs >= literal_len) throw std::runtime_error("invalid record");
+        } else if (opcode == Expression::OpCode::VAR) {
+            constant = false;
+        } else {
+            if (lhs >= i || rhs >= i) throw std::runtime_error("invalid record");
+            constant = code[lhs].constant && code[rhs].constant;
+        }
+        code.push_back({opcode, constant, lhs, rhs});
+    }
+    if (result >= code_len) throw std::runtime_error("invalid record");
+
+    std::vector<std::string> literals;
+    literals.reserve(literal_len);
+    for (uint32_t i = 0; i < literal_len; i++) {
+        if (end - p < (ptrdiff_t) sizeof(uint32_t)) throw std::runtime_error("truncated record");
+        const uint32_t n = get<uint32_t>(p);
+        p += sizeof(uint32_t);
+        if ((size_t) (end - p) < n) throw std::runtime_error("truncated record");
+        std::string lit(p, n);
+        // literals are plain decimal numbers, as the parser collects them
+        if (lit.empty() || lit.find_first_not_of("0123456789.") != std::string::npos) throw std::runtime_error("invalid record");
+        literals.push_back(std::move(lit));
+        p += n;
+    }
+    offset = std::min(size, offset + pad8(p - (data + offset)));
+    return Expression(std::move(code), std::move(literals), result);
+}
+
+void Serializer::save(const std::string& path, const std::string& bytes) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.write(bytes.data(), bytes.size()) || !file.flush()) throw std::runtime_error("can not write " + path);
+}
+
+Serializer::MappedFile::MappedFile(const std::string& path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("can not open " + path);
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        throw std::runtime_error("can not open " + path);
+    }
+    n = (size_t) st.st_size;
+    // an empty file can not be mapped, it simply has no records
+    if (n) {
+        void *p = mmap(nullptr, n, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("can not map " + path);
+        }
+        ptr = (const char *) p;
+    }
+    close(fd);
+}
+
+Serializer::MappedFile::~MappedFile() {
+    if (ptr) munmap((void *) ptr, n);
+}
@@ -0,0 +1,59 @@
+#ifndef __SERIALIZER_HPP__
+#define __SERIALIZER_HPP__
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "FixedFloat.hpp"
+#include "Expression.hpp"
+
+// FixedFloat 与编译后的 Expression 的二进制格式，带版本号，按小端序存放
+// FixedFloat 记录：40 字节的头部（魔数 "FXFL"、版本、基数、符号、整数位数、小数位数、limb 数），随后是原样的 limb 数组
+// Expression 记录：24 字节的头部（魔数 "FXEX"、版本、结果寄存器、指令数、字面量数），随后是每条 12 字节的指令和带长度的字面量
+// 每条记录都补齐到 8 字节，多条记录直接首尾相接，所以从 mmap 的文件中可以不经复制地读出 limb 数组
+class Serializer {
+    public:
+        static const uint16_t VERSION = 1;
+        // 不复制 limb 的只读视图，指向的内存在使用期间必须有效
+        struct View {
+            uint16_t base;
+            uint64_t int_digit_len;
+            uint64_t dec_digit_len;
+            bool sign;
+            const uint32_t *limbs;
+            uint64_t len;
+            // 复制为 FixedFloat，此时才检查 limb 的值是否与格式相符；limb 数在分配之前检查
+            FixedFloat toFixedFloat() const;
+        };
+        // 只读映射一个文件，析构时解除映射
+        class MappedFile {
+            private:
+                const char *ptr = nullptr;
+                size_t n = 0;
+            public:
+                explicit MappedFile(const std::string& path);
+                ~MappedFile();
+                MappedFile(const MappedFile&) = delete;
+                MappedFile& operator=(const MappedFile&) = delete;
+                const char *data() const { return ptr; }
+                size_t size() const { return n; }
+        };
+
+        // 记录占用的字节数
+        static size_t size(const FixedFloat& f);
+        // 把一条记录追加到 out 的末尾
+        static void write(const FixedFloat& f, std::string& out);
+        static void write(const Expression& e, std::string& out);
+        // 读取 data[offset, size) 开头的一条记录并把 offset 移到下一条，记录不完整或不合法（包括 limb 数与头部的格式不符）时抛出异常
+        // data + offset 必须按 4 字节对齐，mmap 的文件和 std::string 的缓冲区都满足
+        static View view(const char *data, size_t size, size_t& offset);
+        static FixedFloat read(const char *data, size_t size, size_t& offset);
+        static Expression readExpression(const char *data, size_t size, size_t& offset);
+        // 一段首尾相接的 FixedFloat 记录的所有视图
+        static std::vector<View> viewAll(const char *data, size_t size);
+        // 把 bytes 写入文件，已有的文件被覆盖
+        static void save(const std::string& path, const std::string& bytes);
+};
+
+#endif
@@ -0,0 +1,265 @@
+#include "Server.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static const size_t HEADER = 8;
+
+struct Server::Connection {
+    int fd;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::pair<uint32_t, std::string>> outbox; // finished responses, in the order they finished
+    size_t pending = 0;   // requests read whose responses are not written yet
+    bool reading = true;  // the reader may still add requests
+    bool broken = false;  // a write failed or the server stops, the remaining responses are dropped
+    explicit Connection(int fd): fd(fd) {}
+    ~Connection() { close(fd); }
+};
+
+static std::runtime_error system_error(const std::string& what) {
+    return std::runtime_error(what + ": " + strerror(errno));
+}
+
+// read exactly n bytes, returns how many arrived before the peer closed the connection
+static size_t read_full(int fd, char *buf, size_t n) {
+    size_t got = 0;
+    while (got < n) {
+        const ssize_t r = recv(fd, buf + got, n - got, 0);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) break;
+        got += (size_t) r;
+    }
+    return got;
+}
+
+bool Server::readFrame(int fd, uint32_t& id, std::string& payload) {
+    char header[HEADER];
+    const size_t got = read_full(fd, header, HEADER);
+    if (got == 0) return false;
+    if (got < HEADER) throw std::runtime_error("truncated frame");
+    uint32_t n;
+    memcpy(&n, header, sizeof(n));
+    memcpy(&id, header + 4, sizeof(id));
+    if (n > MAX_FRAME) throw std::runtime_error("frame too large");
+    payload.resize(n);
+    if (read_full(fd, payload.data(), n) < n) throw std::runtime_error("truncated frame");
+    return true;
+}
+
+bool Server::writeFrame(int fd, uint32_t id, std::string_view payload) {
+    if (payload.size() > MAX_FRAME) throw std::runtime_error("frame too large");
+    // one buffer, so a frame goes out in as few segments as possible
+    std::string buf(HEADER + payload.size(), '\0');
+    const uint32_t n = (uint32_t) payload.size();
+    memcpy(buf.data(), &n, sizeof(n));
+    memcpy(buf.data() + 4, &id, sizeof(id));
+    memcpy(buf.data() + HEADER, payload.data(), payload.size());
+    size_t sent = 0;
+    while (sent < buf.size()) {
+        // a closed peer is reported as an error instead of raising SIGPIPE
+        const ssize_t r = send(fd, buf.data() + sent, buf.size() - sent, MSG_NOSIGNAL);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return false;
+        sent += (size_t) r;
+    }
+    return true;
+}
+
+Server::Server(const std::string& path, ThreadPool& pool, size_t max_in_flight, size_t max_connections):
+                        path(path),
+                        pool(pool),
+                        runner(pool),
+                        max_in_flight(max_in_flight ? max_in_flight : MAX_IN_FLIGHT_PER_THREAD * (pool.size() + 1)),
+                        max_connections(max_connections ? max_connections : DEFAULT_MAX_CONNECTIONS) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) throw std::runtime_error("invalid socket path " + path);
+    memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    // a socket left behind by a previous run is replaced, any other file is kept
+    struct stat st;
+    if (lstat(path.c_str(), &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) throw std::runtime_error(path + " exists and is not a socket");
+        unlink(path.c_str());
+    }
+    listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) throw system_error("can not create socket");
+    if (bind(listen_fd, (const sockaddr *) &addr, sizeof(addr)) < 0 || listen(listen_fd, SOMAXCONN) < 0) {
+        const std::runtime_error e = system_error("can not listen on " + path);
+        close(listen_fd);
+        throw e;
+    }
+}
+
+Server::~Server() {
+    stop();
+    close(listen_fd);
+    unlink(path.c_str());
+}
+
+void Server::stop() {
+    std::vector<std::thread> serving;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!stopping) {
+            stopping = true;
+            // wakes up accept, every reader and every writer blocked on a client that does not read;
+            // requests already running are finished, but their responses are dropped
+            shutdown(listen_fd, SHUT_RDWR);
+            for (const std::weak_ptr<Connection> &c : connections) {
+                if (std::shared_ptr<Connection> conn = c.lock()) {
+                    shutdown(conn->fd, SHUT_RDWR);
+                    std::lock_guard<std::mutex> conn_lock(conn->mutex);
+                    conn->broken = true;
+                    conn->changed.notify_all();
+                }
+            }
+            changed.notify_all();
+        }
+        // no reader starts once stopping is set, so these are all that are left
+        serving.swap(threads);
+    }
+    for (std::thread &t : serving) t.join();
+}
+
+Server::Stats Server::stats() const {
+    return {accepted.load(), completed.load(), throttled.load(), queued.load()};
+}
+
+void Server::run() {
+    while (true) {
+        std::vector<std::thread> done;
+        {
+            // beyond the limit new connections wait in the listen backlog until one ends
+            std::unique_lock<std::mutex> lock(mutex);
+            if (readers >= max_connections && !stopping) queued++;
+            changed.wait(lock, [this] { return readers < max_connections || stopping; });
+            if (stopping) break;
+            for (const std::thread::id id : finished) {
+                auto it = std::find_if(threads.begin(), threads.end(), [&] (const std::thread& t) { return t.get_id() == id; });
+                if (it == threads.end()) continue;
+                done.push_back(std::move(*it));
+                threads.erase(it);
+            }
+            finished.clear();
+        }
+        // these readers have returned or are about to, so joining them does not block
+        for (std::thread &t : done) t.join();
+        const int fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (stopping) break;
+            }
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            throw system_error("accept failed");
+        }
+        std::shared_ptr<Connection> conn = std::make_shared<Connection>(fd);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping) break;
+            readers++;
+            std::erase_if(connections, [] (const std::weak_ptr<Connection>& c) { return c.expired(); });
+            connections.push_back(conn);
+            accepted++;
+            threads.emplace_back(&Server::serve, this, std::move(conn));
+        }
+    }
+    std::vector<std::thread> serving;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this] { return readers == 0 && in_flight == 0; });
+        serving.swap(threads);
+    }
+    for (std::thread &t : serving) t.join();
+}
+
+void Server::serve(std::shared_ptr<Connection> conn) {
+    std::thread writer(&Server::write_loop, conn);
+    while (true) {
+        uint32_t id;
+        std::string request;
+        try {
+            if (!readFrame(conn->fd, id, request)) break;
+        } catch (std::exception&) {
+            // the stream can not be resynchronized after a bad frame
+            break;
+        }
+        {
+            // a client that does not read its responses only stops its own connection
+            std::unique_lock<std::mutex> lock(conn->mutex);
+            if (conn->pending >= MAX_PENDING_PER_CONNECTION) throttled++;
+            conn->changed.wait(lock, [&] { return conn->pending < MAX_PENDING_PER_CONNECTION || conn->broken; });
+            if (conn->broken) break;
+            conn->pending++;
+        }
+        bool stopped;
+        {
+            // backpressure: stop reading while too many requests are waiting for the pool
+            std::unique_lock<std::mutex> lock(mutex);
+            if (in_flight >= max_in_flight) throttled++;
+            changed.wait(lock, [this] { return in_flight < max_in_flight || stopping; });
+            stopped = stopping;
+            if (!stopped) in_flight++;
+        }
+        if (stopped) {
+            std::lock_guard<std::mutex> lock(conn->mutex);
+            conn->pending--;
+            conn->changed.notify_all();
+            break;
+        }
+        // jobs with many points call evalBatch on this same pool from inside the task, nested parallelFor calls are safe;
+        // the task only queues its response, so a slow client never holds a worker
+        pool.submit([this, conn, id, request = std::move(request)] (size_t) {
+            std::string response = runner.process(request);
+            if (response.size() > MAX_FRAME) response = "error: response too large";
+            {
+                std::lock_guard<std::mutex> lock(conn->mutex);
+                conn->outbox.emplace_back(id, std::move(response));
+                conn->changed.notify_all();
+            }
+            completed++;
+            // notify under the lock, run() may return and destroy the server as soon as the lock is released
+            std::lock_guard<std::mutex> lock(mutex);
+            in_flight--;
+            changed.notify_all();
+        });
+    }
+    {
+        std::lock_guard<std::mutex> lock(conn->mutex);
+        conn->reading = false;
+        conn->changed.notify_all();
+    }
+    // the connection ends once its last response is written or dropped, the socket is closed with the last reference
+    writer.join();
+    conn.reset();
+    std::lock_guard<std::mutex> lock(mutex);
+    readers--;
+    finished.push_back(std::this_thread::get_id());
+    changed.notify_all();
+}
+
+void Server::write_loop(std::shared_ptr<Connection> conn) {
+    std::unique_lock<std::mutex> lock(conn->mutex);
+    while (true) {
+        conn->changed.wait(lock, [&] { return !conn->outbox.empty() || (!conn->reading && conn->pending == 0); });
+        if (conn->outbox.empty()) return;
+        const std::pair<uint32_t, std::string> response = std::move(conn->outbox.front());
+        conn->outbox.pop_front();
+        const bool broken = conn->broken;
+        // the send may block for as long as the client does not read, without holding the lock
+        lock.unlock();
+        const bool sent = !broken && writeFrame(conn->fd, response.first, response.second);
+        lock.lock();
+        if (!sent) conn->broken = true;
+        conn->pending--;
+        conn->changed.notify_all();
+    }
+}
@@ -0,0 +1,84 @@
+#ifndef __SERVER_HPP__
+#define __SERVER_HPP__
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <thread>
+#include "ThreadPool.hpp"
+#include "BatchRunner.hpp"
+
+// 常驻进程的求值服务，监听一个 Unix 域套接字
+// 每个请求和应答都是一帧：4 字节的负载长度和 4 字节的请求编号（本机字节序），随后是负载
+// 请求的负载是一行 BatchRunner 格式的任务，应答的负载是同一任务在批处理模式下输出的那一行，编号与请求相同
+// 同一个连接上可以连续发送多个请求而不等待应答，应答按完成的顺序返回，由编号对应
+// 每个连接由一个线程读取请求、一个线程按完成的顺序写出应答，请求交给线程池执行，线程池的任务只把应答放入连接的队列
+// 同时服务的连接数有上限，达到上限时暂停接受新连接，新连接在监听队列中等待已有的连接结束
+// 已编译的表达式和结果保存在 ResultCache 中供后续请求复用
+// 所有连接上正在计算的请求数达到上限，或者一个连接上还没有写出应答的请求数达到上限时，停止读取新的请求，
+// 客户端的发送随之被套接字的缓冲区阻塞；不读取应答的客户端因此只会阻塞它自己的连接
+class Server {
+    public:
+        // 一帧负载的长度上限，超过时关闭连接
+        static const uint32_t MAX_FRAME = (uint32_t) 1 << 26;
+        // 每个线程最多对应的未完成请求数
+        static const size_t MAX_IN_FLIGHT_PER_THREAD = 4;
+        // 每个连接上最多未写出应答的请求数
+        static const size_t MAX_PENDING_PER_CONNECTION = 64;
+        // 默认最多同时服务的连接数，每个连接占用两个线程
+        static const size_t DEFAULT_MAX_CONNECTIONS = 256;
+        // 运行统计
+        struct Stats {
+            uint64_t connections; // 接受的连接数
+            uint64_t requests;    // 完成的请求数
+            uint64_t throttled;   // 因正在计算或未写出应答的请求过多而等待的次数
+            uint64_t queued;      // 因连接数达到上限而推迟接受新连接的次数
+        };
+    private:
+        struct Connection;
+        std::string path;
+        ThreadPool &pool;
+        BatchRunner runner;
+        size_t max_in_flight;
+        size_t max_connections;
+        int listen_fd = -1;
+        std::mutex mutex;
+        std::condition_variable changed;
+        size_t in_flight = 0; // 已读取但还没有计算完的请求数
+        size_t readers = 0;   // 还没有结束的连接数，连接在写完所有应答后结束
+        bool stopping = false;
+        std::vector<std::weak_ptr<Connection>> connections;
+        std::vector<std::thread> threads;           // 每个连接的读取线程，由 run 或 stop 回收
+        std::vector<std::thread::id> finished;      // 已经结束、还没有回收的读取线程
+        std::atomic<uint64_t> accepted{0}, completed{0}, throttled{0}, queued{0};
+        // 读取一个连接上的请求直到对方关闭或服务停止，然后等待这个连接的应答写完
+        void serve(std::shared_ptr<Connection> conn);
+        // 按完成的顺序写出一个连接的应答，只访问这个连接，写入失败后丢弃余下的应答
+        static void write_loop(std::shared_ptr<Connection> conn);
+    public:
+        // 在 path 上监听，已存在的套接字文件被替换；max_in_flight 为 0 时按线程数确定，max_connections 为 0 时取 DEFAULT_MAX_CONNECTIONS
+        explicit Server(const std::string& path, ThreadPool& pool = ThreadPool::shared(), size_t max_in_flight = 0, size_t max_connections = 0);
+        // 停止服务并删除套接字文件
+        ~Server();
+        Server(const Server&) = delete;
+        Server& operator=(const Server&) = delete;
+        // 接受连接直到 stop 被调用，返回前等待所有请求计算完毕、所有连接结束
+        void run();
+        // 可以在任意线程调用，关闭所有连接的读写，还没有写出的应答被丢弃，run 随后返回
+        // 返回前等待正在计算的请求完成，并回收所有连接的线程
+        void stop();
+        Stats stats() const;
+
+        // 读取一帧，对方在帧的边界关闭连接时返回 false，帧不完整或过长时抛出异常
+        static bool readFrame(int fd, uint32_t& id, std::string& payload);
+        // 写入一帧，对方已关闭连接时返回 false
+        static bool writeFrame(int fd, uint32_t id, std::string_view payload);
+};
+
+#endif
@@ -0,0 +1,243 @@
+#ifndef __STATIC_FIXED_FLOAT_HPP__
+#define __STATIC_FIXED_FLOAT_HPP__
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <array>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include "FixedFloat.hpp"
+#include "Multiplier.hpp"
+
+// 基数和位数在编译期确定的 FixedFloat，limb 直接存放在对象内的 std::array 中
+// limb 的布局与 FixedFloat 完全相同，两者之间的转换只是复制数组；运算不检查格式，加减和比较不分配内存，
+// 乘法在 LEN < INLINE_MUL_LIMBS 时也不分配，更长的格式在运行期交给 Multiplier，其临时数组来自 LimbAllocator，
+// 所有常数在编译期算出，按 limb 的基数取模因此变为乘法和移位，循环的次数也是常数
+// 位数与 FixedFloat 一样是 64 位的，上限同为 FixedFloat::MAX_DIGIT_LEN；但 limb 存放在对象内，乘法的积还放在栈上，
+// 实际可用的位数受对象和栈的大小限制，很长的格式应使用 FixedFloat
+template <uint16_t Base, uint64_t IntDigits, uint64_t DecDigits>
+class StaticFixedFloat {
+        static_assert(Base >= 2 && Base <= 36, "base should be in [2, 36]");
+        static_assert(IntDigits <= FixedFloat::MAX_DIGIT_LEN && DecDigits <= FixedFloat::MAX_DIGIT_LEN - IntDigits, "digit length exceeds FixedFloat::MAX_DIGIT_LEN");
+    private:
+        // 与 FixedFloat 的构造函数相同的格式计算
+        struct Format {
+            uint16_t digit_per_limb = 0;
+            uint64_t limb_base = 1;
+            uint64_t dec_limb_len = 0;
+            uint16_t pad_digit_len = 0;
+            uint64_t len = 0;
+            uint32_t low_unit = 1;
+            uint64_t top_unit = 1;
+            constexpr Format() {
+                while (limb_base * Base <= ((uint64_t) 1 << 32)) {
+                    limb_base *= Base;
+                    digit_per_limb++;
+                }
+                dec_limb_len = (DecDigits + digit_per_limb - 1) / digit_per_limb;
+                pad_digit_len = (uint16_t) (dec_limb_len * digit_per_limb - DecDigits);
+                len = dec_limb_len + (IntDigits + digit_per_limb - 1) / digit_per_limb;
+                if (len == 0) len = 1;
+                for (uint16_t i = 0; i < pad_digit_len; i++) low_unit *= Base;
+                for (uint64_t i = pad_digit_len + IntDigits + DecDigits - (len - 1) * digit_per_limb; i > 0; i--) top_unit *= Base;
+            }
+        };
+        static constexpr Format FORMAT{};
+    public:
+        static constexpr uint16_t DIGIT_PER_LIMB = FORMAT.digit_per_limb;
+        static constexpr uint64_t LIMB_BASE = FORMAT.limb_base;
+        static constexpr uint64_t DEC_LIMB_LEN = FORMAT.dec_limb_len;
+        static constexpr uint16_t PAD_DIGIT_LEN = FORMAT.pad_digit_len;
+        static constexpr uint64_t LEN = FORMAT.len;
+        static constexpr uint32_t LOW_UNIT = FORMAT.low_unit;
+        static constexpr uint64_t TOP_UNIT = FORMAT.top_unit;
+        // 乘法不少于该 limb 数时在运行期交给 Multiplier，这时会分配临时数组
+        static constexpr size_t INLINE_MUL_LIMBS = 32;
+    private:
+        bool sign = false;
+        std::array<uint32_t, LEN> arr{};
+
+        static constexpr uint32_t split(uint64_t val, uint64_t &carry) {
+            carry = val / LIMB_BASE;
+            return (uint32_t) (val - carry * LIMB_BASE);
+        }
+        constexpr void normalize() {
+            arr[0] -= arr[0] % LOW_UNIT;
+            if constexpr (TOP_UNIT != LIMB_BASE) arr[LEN - 1] %= TOP_UNIT;
+            if (isZero()) sign = false;
+        }
+        constexpr int compare_abs(const std::array<uint32_t, LEN>& other) const {
+            for (size_t i = LEN; i > 0; i--) {
+                if (arr[i - 1] != other[i - 1]) return arr[i - 1] < other[i - 1] ? -1 : 1;
+            }
+            return 0;
+        }
+        // 原地加上绝对值为 other、符号为 other_sign 的数，与 FixedFloat::add_limbs 相同
+        constexpr void add_limbs(const std::array<uint32_t, LEN>& other, bool other_sign) {
+            if (sign == other_sign) {
+                uint64_t carry = 0;
+                for (size_t i = 0; i < LEN; i++) {
+                    uint64_t val = (uint64_t) arr[i] + other[i] + carry;
+                    carry = val >= LIMB_BASE;
+                    arr[i] = (uint32_t) (val - (carry ? LIMB_BASE : 0));
+                }
+            } else {
+                const bool larger = compare_abs(other) >= 0;
+                const std::array<uint32_t, LEN> &a = larger ? arr : other;
+                const std::array<uint32_t, LEN> &b = larger ? other : arr;
+                std::array<uint32_t, LEN> r{};
+                uint64_t borrow = 0;
+                for (size_t i = 0; i < LEN; i++) {
+                    uint64_t sub = (uint64_t) b[i] + borrow;
+                    borrow = a[i] < sub;
+                    r[i] = (uint32_t) (a[i] + (borrow ? LIMB_BASE : 0) - sub);
+                }
+                if (!larger) sign = other_sign;
+                arr = r;
+            }
+            normalize();
+        }
+        // 截断后的 |a * b|，与 FixedFloat::product_limbs 相同
+        static constexpr std::array<uint32_t, LEN> product(const StaticFixedFloat& a, const StaticFixedFloat& b) {
+            std::array<uint32_t, 2 * LEN> prod{};
+            if (std::is_constant_evaluated() || LEN < INLINE_MUL_LIMBS) {
+                for (size_t i = 0; i < LEN; i++) {
+                    if (!a.arr[i]) continue;
+                    uint64_t carry = 0;
+                    for (size_t j = 0; j < LEN; j++) {
+                        prod[i + j] = split((uint64_t) a.arr[i] * b.arr[j] + prod[i + j] + carry, carry);
+                    }
+                    prod[i + LEN] = (uint32_t) carry;
+                }
+            } else {
+                Multiplier::mul(a.arr.data(), LEN, b.arr.data(), LEN, prod.data(), LIMB_BASE);
+            }
+            std::array<uint32_t, LEN> ret{};
+            for (size_t i = 0; i < LEN; i++) ret[i] = prod[i + DEC_LIMB_LEN];
+            ret[0] -= ret[0] % LOW_UNIT;
+            if constexpr (TOP_UNIT != LIMB_BASE) ret[LEN - 1] %= TOP_UNIT;
+            return ret;
+        }
+        static constexpr uint32_t char_value(char c) {
+            return c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'z' ? c - 'a' + 10 : c - 'A' + 10;
+        }
+        // 写入第 i 位数字，下标 0 为最低位的小数
+        constexpr void write_digit(uint64_t i, uint32_t val) {
+            uint64_t pos = i + PAD_DIGIT_LEN;
+            uint64_t unit = 1;
+            for (uint32_t j = pos % DIGIT_PER_LIMB; j > 0; j--) unit *= Base;
+            uint32_t &limb = arr[pos / DIGIT_PER_LIMB];
+            uint32_t old = (uint32_t) (limb / unit % Base);
+            limb = (uint32_t) (limb - old * unit + val % Base * unit);
+        }
+    public:
+        constexpr StaticFixedFloat() = default;
+        // 解析与 FixedFloat 相同格式的字符串，超出的整数高位和小数低位被截断
+        constexpr explicit StaticFixedFloat(std::string_view str) {
+            size_t i = 0, size = str.size();
+            while (i < size && str[i] == ' ') i++;
+            while (size > i && str[size - 1] == ' ') size--;
+            if (i < size && (str[i] == '-' || str[i] == '+')) sign = str[i++] == '-';
+            size_t dot = str.find('.', i);
+            if (dot == std::string_view::npos || dot > size) dot = size;
+            for (size_t j = 0; j < dot - i && j < IntDigits; j++) write_digit(DecDigits + j, char_value(str[dot - 1 - j]));
+            for (size_t j = 0; j + dot + 1 < size && j < DecDigits; j++) write_digit(DecDigits - j - 1, char_value(str[dot + 1 + j]));
+            normalize();
+        }
+        // 整数，超出整数位数的高位被截断
+        static constexpr StaticFixedFloat fromInt(int64_t v) {
+            StaticFixedFloat ret;
+            ret.sign = v < 0;
+            uint64_t u = v < 0 ? 0 - (uint64_t) v : (uint64_t) v;
+            for (size_t i = DEC_LIMB_LEN; i < LEN && u; i++) {
+                ret.arr[i] = (uint32_t) (u % LIMB_BASE);
+                u /= LIMB_BASE;
+            }
+            ret.normalize();
+            return ret;
+        }
+        // 从动态的 FixedFloat 转换，格式不同时先用 convertTo 转换
+        explicit StaticFixedFloat(const FixedFloat& f) {
+            if (f.base == Base && f.int_digit_len == IntDigits && f.dec_digit_len == DecDigits) {
+                memcpy(arr.data(), f.arr, LEN * sizeof(uint32_t));
+                sign = f.sign;
+            } else {
+                const FixedFloat g = f.convertTo(Base, IntDigits, DecDigits);
+                memcpy(arr.data(), g.arr, LEN * sizeof(uint32_t));
+                sign = g.sign;
+            }
+        }
+        // 转换为同样格式的 FixedFloat
+        FixedFloat toFixedFloat() const {
+            FixedFloat ret(Base, IntDigits, DecDigits);
+            memcpy(ret.arr, arr.data(), LEN * sizeof(uint32_t));
+            ret.sign = sign;
+            ret.normalize();
+            return ret;
+        }
+        explicit operator FixedFloat() const { return toFixedFloat(); }
+
+        static constexpr uint16_t getBase() { return Base; }
+        static constexpr uint64_t getIntDigitLen() { return IntDigits; }
+        static constexpr uint64_t getDecDigitLen() { return DecDigits; }
+        constexpr bool isZero() const {
+            for (size_t i = 0; i < LEN; i++)
+                if (arr[i]) return false;
+            return true;
+        }
+        constexpr bool isNegative() const { return sign; }
+        // 原始的 limb 数组，布局与 FixedFloat 相同
+        constexpr const std::array<uint32_t, LEN>& limbs() const { return arr; }
+        constexpr double doubleValue() const {
+            double int_ret = 0, dec_ret = 0;
+            for (size_t i = LEN; i > DEC_LIMB_LEN; i--) int_ret = int_ret * LIMB_BASE + arr[i - 1];
+            for (size_t i = 0; i < DEC_LIMB_LEN; i++) dec_ret = (dec_ret + arr[i]) / LIMB_BASE;
+            return sign ? -(int_ret + dec_ret) : int_ret + dec_ret;
+        }
+        std::string toString() const { return toFixedFloat().toString(); }
+
+        constexpr StaticFixedFloat operator-() const {
+            StaticFixedFloat ret(*this);
+            ret.sign = !isZero() && !sign;
+            return ret;
+        }
+        constexpr bool operator==(const StaticFixedFloat& other) const {
+            return sign == other.sign && compare_abs(other.arr) == 0;
+        }
+        constexpr bool operator<(const StaticFixedFloat& other) const {
+            if (sign != other.sign) return sign;
+            int cmp = compare_abs(other.arr);
+            return sign ? cmp > 0 : cmp < 0;
+        }
+        constexpr bool operator>(const StaticFixedFloat& other) const { return other < *this; }
+        constexpr StaticFixedFloat& operator+=(const StaticFixedFloat& other) {
+            add_limbs(other.arr, other.sign);
+            return *this;
+        }
+        constexpr StaticFixedFloat& operator-=(const StaticFixedFloat& other) {
+            add_limbs(other.arr, !other.sign);
+            return *this;
+        }
+        constexpr StaticFixedFloat& operator*=(const StaticFixedFloat& other) {
+            arr = product(*this, other);
+            sign ^= other.sign;
+            normalize();
+            return *this;
+        }
+        // 原地加上 a * b，乘积先截断再相加，与 FixedFloat::fma 相同
+        constexpr StaticFixedFloat& fma(const StaticFixedFloat& a, const StaticFixedFloat& b) {
+            add_limbs(product(a, b), a.sign ^ b.sign);
+            return *this;
+        }
+        constexpr StaticFixedFloat operator+(const StaticFixedFloat& other) const { return StaticFixedFloat(*this) += other; }
+        constexpr StaticFixedFloat operator-(const StaticFixedFloat& other) const { return StaticFixedFloat(*this) -= other; }
+        constexpr StaticFixedFloat operator*(const StaticFixedFloat& other) const { return StaticFixedFloat(*this) *= other; }
+        // 除法借助 FixedFloat 的 Newton 除法完成，会分配内存
+        StaticFixedFloat operator/(const StaticFixedFloat& other) const {
+            return StaticFixedFloat(toFixedFloat() / other.toFixedFloat());
+        }
+};
+
+#endif
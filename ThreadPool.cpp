@@ -0,0 +1,137 @@
+#include "ThreadPool.hpp"
+
+#include <exception>
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t n) {
+    if (n == 0) n = std::max<size_t>(1, std::thread::hardware_concurrency());
+    for (size_t i = 0; i < n; i++) workers.emplace_back(new Worker());
+    for (size_t i = 0; i < n; i++) threads.emplace_back(&ThreadPool::run, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread &t : threads) t.join();
+}
+
+size_t ThreadPool::size() const {
+    return workers.size();
+}
+
+bool ThreadPool::pop_task(size_t self, Task& task) {
+    const size_t n = workers.size();
+    // own queue first, newest task is the warmest in cache
+    if (self < n) {
+        Worker &w = *workers[self];
+        std::lock_guard<std::mutex> lock(w.mutex);
+        if (!w.tasks.empty()) {
+            task = std::move(w.tasks.back());
+            w.tasks.pop_back();
+            pending--;
+            return true;
+        }
+    }
+    // steal the oldest task of another queue
+    for (size_t k = 1; k <= n; k++) {
+        Worker &w = *workers[(self + k) % n];
+        std::lock_guard<std::mutex> lock(w.mutex);
+        if (!w.tasks.empty()) {
+            task = std::move(w.tasks.front());
+            w.tasks.pop_front();
+            pending--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::run(size_t self) {
+    Task task;
+    while (true) {
+        if (pop_task(self, task)) {
+            task(self);
+            task = nullptr;
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        wake.wait(lock, [this] { return stopping || pending > 0; });
+        if (stopping) return;
+    }
+}
+
+void ThreadPool::submit(Task task) {
+    Worker &w = *workers[next++ % workers.size()];
+    {
+        // count it under the sleep lock first so that the counter never goes below the queued tasks
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        pending++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(w.mutex);
+        w.tasks.push_back(std::move(task));
+    }
+    wake.notify_one();
+}
+
+void ThreadPool::parallelFor(size_t n, size_t grain, const std::function<void(size_t, size_t, size_t)>& body) {
+    if (n == 0) return;
+    if (grain == 0) grain = 1;
+    // a few chunks per thread so that uneven work still balances
+    size_t chunk = std::max(grain, (n + 4 * (size() + 1) - 1) / (4 * (size() + 1)));
+    const size_t chunks = (n + chunk - 1) / chunk;
+    if (chunks == 1) {
+        body(0, n, size());
+        return;
+    }
+
+    // chunks are claimed from a counter of this call, so a thread only ever runs chunks of the calls it is in;
+    // helping with unrelated tasks would run them under the number of the caller, which another caller shares
+    struct Loop {
+        const std::function<void(size_t, size_t, size_t)> *body;
+        size_t n, chunk, chunks;
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> remaining;
+        std::mutex done_mutex;
+        std::condition_variable done;
+        std::exception_ptr error;
+        // runs chunks until none is left, the body is only touched while the caller is still waiting for a chunk
+        void work(size_t thread) {
+            for (size_t c; (c = next++) < chunks; ) {
+                const size_t begin = c * chunk, end = std::min(n, begin + chunk);
+                try {
+                    (*body)(begin, end, thread);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(done_mutex);
+                    if (!error) error = std::current_exception();
+                }
+                std::lock_guard<std::mutex> lock(done_mutex);
+                if (--remaining == 0) done.notify_all();
+            }
+        }
+    };
+    // the loop is shared with the queued tasks, which may only start after the call has returned
+    std::shared_ptr<Loop> loop = std::make_shared<Loop>();
+    loop->body = &body;
+    loop->n = n;
+    loop->chunk = chunk;
+    loop->chunks = chunks;
+    loop->remaining = chunks;
+    for (size_t t = 0; t < std::min(size(), chunks - 1); t++) {
+        submit([loop] (size_t thread) { loop->work(thread); });
+    }
+
+    // the calling thread works through the chunks too, so nested calls finish even when every worker is busy
+    loop->work(size());
+    std::unique_lock<std::mutex> lock(loop->done_mutex);
+    loop->done.wait(lock, [&] { return loop->remaining == 0; });
+    if (loop->error) std::rethrow_exception(loop->error);
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
@@ -0,0 +1,53 @@
+#ifndef __THREAD_POOL_HPP__
+#define __THREAD_POOL_HPP__
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <functional>
+
+// 工作窃取线程池，每个工作线程有自己的任务队列，空闲时从其他队列的另一端窃取任务
+class ThreadPool {
+    public:
+        // 任务的参数为执行它的线程编号，工作线程为 [0, size())，调用 parallelFor 的线程为 size()
+        typedef std::function<void(size_t)> Task;
+    private:
+        struct Worker {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::vector<std::thread> threads;
+        std::mutex sleep_mutex;
+        std::condition_variable wake;
+        std::atomic<size_t> pending{0}; // 尚未被取走的任务数
+        std::atomic<size_t> next{0}; // 下一个任务放入的队列
+        bool stopping = false;
+        // 先从自己队列的尾部取任务，再从其他队列的头部窃取
+        bool pop_task(size_t self, Task& task);
+        void run(size_t self);
+    public:
+        // 创建 n 个工作线程，n 为 0 时使用硬件线程数
+        explicit ThreadPool(size_t n = 0);
+        ~ThreadPool();
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+        // 工作线程数
+        size_t size() const;
+        // 提交一个任务
+        void submit(Task task);
+        // 把 [0, n) 切成不小于 grain 的块并行执行 body(begin, end, thread)，调用线程也参与执行，返回时全部完成
+        // 调用线程只执行本次调用的块，所以同一次调用中同时运行的 body 的 thread 各不相同，
+        // 多个线程同时调用或在 body 中嵌套调用时也是如此，可以用 thread 选择本次调用自己的缓冲区
+        void parallelFor(size_t n, size_t grain, const std::function<void(size_t, size_t, size_t)>& body);
+        // 进程共享的线程池
+        static ThreadPool& shared();
+};
+
+#endif
@@ -0,0 +1,142 @@
+#include <cstdint>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "FixedFloat.hpp"
+#include "Expression.hpp"
+#include "Multiplier.hpp"
+#include "ResultCache.hpp"
+#include "Serializer.hpp"
+#include "StaticFixedFloat.hpp"
+
+// time every kernel over a matrix of bases and precisions, and print the results as CSV or JSON
+// usage: bench [--json] [--max-digits N] [--min-time MS] [--tune]
+
+struct Result {
+    std::string op;
+    uint32_t base;
+    uint32_t digits;
+    uint64_t iterations;
+    double ns_per_op;
+};
+
+static const char DIGITS[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+static std::string random_number(std::mt19937_64 &rng, uint32_t base, uint32_t int_len, uint32_t dec_len) {
+    std::string s;
+    for (uint32_t i = 0; i < int_len; i++) s.push_back(DIGITS[rng() % base]);
+    s.push_back('.');
+    for (uint32_t i = 0; i < dec_len; i++) s.push_back(DIGITS[rng() % base]);
+    return s;
+}
+
+// repeat body until it has run for at least min_time seconds, doubling the batch each round
+static Result measure(const std::string &op, uint32_t base, uint32_t digits, double min_time, const std::function<void()> &body) {
+    // one untimed call first, so one-off work such as preparing an expression for a new format is not counted
+    body();
+    uint64_t total = 0, batch = 1;
+    double elapsed = 0;
+    while (elapsed < min_time) {
+        auto t0 = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < batch; i++) body();
+        elapsed += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        total += batch;
+        batch *= 2;
+    }
+    return {op, base, digits, total, elapsed * 1e9 / total};
+}
+
+// the same kernels on a compile-time format, with inline storage and constant limb arithmetic
+template <uint16_t Base, uint64_t IntDigits, uint64_t DecDigits>
+static void measure_static(std::vector<Result> &results, std::mt19937_64 &rng, double min_time) {
+    typedef StaticFixedFloat<Base, IntDigits, DecDigits> Static;
+    const Static a(random_number(rng, Base, IntDigits / 2, DecDigits)), b(random_number(rng, Base, IntDigits / 2, DecDigits));
+    Static sink;
+    results.push_back(measure("add_static", Base, DecDigits, min_time, [&] { sink = a + b; }));
+    results.push_back(measure("sub_static", Base, DecDigits, min_time, [&] { sink = a - b; }));
+    results.push_back(measure("mul_static", Base, DecDigits, min_time, [&] { sink = a * b; }));
+}
+
+int main(int argc, char **argv) {
+    bool json = false, tune = false;
+    uint32_t max_digits = 100000;
+    double min_time = 0.05;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--json") json = true;
+        else if (arg == "--tune") tune = true;
+        else if (arg == "--max-digits" && i + 1 < argc) max_digits = std::stoul(argv[++i]);
+        else if (arg == "--min-time" && i + 1 < argc) min_time = std::stod(argv[++i]) / 1000;
+        else {
+            std::cerr << "usage: " << argv[0] << " [--json] [--max-digits N] [--min-time MS] [--tune]" << std::endl;
+            return 1;
+        }
+    }
+    // measure the multiplication crossovers first so that the kernels below use them
+    if (tune) Multiplier::tune(std::cerr);
+
+    const uint32_t INT_LEN = 20;
+    std::mt19937_64 rng(12345);
+    const Expression poly("3/7x^2-1/3x+2"), rational("x^3/(x+2)-1/3");
+    ResultCache cache;
+    std::vector<Result> results;
+    for (uint32_t base : {2, 10, 16, 36}) {
+        for (uint32_t digits : {10, 100, 1000, 10000, 100000}) {
+            if (digits > max_digits) continue;
+            const FixedFloat a(base, INT_LEN, digits, random_number(rng, base, INT_LEN / 2, digits));
+            const FixedFloat b(base, INT_LEN, digits, random_number(rng, base, INT_LEN / 2, digits));
+            const FixedFloat x(base, INT_LEN, digits, "1." + random_number(rng, base, 0, digits).substr(1));
+            const std::string str = a.toString();
+            const uint16_t target = base == 10 ? 16 : 10;
+            // a base sharing a root with base, whose conversion only regroups digits
+            const uint16_t related = base == 2 ? 16 : base == 16 ? 2 : base == 10 ? 100 : 6;
+            FixedFloat sink(base, INT_LEN, digits);
+            std::string text;
+
+            results.push_back(measure("add", base, digits, min_time, [&] { sink = a + b; }));
+            results.push_back(measure("sub", base, digits, min_time, [&] { sink = a - b; }));
+            results.push_back(measure("mul", base, digits, min_time, [&] { sink = a * b; }));
+            results.push_back(measure("convertTo", base, digits, min_time, [&] { FixedFloat r = a.convertTo(target, INT_LEN, digits); }));
+            results.push_back(measure("convertTo_related", base, digits, min_time, [&] { FixedFloat r = a.convertTo(related, INT_LEN, digits); }));
+            results.push_back(measure("parse", base, digits, min_time, [&] { FixedFloat r(base, INT_LEN, digits, str); }));
+            results.push_back(measure("toString", base, digits, min_time, [&] { text = a.toString(); }));
+            std::string bytes;
+            Serializer::write(a, bytes);
+            results.push_back(measure("write_binary", base, digits, min_time, [&] { text.clear(); Serializer::write(a, text); }));
+            results.push_back(measure("read_binary", base, digits, min_time, [&] { size_t offset = 0; sink = Serializer::read(bytes.data(), bytes.size(), offset); }));
+            results.push_back(measure("eval_poly", base, digits, min_time, [&] { sink = poly.eval(x); }));
+            results.push_back(measure("eval_rational", base, digits, min_time, [&] { sink = rational.eval(x); }));
+            // per point, over a table of points evaluated together
+            std::vector<FixedFloat> table(64, x);
+            for (size_t i = 0; i < table.size(); i++) table[i] = FixedFloat(base, INT_LEN, digits, "1." + random_number(rng, base, 0, digits).substr(1));
+            Result tab = measure("eval_poly_table", base, digits, min_time, [&] { std::vector<FixedFloat> r = poly.evalBatch(table); });
+            tab.ns_per_op /= table.size();
+            results.push_back(tab);
+            results.push_back(measure("eval_cached", base, digits, min_time, [&] { sink = cache.eval("x^3/(x+2)-1/3", x); }));
+        }
+    }
+
+    measure_static<2, 20, 100>(results, rng, min_time);
+    measure_static<10, 20, 100>(results, rng, min_time);
+    measure_static<10, 20, 200>(results, rng, min_time);
+    measure_static<10, 20, 1000>(results, rng, min_time);
+
+    if (json) {
+        std::cout << "[\n";
+        for (size_t i = 0; i < results.size(); i++) {
+            const Result &r = results[i];
+            std::cout << "  {\"op\": \"" << r.op << "\", \"base\": " << r.base << ", \"digits\": " << r.digits
+                      << ", \"iterations\": " << r.iterations << ", \"ns_per_op\": " << r.ns_per_op << "}"
+                      << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        std::cout << "]\n";
+    } else {
+        std::cout << "op,base,digits,iterations,ns_per_op\n";
+        for (const Result &r : results)
+            std::cout << r.op << ',' << r.base << ',' << r.digits << ',' << r.iterations << ',' << r.ns_per_op << '\n';
+    }
+    return 0;
+}
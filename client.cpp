@@ -0,0 +1,118 @@
+#include <cstdint>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "Server.hpp"
+
+static int connect_to(const std::string& path) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) throw std::runtime_error("invalid socket path " + path);
+    memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, (const sockaddr *) &addr, sizeof(addr)) < 0) {
+        if (fd >= 0) close(fd);
+        throw std::runtime_error("can not connect to " + path + ": " + strerror(errno));
+    }
+    return fd;
+}
+
+// send requests count times in a row, jobs[i % jobs.size()] for the i-th one, with at most depth of them
+// unanswered, and store each response and its latency in nanoseconds under the index of its request
+static void drive(const std::string& path, const std::vector<std::string>& jobs, size_t first, size_t count, size_t depth,
+                  std::vector<std::string>& responses, std::vector<uint64_t>& latencies) {
+    typedef std::chrono::steady_clock Clock;
+    const int fd = connect_to(path);
+    std::vector<Clock::time_point> sent_at(count);
+    size_t sent = 0, received = 0;
+    while (received < count) {
+        while (sent < count && sent - received < depth) {
+            sent_at[sent] = Clock::now();
+            if (!Server::writeFrame(fd, (uint32_t) sent, jobs[(first + sent) % jobs.size()])) throw std::runtime_error("connection closed");
+            sent++;
+        }
+        uint32_t id;
+        std::string payload;
+        if (!Server::readFrame(fd, id, payload) || id >= sent) throw std::runtime_error("connection closed");
+        latencies[first + id] = (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - sent_at[id]).count();
+        responses[first + id] = std::move(payload);
+        received++;
+    }
+    close(fd);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " SOCKET [--requests N] [--connections C] [--depth D] < jobs.txt" << std::endl;
+        return 1;
+    }
+    // without --requests every job is sent once and the results are printed in input order,
+    // with it the jobs are replayed N times in total and only the throughput and latencies are printed
+    const std::string path = argv[1];
+    size_t requests = 0, connections = 1, depth = 32;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        const std::string opt = argv[i];
+        const size_t val = std::stoull(argv[i + 1]);
+        if (opt == "--requests") requests = val;
+        else if (opt == "--connections") connections = std::max<size_t>(val, 1);
+        else if (opt == "--depth") depth = std::max<size_t>(val, 1);
+        else {
+            std::cerr << "unknown option " << opt << std::endl;
+            return 1;
+        }
+    }
+    std::vector<std::string> jobs;
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        if (!line.empty() && line[0] != '#') jobs.push_back(line);
+    }
+    if (jobs.empty()) return 0;
+    const bool bench = requests > 0;
+    const size_t total = bench ? requests : jobs.size();
+    connections = std::min(connections, total);
+
+    std::vector<std::string> responses(total);
+    std::vector<uint64_t> latencies(total);
+    std::vector<std::thread> threads;
+    std::vector<std::string> errors(connections);
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t c = 0; c < connections; c++) {
+        // connection c sends the c-th contiguous share of the requests
+        const size_t first = total * c / connections, last = total * (c + 1) / connections;
+        threads.emplace_back([&, c, first, last] {
+            try {
+                drive(path, jobs, first, last - first, depth, responses, latencies);
+            } catch (std::exception &e) {
+                errors[c] = e.what();
+            }
+        });
+    }
+    for (std::thread &t : threads) t.join();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    for (const std::string &e : errors) {
+        if (!e.empty()) {
+            std::cerr << e << std::endl;
+            return 1;
+        }
+    }
+
+    if (!bench) {
+        for (const std::string &r : responses) std::cout << r << '\n';
+        return 0;
+    }
+    const size_t failed = std::count_if(responses.begin(), responses.end(), [] (const std::string& r) { return r.rfind("error:", 0) == 0; });
+    std::sort(latencies.begin(), latencies.end());
+    const auto pct = [&] (double p) { return latencies[std::min(total - 1, (size_t) (p * total))] / 1e3; };
+    std::cout << "requests " << total << ", errors " << failed << ", " << seconds << " s, " << total / seconds << " req/s" << std::endl;
+    std::cout << "latency us: p50 " << pct(0.5) << ", p90 " << pct(0.9) << ", p99 " << pct(0.99) << ", max " << latencies.back() / 1e3 << std::endl;
+    return 0;
+}
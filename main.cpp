@@ -5,15 +5,122 @@
 #include <queue>
 #include <functional>
 #include <stdexcept>
+#include <fstream>
+#include <algorithm>
 #include "Expression.hpp"
+#include "Multiplier.hpp"
+#include "BatchRunner.hpp"
+#include "Profiler.hpp"
+#include "Server.hpp"
+#include <thread>
+#include <csignal>
+#include <pthread.h>
 
-int main() {
+int main(int argc, char **argv) {
+    // benchmark mode: measure the multiplication crossover points on this host
+    if (argc > 1 && std::string(argv[1]) == "--bench-mul") {
+        Multiplier::tune(std::cout);
+        return 0;
+    }
+    // batch mode: read jobs from a file or stdin, write one result line per job
+    if (argc > 1 && std::string(argv[1]) == "--batch") {
+        std::ios::sync_with_stdio(false);
+        BatchRunner runner;
+        if (argc > 2 && std::string(argv[2]) != "-") {
+            std::ifstream in(argv[2]);
+            if (!in) {
+                std::cerr << "can not open " << argv[2] << std::endl;
+                return 1;
+            }
+            runner.run(in, std::cout);
+        } else {
+            runner.run(std::cin, std::cout);
+        }
+        return 0;
+    }
+    // server mode: answer batch jobs over a Unix socket until SIGINT or SIGTERM
+    if (argc > 1 && std::string(argv[1]) == "--serve") {
+        if (argc < 3) {
+            std::cerr << "usage: " << argv[0] << " --serve SOCKET" << std::endl;
+            return 1;
+        }
+        // one thread takes the signals, so they are blocked before any other thread starts
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+        try {
+            Server server(argv[2]);
+            std::thread waiter([&] {
+                int sig;
+                sigwait(&signals, &sig);
+                server.stop();
+            });
+            try {
+                server.run();
+            } catch (...) {
+                pthread_kill(waiter.native_handle(), SIGTERM);
+                waiter.join();
+                throw;
+            }
+            waiter.join();
+            const Server::Stats stats = server.stats();
+            std::cerr << "served " << stats.requests << " requests on " << stats.connections << " connections, throttled " << stats.throttled << " times, queued connections " << stats.queued << " times" << std::endl;
+        } catch (std::exception &e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+    // profile mode: evaluate one expression and print the time and sizes of every operation
+    if (argc > 1 && std::string(argv[1]) == "--profile") {
+        // eval at DIGITS fractional digits, so the Horner path is measured as it runs; --adaptive measures evalAdaptive instead
+        const bool adaptive = argc > 2 && std::string(argv[2]) == "--adaptive";
+        char **args = adaptive ? argv + 1 : argv;
+        const int args_len = adaptive ? argc - 1 : argc;
+        if (args_len < 5) {
+            std::cerr << "usage: " << argv[0] << " --profile [--adaptive] EXPRESSION X DIGITS [TRACE_FILE]" << std::endl
+                      << "measures Expression::eval with DIGITS fractional digits, or with --adaptive evalAdaptive to DIGITS correct digits" << std::endl;
+            return 1;
+        }
+        try {
+            const std::string input = args[3];
+            const uint64_t digits = std::stoull(args[4]);
+            Expression e(args[2]);
+            Profiler::Profile profile(std::string(adaptive ? "evalAdaptive " : "eval ") + args[2], args_len > 5);
+            if (adaptive) {
+                // x keeps all of its own digits, like interactive mode 3
+                size_t dot = input.find('.');
+                uint64_t dec_digit_len = dot == std::string::npos ? 1 : std::max<size_t>(input.size() - dot - 1, 1);
+                FixedFloat x(10, 20, dec_digit_len, input);
+                Profiler::Scope scope(&profile);
+                e.evalAdaptive(x, digits);
+            } else {
+                FixedFloat x(10, 20, digits, input);
+                Profiler::Scope scope(&profile);
+                e.eval(x);
+            }
+            std::cout << profile.toText() << profile.toJson() << std::endl;
+            if (args_len > 5) {
+                std::ofstream out(args[5]);
+                out << profile.toChromeTrace();
+                if (!out) {
+                    std::cerr << "can not write " << args[5] << std::endl;
+                    return 1;
+                }
+            }
+        } catch (std::exception &e) {
+            std::cerr << "Invalid: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
     while (true) {
-        std::cout << "Please choose a mode (1 to base conversion, 2 to expression evaluation, q to quit): ";
+        std::cout << "Please choose a mode (1 to base conversion, 2 to expression evaluation, 3 to adaptive evaluation, q to quit): ";
         std::string mode_str;
-        std::getline(std::cin, mode_str);
-        if (mode_str == "q") break;
-        if (mode_str != "1" && mode_str != "2") {
+        if (!std::getline(std::cin, mode_str) || mode_str == "q") break;
+        if (mode_str != "1" && mode_str != "2" && mode_str != "3") {
             std::cout << "Invalid mode" << std::endl;
             continue;
         }
@@ -31,12 +138,12 @@ int main() {
                     std::cout << "Please choose an integer digit length: ";
                     std::string int_digit_len_str;
                     std::getline(std::cin, int_digit_len_str);
-                    uint16_t int_digit_len = std::stoi(int_digit_len_str);
+                    uint64_t int_digit_len = std::stoull(int_digit_len_str);
 
                     std::cout << "Please choose a decimal digit length: ";
                     std::string dec_digit_len_str;
                     std::getline(std::cin, dec_digit_len_str);
-                    uint16_t dec_digit_len = std::stoi(dec_digit_len_str);
+                    uint64_t dec_digit_len = std::stoull(dec_digit_len_str);
 
                     std::cout << "Please input a number: ";
                     std::string num_str;
@@ -77,6 +184,34 @@ int main() {
                 }
                 break;
             }
+            case 3: {
+                std::cout << "Please input an expression: ";
+                std::string expr;
+                std::getline(std::cin, expr);
+                try {
+                    Expression e(expr);
+                    std::cout << "Please choose the number of correct decimal digits: ";
+                    std::string digits_str;
+                    std::getline(std::cin, digits_str);
+                    uint64_t digits = std::stoull(digits_str);
+                    while (true) {
+                        std::cout << "Please input a value for x (q to quit): ";
+                        std::string input;
+                        std::getline(std::cin, input);
+                        if (input == "q") break;
+                        // keep every digit of the input so that x is exact
+                        size_t dot = input.find('.');
+                        uint64_t dec_digit_len = dot == std::string::npos ? 1 : std::max<size_t>(input.size() - dot - 1, 1);
+                        FixedFloat x(10, 20, dec_digit_len, input);
+                        std::string result = e.evalAdaptive(x, digits).value.toString();
+                        std::cout << "The result is: " << result << std::endl;
+                    }
+                } catch (std::runtime_error &e) {
+                    std::cout << "Invalid: " << e.what() << std::endl;
+                    continue; // continue to input
+                }
+                break;
+            }
         }
 
         
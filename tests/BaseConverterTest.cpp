@@ -0,0 +1,120 @@
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+#include "FixedFloat.hpp"
+#include "BaseConverter.hpp"
+#include "Check.hpp"
+
+typedef std::vector<uint32_t> Limbs;
+
+static Limbs random_limbs(std::mt19937_64& rng, size_t n, uint64_t limb_base) {
+    Limbs a(n);
+    for (uint32_t &l : a) l = (uint32_t) (rng() % limb_base);
+    if (n) a.back() = (uint32_t) (1 + rng() % (limb_base - 1));
+    return a;
+}
+
+TEST(powers_and_small_values) {
+    CHECK(BaseConverter::power(10, 30, 1000000000) == Limbs({0, 0, 0, 1000}));
+    CHECK(BaseConverter::power(2, 40, (uint64_t) 1 << 32) == Limbs({0, 256}));
+    CHECK(BaseConverter::power(7, 0, 1000) == Limbs({1}));
+    // 10^9 + 5 in base 2^32
+    const Limbs x = {5, 1};
+    CHECK(BaseConverter::convert(x.data(), x.size(), 1000000000, (uint64_t) 1 << 32) == Limbs({1000000005}));
+}
+
+TEST(conversions_round_trip_across_sizes) {
+    // around and well beyond BASECASE_THRESHOLD, so both the long division and the split by powers run
+    std::mt19937_64 rng(9);
+    const uint64_t bases[] = {1000000000, (uint64_t) 1 << 32, 2176782336}; // 10^9, 2^32, 36^6
+    for (uint64_t from : bases) {
+        for (uint64_t to : bases) {
+            if (from == to) continue;
+            for (size_t n : {1, 2, 31, 32, 33, 64, 100, 257, 600}) {
+                const Limbs a = random_limbs(rng, n, from);
+                const Limbs b = BaseConverter::convert(a.data(), a.size(), from, to);
+                CHECK(BaseConverter::convert(b.data(), b.size(), to, from) == a);
+                // asking for fewer limbs gives the low limbs of the full result
+                const size_t need = b.size() / 2 + 1;
+                Limbs low(b.begin(), b.begin() + need);
+                while (!low.empty() && !low.back()) low.pop_back();
+                CHECK(BaseConverter::convert(a.data(), a.size(), from, to, need) == low);
+            }
+        }
+    }
+}
+
+TEST(long_numbers_convert_between_formats) {
+    std::mt19937_64 rng(10);
+    std::string digits(3000, '0');
+    for (char &c : digits) c = (char) ('0' + rng() % 10);
+    digits[0] = '7';
+    const FixedFloat x(10, 3000, 0, digits);
+    const FixedFloat y = x.baseTo(16).baseTo(36).baseTo(10);
+    CHECK_EQ(y.toString(), digits + ".0");
+    // fractions keep every digit the target format can hold, 0.1 is 0.000110011... in binary
+    const FixedFloat tenth(10, 1, 1000, "0.1");
+    const std::string bits = tenth.convertTo(2, 1, 20).toString();
+    CHECK_EQ(bits, std::string("0.00011001100110011001"));
+}
+
+TEST(common_roots) {
+    CHECK_EQ(BaseConverter::commonRoot(2, 16), (uint64_t) 2);
+    CHECK_EQ(BaseConverter::commonRoot(8, 32), (uint64_t) 2);
+    CHECK_EQ(BaseConverter::commonRoot(27, 9), (uint64_t) 3);
+    CHECK_EQ(BaseConverter::commonRoot(36, 6), (uint64_t) 6);
+    CHECK_EQ(BaseConverter::commonRoot(10, 100), (uint64_t) 10);
+    CHECK_EQ(BaseConverter::commonRoot(10, 16), (uint64_t) 0);
+    CHECK_EQ(BaseConverter::commonRoot(12, 18), (uint64_t) 0);
+    CHECK_EQ(BaseConverter::commonRoot(16, 16), (uint64_t) 0);
+    CHECK_EQ(BaseConverter::commonRoot(1, 16), (uint64_t) 0);
+}
+
+TEST(regroup_bits) {
+    // 0xabcd in 4 bit limbs is 0xcd, 0xab in 8 bit limbs
+    const Limbs x = {0xd, 0xc, 0xb, 0xa};
+    Limbs out(2);
+    BaseConverter::regroupBits(x.data(), x.size(), 4, 0, out.data(), out.size(), 8);
+    CHECK(out == Limbs({0xcd, 0xab}));
+    // a positive shift drops low bits, the bits above x read as 0
+    Limbs shifted(3);
+    BaseConverter::regroupBits(x.data(), x.size(), 4, 2, shifted.data(), shifted.size(), 5);
+    CHECK(shifted == Limbs({0xabcd >> 2 & 31, 0xabcd >> 7 & 31, 0xabcd >> 12 & 31}));
+    // a negative shift inserts zero bits below x
+    Limbs raised(3);
+    BaseConverter::regroupBits(x.data(), x.size(), 4, -3, raised.data(), raised.size(), 8);
+    CHECK(raised == Limbs({0xabcd << 3 & 255, 0xabcd >> 5 & 255, 0xabcd >> 13 & 255}));
+}
+
+TEST(regrouped_conversions_match_the_general_path) {
+    // a base that is a multiple of the root but not a power of it holds every value exactly and is converted by the
+    // general path, so going through it gives the reference result
+    struct Family { std::vector<uint16_t> bases; uint16_t exact; };
+    const Family families[] = {{{2, 4, 8, 16, 32}, 10}, {{3, 9, 27}, 6}, {{5, 25}, 10}, {{6, 36}, 12}};
+    const char *digits = "0123456789abcdefghijklmnopqrstuvwxyz";
+    std::mt19937_64 rng(11);
+    for (const Family &f : families) {
+        for (uint16_t from : f.bases) {
+            for (uint16_t to : f.bases) {
+                if (from == to) continue;
+                for (int round = 0; round < 10; round++) {
+                    const uint64_t int_len = 1 + rng() % 30, dec_len = rng() % 40;
+                    std::string s = rng() % 2 ? "-" : "";
+                    for (uint64_t i = 0; i < int_len; i++) s += digits[rng() % from];
+                    s += '.';
+                    for (uint64_t i = 0; i < dec_len; i++) s += digits[rng() % from];
+                    const FixedFloat x(from, int_len, dec_len, s);
+                    // the target is sometimes too narrow, which wraps the integer part and truncates the fraction
+                    const uint64_t to_int = 1 + rng() % 30, to_dec = rng() % 40;
+                    const FixedFloat exact = x.convertTo(f.exact, int_len * 6, dec_len * 6);
+                    CHECK_EQ(x.convertTo(to, to_int, to_dec).toString(), exact.convertTo(to, to_int, to_dec).toString());
+                }
+            }
+        }
+    }
+}
+
+int main() {
+    return Check::run();
+}
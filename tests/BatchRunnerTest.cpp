@@ -0,0 +1,77 @@
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "FixedFloat.hpp"
+#include "Expression.hpp"
+#include "BatchRunner.hpp"
+#include "ThreadPool.hpp"
+#include "Check.hpp"
+
+TEST(every_record_type) {
+    BatchRunner runner;
+    CHECK_EQ(runner.process("eval 10 10 10 x^2+1 2 0.5"), std::string("5.0 1.25"));
+    CHECK_EQ(runner.process("conv 10 5 5 255 16"), std::string("FF.0"));
+    CHECK_EQ(runner.process("adapt 10 5 10 1/x 3"), std::string("0.3333333333"));
+    // Newton stops within a unit of the last digit
+    CHECK_EQ(runner.process("root 10 5 20 x^2-2 1 2").rfind("1.4142135623730950488", 0), (size_t) 0);
+    CHECK_EQ(runner.process("eval 10 10 10 x+ 1").rfind("error:", 0), (size_t) 0);
+    CHECK_EQ(runner.process("solve 10 10 10 x 1"), std::string("error: unknown record type"));
+    CHECK_EQ(runner.process("eval 1 10 10 x 1"), std::string("error: invalid record"));
+}
+
+TEST(precision_is_capped) {
+    BatchRunner runner(ThreadPool::shared(), 100);
+    CHECK_EQ(runner.process("eval 10 50 50 x+1 2"), std::string("3.0"));
+    CHECK_EQ(runner.process("eval 10 50 51 x+1 2"), std::string("error: precision too large"));
+    CHECK_EQ(runner.process("adapt 10 20 81 1/x 3"), std::string("error: precision too large"));
+    CHECK_EQ(runner.process("adapt 10 20 10 1/x 0." + std::string(81, '3')), std::string("error: precision too large"));
+    // an answer that is never settled stops at the cap instead of escalating to millions of digits
+    CHECK_EQ(runner.process("adapt 10 20 10 x^(1/3*3) 2"), std::string("error: precision limit reached"));
+    CHECK_EQ(runner.process("adapt 10 20 60 1/x 3"), "0." + std::string(60, '3'));
+    // the default cap rejects the largest formats before anything is allocated
+    CHECK_EQ(BatchRunner().process("conv 10 1000000000 1000000000 1 16"), std::string("error: precision too large"));
+}
+
+TEST(run_keeps_the_input_order) {
+    BatchRunner runner;
+    std::string input = "# comment\n\n";
+    std::string expected;
+    for (int i = 0; i < 1000; i++) {
+        input += "eval 10 10 5 x*3 " + std::to_string(i) + "\n";
+        expected += std::to_string(3 * i) + ".0\n";
+    }
+    std::istringstream in(input);
+    std::ostringstream out;
+    CHECK_EQ(runner.run(in, out), (size_t) 1000);
+    CHECK_EQ(out.str(), expected);
+}
+
+TEST(batches_nested_in_pool_tasks_match_eval) {
+    // every line has enough points for evalBatch, which then runs inside a task of the same pool,
+    // and there are enough chunks for several of those tasks to run at once
+    ThreadPool pool(3);
+    BatchRunner runner(pool);
+    const Expression e("(x^3-2)/(x+7)");
+    std::string input, expected;
+    for (size_t line = 0; line < 4 * BatchRunner::CHUNK_LINES; line++) {
+        input += "eval 10 10 30 (x^3-2)/(x+7)";
+        std::string results;
+        for (size_t i = 0; i < BatchRunner::BATCH_MIN_POINTS + 16; i++) {
+            const std::string x = std::to_string(line) + "." + std::to_string(1000 + 13 * i);
+            input += " " + x;
+            if (i) results += ' ';
+            results += e.eval(FixedFloat(10, 10, 30, x)).toString();
+        }
+        input += "\n";
+        expected += results + "\n";
+    }
+    std::istringstream in(input);
+    std::ostringstream out;
+    runner.run(in, out);
+    CHECK(out.str() == expected);
+}
+
+int main() {
+    return Check::run();
+}
@@ -0,0 +1,89 @@
+#ifndef __CHECK_HPP__
+#define __CHECK_HPP__
+
+#include <cstdio>
+#include <exception>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// 测试用的最小框架：TEST 定义并注册一个用例，CHECK 系列失败时打印位置后继续执行，
+// 每个测试程序的 main 调用 Check::run()，有用例失败时返回非 0
+namespace Check {
+    struct Case {
+        const char *name;
+        void (*fn)();
+    };
+    inline std::vector<Case>& cases() {
+        static std::vector<Case> list;
+        return list;
+    }
+    inline int failures = 0;
+    struct Register {
+        Register(const char *name, void (*fn)()) { cases().push_back({name, fn}); }
+    };
+
+    // 能输出到流的值在失败时一并打印
+    template <typename T>
+    std::string show(const T& v) {
+        if constexpr (requires (std::ostream& o) { o << v; }) {
+            std::ostringstream out;
+            out << v;
+            return out.str();
+        } else {
+            return "?";
+        }
+    }
+    inline void fail(const char *file, int line, const std::string& what) {
+        failures++;
+        std::cerr << file << ":" << line << ": check failed: " << what << std::endl;
+    }
+    inline int run() {
+        int failed = 0;
+        for (const Case &c : cases()) {
+            const int before = failures;
+            try {
+                c.fn();
+            } catch (std::exception &e) {
+                fail(c.name, 0, std::string("unexpected exception: ") + e.what());
+            }
+            const bool ok = failures == before;
+            failed += !ok;
+            std::cout << (ok ? "[ ok ] " : "[FAIL] ") << c.name << std::endl;
+        }
+        std::cout << cases().size() - failed << "/" << cases().size() << " passed" << std::endl;
+        return failed ? 1 : 0;
+    }
+}
+
+#define TEST(name) \
+    static void test_##name(); \
+    static Check::Register register_##name(#name, test_##name); \
+    static void test_##name()
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) Check::fail(__FILE__, __LINE__, #cond); \
+    } while (0)
+
+#define CHECK_EQ(a, b) \
+    do { \
+        const auto &check_a = (a); \
+        const auto &check_b = (b); \
+        if (!(check_a == check_b)) \
+            Check::fail(__FILE__, __LINE__, std::string(#a " == " #b ", got ") + Check::show(check_a) + " and " + Check::show(check_b)); \
+    } while (0)
+
+#define CHECK_THROWS(expr) \
+    do { \
+        bool check_thrown = false; \
+        try { \
+            (void) (expr); \
+        } catch (std::exception&) { \
+            check_thrown = true; \
+        } \
+        if (!check_thrown) Check::fail(__FILE__, __LINE__, "expected an exception from " #expr); \
+    } while (0)
+
+#endif
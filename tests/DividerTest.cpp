@@ -0,0 +1,52 @@
+#include <cstdint>
+#include <random>
+#include <string>
+#include "FixedFloat.hpp"
+#include "Check.hpp"
+
+TEST(quotients_are_truncated) {
+    CHECK_EQ((FixedFloat(10, 5, 10, "1") / FixedFloat(10, 5, 10, "3")).toString(), std::string("0.3333333333"));
+    CHECK_EQ((FixedFloat(10, 5, 10, "-2") / FixedFloat(10, 5, 10, "3")).toString(), std::string("-0.6666666666"));
+    CHECK_EQ((FixedFloat(16, 5, 8, "1") / FixedFloat(16, 5, 8, "3")).toString(), std::string("0.55555555"));
+    CHECK_THROWS(FixedFloat(10, 5, 5, "1") / FixedFloat(10, 5, 5, "0"));
+}
+
+TEST(quotient_times_divisor_is_within_one_unit) {
+    std::mt19937_64 rng(4);
+    for (uint64_t dec : {20, 300, 3000}) {
+        for (int round = 0; round < 5; round++) {
+            std::string a = std::to_string(rng() % 1000) + ".", b = std::to_string(1 + rng() % 1000) + ".";
+            for (uint64_t i = 0; i < dec; i++) {
+                a += (char) ('0' + rng() % 10);
+                b += (char) ('0' + rng() % 10);
+            }
+            const FixedFloat x(10, 10, dec, a), y(10, 10, dec, b);
+            const FixedFloat q = x / y;
+            // q is x / y truncated, so x - q * y is non-negative and below a few units of the last digit times y
+            const FixedFloat rest = x - q * y;
+            CHECK(!(rest < FixedFloat(10, 10, dec)));
+            CHECK(rest < y * FixedFloat(10, 10, dec, "0." + std::string(dec - 3, '0') + "1"));
+        }
+    }
+}
+
+TEST(inverse_matches_division) {
+    const FixedFloat x(10, 5, 20, "7");
+    CHECK_EQ(x.inverse().toString(), (FixedFloat(10, 5, 20, "1") / x).toString());
+    CHECK_EQ(FixedFloat(10, 5, 20, "-0.125").inverse().toString(), std::string("-8.0"));
+    CHECK_THROWS(FixedFloat(10, 5, 5).inverse());
+}
+
+TEST(inverse_without_integer_digits) {
+    // 1 / 0.4 = 2.5, the integer part overflows a format without integer digits exactly like a quotient does
+    CHECK_EQ(FixedFloat(10, 0, 5, "0.4").inverse().toString(), std::string("0.5"));
+    CHECK_EQ(FixedFloat(10, 0, 5, "-0.4").inverse().toString(), std::string("-0.5"));
+    const FixedFloat wide = FixedFloat(10, 1, 12, "1") / FixedFloat(10, 1, 12, "0.7");
+    CHECK_EQ(FixedFloat(10, 0, 12, "0.7").inverse().toString(), wide.convertTo(10, 0, 12).toString());
+    // 1 / 0.11 in binary is 1.0101..., whose fractional part remains
+    CHECK_EQ(FixedFloat(2, 0, 40, "0.11").inverse().toString(), std::string("0.0101010101010101010101010101010101010101"));
+}
+
+int main() {
+    return Check::run();
+}
@@ -0,0 +1,240 @@
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+#include "FixedFloat.hpp"
+#include "Expression.hpp"
+#include "Polynomial.hpp"
+#include "Profiler.hpp"
+#include "LimbAllocator.hpp"
+#include "Check.hpp"
+
+// every operator new in this program is counted, so a test can check that a loop stays off the heap
+static std::atomic<uint64_t> news{0};
+void *operator new(size_t n) {
+    news++;
+    if (void *p = malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+static std::string eval(const std::string& src, const std::string& x, uint16_t base = 10, uint64_t int_len = 20, uint64_t dec_len = 30) {
+    return Expression(src).eval(FixedFloat(base, int_len, dec_len, x)).toString();
+}
+
+TEST(operators_and_precedence) {
+    CHECK_EQ(eval("1+2*3", "0"), std::string("7.0"));
+    CHECK_EQ(eval("(1+2)*3", "0"), std::string("9.0"));
+    CHECK_EQ(eval("2^3^2", "0"), std::string("64.0")); // ^ groups to the left
+    CHECK_EQ(eval("10-4-3", "0"), std::string("3.0"));
+    CHECK_EQ(eval("1/8", "0"), std::string("0.125"));
+    CHECK_EQ(eval("-x+3", "1.5"), std::string("1.5"));
+    CHECK_EQ(eval("2x(x+1)", "3"), std::string("24.0")); // implicit multiplication
+    CHECK_EQ(eval("x^(-2)", "2"), std::string("0.25"));
+    CHECK_EQ(eval("1/(x-1)", "3"), std::string("0.5"));
+    CHECK_EQ(eval("0.5x", "0.5"), std::string("0.25"));
+}
+
+TEST(literals_follow_the_base_of_x) {
+    // literals are decimal, x and the result are in the base of x
+    CHECK_EQ(eval("x+10", "f", 16), std::string("19.0"));
+    CHECK_EQ(eval("x/2", "1", 2, 10, 10), std::string("0.1"));
+}
+
+TEST(context_is_reused_across_formats) {
+    const Expression e("(x+1)/(x-2)");
+    Expression::Context ctx;
+    for (int round = 0; round < 3; round++) {
+        CHECK_EQ(e.eval(FixedFloat(10, 10, 10, "4"), ctx).toString(), std::string("2.5"));
+        CHECK_EQ(e.eval(FixedFloat(16, 10, 10, "4"), ctx).toString(), std::string("2.8"));
+        CHECK_EQ(e.eval(FixedFloat(10, 10, 3, "3"), ctx).toString(), std::string("4.0"));
+    }
+}
+
+TEST(invalid_expressions_throw) {
+    CHECK_THROWS(Expression("1+"));
+    CHECK_THROWS(Expression("*2"));
+    CHECK_THROWS(Expression("x/0").eval(FixedFloat(10, 5, 5, "1")));
+}
+
+TEST(constants_fold_and_subexpressions_are_shared) {
+    // the counts exclude the folded constants, x itself is one instruction
+    CHECK_EQ(Expression("x").instructionCount(), (size_t) 1);
+    CHECK_EQ(Expression("2*3+x").instructionCount(), (size_t) 2);
+    CHECK_EQ(Expression("(1+2)^2*x").instructionCount(), (size_t) 2);
+    CHECK_EQ(Expression("x*x+x*x").instructionCount(), (size_t) 3);
+    CHECK_EQ(Expression("(x+1)*(x+1)").instructionCount(), (size_t) 3);
+    CHECK_EQ(Expression("x*2+2*x").instructionCount(), (size_t) 3); // operands of * commute
+    // x^8 is three squarings, x^4 is one of them
+    CHECK_EQ(Expression("x^8").instructionCount(), (size_t) 4);
+    CHECK_EQ(Expression("x^8+x^4").instructionCount(), (size_t) 5);
+    // sharing does not change the values
+    CHECK_EQ(eval("x*x+x*x", "1.5"), std::string("4.5"));
+    CHECK_EQ(eval("x^8+x^4", "1.5"), std::string("30.69140625"));
+    CHECK_EQ(eval("(1+2)^2*x", "0.5"), std::string("4.5"));
+}
+
+TEST(adaptive_results_are_rounded_and_certified) {
+    const auto adapt = [] (const std::string& src, const std::string& x, uint64_t digits) {
+        return Expression(src).evalAdaptive(FixedFloat(10, 20, 5, x), digits).value.toString();
+    };
+    CHECK_EQ(adapt("1/x", "3", 30), "0." + std::string(30, '3'));
+    CHECK_EQ(adapt("2/x", "3", 4), std::string("0.6667")); // rounded to nearest, not truncated
+    CHECK_EQ(adapt("x^(-2)", "3", 6), std::string("0.111111"));
+    // literal exponents are exact enough to truncate, 2.5 is taken as 2
+    CHECK_EQ(adapt("x^2.5", "2", 5), std::string("4.0"));
+    // 1/3*3 is one ulp below 1 at every precision, so its truncation can not be certified
+    CHECK_THROWS(adapt("x^(1/3*3)", "2", 10));
+    // the escalation never goes past the cap on the total digits
+    const Expression e("x^(1/3*3)");
+    std::string what;
+    try {
+        e.evalAdaptive(FixedFloat(10, 20, 5, "2"), 10, 200);
+    } catch (std::exception &ex) {
+        what = ex.what();
+    }
+    CHECK_EQ(what, std::string("precision limit reached"));
+    CHECK_EQ(Expression("1/x").evalAdaptive(FixedFloat(10, 20, 5, "3"), 10, 200).value.toString(), "0." + std::string(10, '3'));
+    CHECK(Expression("1/x").evalAdaptive(FixedFloat(10, 20, 5, "3"), 10, 200).precision <= 180);
+    CHECK_THROWS(Expression("1/x").evalAdaptive(FixedFloat(10, 20, 5, "3"), 181, 200));
+}
+
+TEST(adaptive_overflow_is_exact) {
+    const auto adapt = [] (const std::string& src, const std::string& x, uint64_t digits) {
+        return Expression(src).evalAdaptive(FixedFloat(10, 20, 20, x), digits).value.toString();
+    };
+    // 1e20 needs 21 integer digits, a double estimate of it lands just below the limit
+    CHECK_THROWS(adapt("1/(x-2)", "2.00000000000000000001", 30));
+    // at 10 digits x - 2 is 0 until the precision is raised, which is not a division by zero
+    std::string what;
+    try {
+        adapt("1/(x-2)", "2.00000000000000000001", 10);
+    } catch (std::exception &e) {
+        what = e.what();
+    }
+    CHECK_EQ(what, std::string("overflow"));
+    CHECK_EQ(adapt("1/(x-2)", "2.0000000000000000001", 10), std::string("10000000000000000000.0"));
+    // results that use every integer digit are certified, one more is an overflow
+    CHECK_EQ(adapt("x+1", "99999999999999999998", 3), std::string("99999999999999999999.0"));
+    CHECK_THROWS(adapt("x+2", "99999999999999999998", 3));
+    CHECK_EQ(adapt("x^2", "9999999999.99", 3), std::string("99999999999800000000.0"));
+    CHECK_THROWS(adapt("x*x", "10000000000", 3));
+    // the estimate works on logarithms, so magnitudes beyond the range of a double are judged as well
+    CHECK_THROWS(Expression("x^3").evalAdaptive(FixedFloat(10, 700, 5, "1" + std::string(300, '0')), 3));
+}
+
+// |a - b| < base^-digits
+static bool close(const FixedFloat& a, const std::string& b, uint64_t digits) {
+    const FixedFloat diff = a - FixedFloat(a.getBase(), a.getIntDigitLen(), a.getDecDigitLen(), b);
+    const FixedFloat unit(a.getBase(), a.getIntDigitLen(), a.getDecDigitLen(), "0." + std::string(digits - 1, '0') + "1");
+    return diff < unit && -unit < diff;
+}
+
+// how many times eval took the Horner path
+static uint64_t horner_count(const Expression& e, const FixedFloat& x) {
+    Profiler::Profile profile("horner");
+    Profiler::Scope scope(&profile);
+    e.eval(x);
+    return profile.stats(Profiler::Op::HORNER).count;
+}
+
+TEST(expansion_stays_within_the_format) {
+    // the binomial coefficients of (x+1)^1000 reach 2.7e299, far beyond 20 integer digits
+    const Expression e("(x+1)^1000");
+    Polynomial p;
+    CHECK(!e.toPolynomial(FixedFloat(10, 20, 30), p));
+    CHECK(e.toPolynomial(FixedFloat(10, 310, 30), p));
+    // 1.001^1000 = 2.71692393223589245738308812194757...
+    CHECK(close(e.eval(FixedFloat(10, 20, 30, "0.001")), "2.716923932235892457383088121947", 25));
+    CHECK(close(e.eval(FixedFloat(10, 310, 30, "0.001")), "2.716923932235892457383088121947", 25));
+    // 1.0001^4000 = 1.49179486343459109189106725332998...
+    const Expression f("(x+1)^4000");
+    CHECK(close(f.eval(FixedFloat(10, 20, 30, "0.0001")), "1.491794863434591091891067253329", 25));
+}
+
+TEST(cancelling_expansions_use_the_bytecode) {
+    // expanded, (x-1)^100 sums terms up to C(100, 50) 1.5^50 to get 0.5^100 = 7.8886090522101180541e-31
+    const Expression e("(x-1)^100");
+    const std::string expected = "0.0000000000000000000000000000007888609052";
+    for (uint64_t int_len : {20, 60}) {
+        const FixedFloat x(10, int_len, 40, "1.5");
+        CHECK_EQ(e.eval(x).toString(), expected);
+        CHECK_EQ(horner_count(e, x), (uint64_t) 0);
+    }
+    // a polynomial without cancellation keeps Horner
+    const Expression g("x^5-2*x^3+x");
+    CHECK_EQ(horner_count(g, FixedFloat(10, 20, 30, "3.7")), (uint64_t) 1);
+    CHECK_EQ(g.eval(FixedFloat(10, 20, 30, "3.7")).toString(), std::string("595.83357"));
+    // the batch takes the same path as eval for every point
+    const std::vector<FixedFloat> xs(100, FixedFloat(10, 60, 40, "1.5"));
+    for (const FixedFloat &r : e.evalBatch(xs)) CHECK_EQ(r.toString(), expected);
+}
+
+TEST(warm_horner_evaluations_do_not_allocate) {
+    // the choice between Horner and the bytecode reuses the scratch vectors of the context
+    const Expression e("3/7x^2-1/3x+2");
+    const FixedFloat x(10, 20, 30, "1.25");
+    Expression::Context ctx;
+    LimbAllocator::Scope scope(LimbAllocator::Strategy::POOL);
+    const std::string expected = e.eval(x, ctx).toString();
+    const uint64_t before = news.load();
+    for (int i = 0; i < 100; i++) (void) e.eval(x, ctx);
+    CHECK_EQ(news.load() - before, (uint64_t) 0);
+    CHECK_EQ(e.eval(x, ctx).toString(), expected);
+    CHECK_EQ(horner_count(e, x), (uint64_t) 1);
+}
+
+TEST(long_batches_of_long_polynomials_use_the_remainder_tree) {
+    using E = Expression;
+    CHECK(E::useMultipoint(E::MULTIPOINT_MIN_DEGREE, E::MULTIPOINT_MIN_DEGREE + 1, E::MULTIPOINT_MIN_DIGITS, 1, 10));
+    CHECK(!E::useMultipoint(E::MULTIPOINT_MIN_DEGREE - 1, 1000, 100000, 1, 10));
+    CHECK(!E::useMultipoint(256, 256, 100000, 1, 10));
+    CHECK(!E::useMultipoint(256, 1000, E::MULTIPOINT_MIN_DIGITS - 1, 1, 10));
+    // a degree 512 tree needs fewer guard digits than 4000 for points in [-1, 1], but more for points far from the origin
+    CHECK(E::useMultipoint(512, 513, 4000, 1, 10));
+    CHECK(!E::useMultipoint(512, 513, 4000, 1e6, 10));
+    // one block at the smallest degree and precision that take the tree, checked against eval on a few points
+    std::string src = "1";
+    for (size_t k = 1; k <= E::MULTIPOINT_MIN_DEGREE; k++) src += (k % 3 ? "+" : "-") + std::to_string(k % 7 + 1) + "/" + std::to_string(k + 2) + "x^" + std::to_string(k);
+    const Expression e(src);
+    const uint64_t dec_len = E::MULTIPOINT_MIN_DIGITS;
+    std::vector<FixedFloat> xs;
+    for (size_t i = 0; i <= E::MULTIPOINT_MIN_DEGREE; i++) xs.push_back(FixedFloat(10, 10, dec_len, (i % 2 ? "-0." : "0.") + std::to_string(1000 + 7 * i)));
+    Profiler::Profile profile("tree");
+    std::vector<FixedFloat> got;
+    {
+        Profiler::Scope scope(&profile);
+        got = e.evalBatch(xs);
+    }
+    CHECK_EQ(profile.stats(Profiler::Op::MULTIPOINT).count, (uint64_t) xs.size());
+    const FixedFloat ulp(10, 10, dec_len, "0." + std::string(dec_len - 1, '0') + "1");
+    for (size_t i : {0, 1, 64, 128}) {
+        const FixedFloat ref = e.eval(xs[i]);
+        CHECK(!((got[i] > ref ? got[i] - ref : ref - got[i]) > ulp + ulp));
+    }
+}
+
+TEST(batches_from_pool_tasks_match_eval) {
+    // every task runs a whole evalBatch on the pool it is itself running on
+    ThreadPool pool(3);
+    for (const char *src : {"(x^2+1)/(x-3)", "3/7*x^5-x^2/3+1"}) {
+        const Expression e(src);
+        std::vector<FixedFloat> xs;
+        for (int i = 0; i < 300; i++) xs.push_back(FixedFloat(10, 10, 40, "0." + std::to_string(1000 + 7 * i)));
+        std::vector<std::string> expected;
+        for (const FixedFloat &x : xs) expected.push_back(e.eval(x).toString());
+        std::atomic<int> mismatches{0};
+        pool.parallelFor(8, 1, [&] (size_t, size_t, size_t) {
+            const std::vector<FixedFloat> got = e.evalBatch(xs, pool);
+            for (size_t i = 0; i < xs.size(); i++) mismatches += got[i].toString() != expected[i];
+        });
+        CHECK_EQ(mismatches.load(), 0);
+    }
+}
+
+int main() {
+    return Check::run();
+}
@@ -0,0 +1,102 @@
+#include <cstdint>
+#include <random>
+#include <string>
+#include "FixedFloat.hpp"
+#include "FixedFloatBatch.hpp"
+#include "Check.hpp"
+
+static const size_t LANES = FixedFloatBatch::LANES;
+
+// every lane of a + b, a - b and a * b equals the FixedFloat result, including the wrapped integer part
+static void check_format(uint16_t base, uint64_t int_len, uint64_t dec_len, uint32_t seed) {
+    std::mt19937 rng(seed);
+    const char *digits = "0123456789abcdefghijklmnopqrstuvwxyz";
+    const auto random = [&] (size_t lane) {
+        // lane 0 is zero, lane 1 is the largest number of the format
+        std::string s = rng() % 2 ? "-" : "";
+        for (uint64_t i = 0; i < int_len; i++) s += lane == 0 ? '0' : lane == 1 ? digits[base - 1] : digits[rng() % base];
+        s += '.';
+        for (uint64_t i = 0; i < dec_len; i++) s += lane == 0 ? '0' : lane == 1 ? digits[base - 1] : digits[rng() % base];
+        return FixedFloat(base, int_len, dec_len, s);
+    };
+    const FixedFloat like(base, int_len, dec_len);
+    for (int round = 0; round < 20; round++) {
+        std::vector<FixedFloat> a, b;
+        FixedFloatBatch ba(like), bb(like);
+        for (size_t lane = 0; lane < LANES; lane++) {
+            a.push_back(random(lane));
+            b.push_back(random(LANES - 1 - lane));
+            ba.set(lane, a[lane]);
+            bb.set(lane, b[lane]);
+        }
+        FixedFloatBatch sum = ba, diff = ba, prod = ba;
+        sum += bb;
+        diff -= bb;
+        prod *= bb;
+        for (size_t lane = 0; lane < LANES; lane++) {
+            CHECK(ba.get(lane) == a[lane]);
+            CHECK_EQ(sum.get(lane).toString(), (a[lane] + b[lane]).toString());
+            CHECK_EQ(diff.get(lane).toString(), (a[lane] - b[lane]).toString());
+            CHECK_EQ(prod.get(lane).toString(), (a[lane] * b[lane]).toString());
+        }
+    }
+}
+
+TEST(lanes_match_scalar_operations) {
+    check_format(10, 20, 30, 1);
+    check_format(10, 3, 7, 2);   // digit counts that do not fill a limb
+    check_format(16, 10, 40, 3);
+    check_format(2, 40, 60, 4);
+    check_format(7, 5, 9, 5);
+    check_format(36, 12, 12, 6);
+}
+
+TEST(broadcast_fills_every_lane) {
+    const FixedFloat f(10, 10, 10, "-3.25");
+    const FixedFloatBatch b = FixedFloatBatch::broadcast(f);
+    for (size_t lane = 0; lane < LANES; lane++) CHECK(b.get(lane) == f);
+    FixedFloatBatch sq = b;
+    sq *= b;
+    for (size_t lane = 0; lane < LANES; lane++) CHECK_EQ(sq.get(lane).toString(), std::string("10.5625"));
+}
+
+TEST(negative_zero_is_zero) {
+    // x - x is +0 in every lane, like FixedFloat
+    const FixedFloatBatch b = FixedFloatBatch::broadcast(FixedFloat(10, 5, 5, "-1.5"));
+    FixedFloatBatch d = b;
+    d -= b;
+    for (size_t lane = 0; lane < LANES; lane++) {
+        CHECK(d.get(lane).isZero());
+        CHECK_EQ(d.get(lane).toString(), FixedFloat(10, 5, 5).toString());
+    }
+}
+
+TEST(effective_digits_span_the_nonzero_digits) {
+    FixedFloatBatch b(FixedFloat(10, 20, 30));
+    b.set(1, FixedFloat(10, 20, 30, "0.5"));
+    b.set(2, FixedFloat(10, 20, 30, "-12.125"));
+    b.set(3, FixedFloat(10, 20, 30, "1000"));
+    b.set(4, FixedFloat(10, 20, 30, "1234567890.000000000000000000001"));
+    b.set(5, FixedFloat(10, 20, 30, "100.001"));
+    CHECK_EQ(b.effectiveDigits(0), (uint64_t) 0);
+    CHECK_EQ(b.effectiveDigits(1), (uint64_t) 1);
+    CHECK_EQ(b.effectiveDigits(2), (uint64_t) 5);
+    CHECK_EQ(b.effectiveDigits(3), (uint64_t) 1);
+    CHECK_EQ(b.effectiveDigits(4), (uint64_t) 31);
+    CHECK_EQ(b.effectiveDigits(5), (uint64_t) 6);
+    FixedFloatBatch h(FixedFloat(16, 8, 8));
+    h.set(0, FixedFloat(16, 8, 8, "f0.08"));
+    CHECK_EQ(h.effectiveDigits(0), (uint64_t) 4);
+}
+
+TEST(formats_must_match) {
+    FixedFloatBatch a(FixedFloat(10, 10, 10));
+    const FixedFloatBatch b(FixedFloat(10, 10, 11));
+    CHECK_THROWS(a += b);
+    CHECK_THROWS(a *= b);
+    CHECK_THROWS(a.set(0, FixedFloat(16, 10, 10)));
+}
+
+int main() {
+    return Check::run();
+}
@@ -0,0 +1,244 @@
+#include <cstdint>
+#include <random>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include "FixedFloat.hpp"
+#include "Check.hpp"
+
+// the text FixedFloat::toString gives for v / 10^dec
+static std::string decimal(__int128 v, int dec) {
+    const bool neg = v < 0;
+    unsigned __int128 u = neg ? -(unsigned __int128) v : (unsigned __int128) v;
+    std::string digits;
+    for (; u; u /= 10) digits.insert(digits.begin(), (char) ('0' + (int) (u % 10)));
+    if ((int) digits.size() <= dec) digits.insert(0, dec + 1 - digits.size(), '0');
+    std::string int_part = digits.substr(0, digits.size() - dec), dec_part = digits.substr(digits.size() - dec);
+    while (!dec_part.empty() && dec_part.back() == '0') dec_part.pop_back();
+    if (dec_part.empty()) dec_part = "0";
+    if (int_part == "0" && dec_part == "0") return "0.0";
+    return (neg ? "-" : "") + int_part + "." + dec_part;
+}
+
+static __int128 random_scaled(std::mt19937_64& rng, int digits) {
+    __int128 v = 0;
+    for (int i = 0; i < digits; i++) v = v * 10 + (int) (rng() % 10);
+    return rng() % 2 ? -v : v;
+}
+
+TEST(parse_and_format) {
+    CHECK_EQ(FixedFloat(10, 5, 5, "1.5").toString(), std::string("1.5"));
+    CHECK_EQ(FixedFloat(10, 5, 5, "-0.25").toString(), std::string("-0.25"));
+    CHECK_EQ(FixedFloat(10, 5, 5, "0").toString(), std::string("0.0"));
+    CHECK_EQ(FixedFloat(10, 5, 5, "-0.0").toString(), std::string("0.0"));
+    // the integer digits above the format and the decimal digits below it are cut off
+    CHECK_EQ(FixedFloat(10, 3, 2, "12345.678").toString(), std::string("345.67"));
+    CHECK_EQ(FixedFloat(16, 5, 5, "ff.8").toString(), std::string("FF.8"));
+    CHECK_EQ(FixedFloat(36, 4, 4, "zz.z").toString(), std::string("ZZ.Z"));
+    CHECK_EQ(FixedFloat(2, 8, 8, "101.011").toString(), std::string("101.011"));
+}
+
+TEST(round_trip_every_base) {
+    std::mt19937_64 rng(1);
+    const char *chars = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    for (uint16_t base = 2; base <= 36; base++) {
+        for (uint64_t int_len : {1, 7, 30}) {
+            for (uint64_t dec_len : {1, 9, 31, 100}) {
+                std::string s(1, chars[1 + rng() % (base - 1)]);
+                for (uint64_t i = 1; i < int_len; i++) s += chars[rng() % base];
+                s += '.';
+                for (uint64_t i = 0; i < dec_len - 1; i++) s += chars[rng() % base];
+                s += chars[1 + rng() % (base - 1)];
+                CHECK_EQ(FixedFloat(base, int_len, dec_len, s).toString(), s);
+            }
+        }
+    }
+}
+
+TEST(add_sub_compare_match_integers) {
+    std::mt19937_64 rng(2);
+    for (int round = 0; round < 2000; round++) {
+        const int int_len = 1 + rng() % 17, dec_len = 1 + rng() % 18;
+        // one digit of headroom so that the sum never overflows the format
+        const __int128 a = random_scaled(rng, int_len - 1 + dec_len), b = random_scaled(rng, int_len - 1 + dec_len);
+        const FixedFloat x(10, int_len, dec_len, decimal(a, dec_len)), y(10, int_len, dec_len, decimal(b, dec_len));
+        CHECK_EQ((x + y).toString(), decimal(a + b, dec_len));
+        CHECK_EQ((x - y).toString(), decimal(a - b, dec_len));
+        CHECK_EQ(x < y, a < b);
+        CHECK_EQ(x > y, a > b);
+        CHECK_EQ(x == y, a == b);
+        FixedFloat z(x);
+        z -= x;
+        CHECK(z.isZero());
+        CHECK_EQ(z.toString(), std::string("0.0"));
+    }
+}
+
+TEST(carry_across_limbs) {
+    // 10^9 - 1 fills a whole decimal limb, adding one more unit carries into the next limb
+    const FixedFloat a(10, 20, 20, "999999999.99999999999999999999");
+    const FixedFloat unit(10, 20, 20, "0.00000000000000000001");
+    CHECK_EQ((a + unit).toString(), std::string("1000000000.0"));
+    CHECK_EQ((a + unit - unit).toString(), a.toString());
+    const FixedFloat h(16, 10, 10, "ffffffff.ffffffff");
+    CHECK_EQ((h + FixedFloat(16, 10, 10, "0.00000001")).toString(), std::string("100000000.0"));
+}
+
+TEST(double_value) {
+    CHECK_EQ(FixedFloat(10, 5, 10, "-12.375").doubleValue(), -12.375);
+    CHECK_EQ(FixedFloat(2, 10, 10, "101.1").doubleValue(), 5.5);
+    CHECK_EQ(FixedFloat(10, 5, 5, "123.9").intValue(), 123);
+}
+
+TEST(pow_matches_repeated_products) {
+    // integers and powers of 1/2 are exact, so every multiplication order gives the same digits
+    for (const char *x : {"3", "-7", "0.5", "-1.5"}) {
+        const FixedFloat a(10, 200, 400, x);
+        FixedFloat p(10, 200, 400, "1");
+        for (uint64_t n = 0; n <= 300; n++) {
+            if (n % 37 == 0 || n < 10 || n == 255 || n == 256 || n == 300) CHECK_EQ(a.pow(n).toString(), p.toString());
+            p *= a;
+        }
+    }
+    CHECK_EQ(FixedFloat(10, 5, 5, "0").pow(0).toString(), std::string("1.0"));
+    CHECK_EQ(FixedFloat(10, 5, 5, "-1").pow(1000001).toString(), std::string("-1.0"));
+    CHECK_EQ(FixedFloat(2, 70, 5, "10").pow(64).toString(), "1" + std::string(64, '0') + ".0");
+}
+
+TEST(sparse_values_track_their_nonzero_limbs) {
+    // small literals in a wide format only use the limbs around the point
+    const FixedFloat three(10, 2000, 2000, "3"), half(10, 2000, 2000, "0.5");
+    CHECK_EQ(three.footprint().used_limbs, (uint64_t) 1);
+    CHECK_EQ(half.footprint().used_limbs, (uint64_t) 1);
+    CHECK_EQ((three * half).footprint().used_limbs, (uint64_t) 2);
+    CHECK_EQ(FixedFloat(10, 2000, 2000).footprint().used_limbs, (uint64_t) 0);
+    FixedFloat z(three);
+    z -= three;
+    CHECK(z.isZero());
+    CHECK_EQ(z.footprint().used_limbs, (uint64_t) 0);
+    // adding a zero or a far away value leaves the limbs between them zero
+    FixedFloat w(three);
+    w += z;
+    CHECK_EQ(w.footprint().used_limbs, (uint64_t) 1);
+    w += FixedFloat(10, 2000, 2000, "1" + std::string(90, '0'));
+    CHECK_EQ(w.footprint().used_limbs, (uint64_t) 11);
+    // a carry out of the top limb and a borrow into a lower one extend the window
+    FixedFloat c(10, 2000, 2000, "999999999");
+    c += FixedFloat(10, 2000, 2000, "1");
+    CHECK_EQ(c.footprint().used_limbs, (uint64_t) 1);
+    CHECK_EQ(c.toString(), std::string("1000000000.0"));
+    c -= FixedFloat(10, 2000, 2000, "0.000000001");
+    CHECK_EQ(c.toString(), std::string("999999999.999999999"));
+    CHECK_EQ(c.footprint().used_limbs, (uint64_t) 2);
+}
+
+TEST(sparse_operations_match_narrow_formats) {
+    // values that fit both formats give the same digits whether the wide format keeps them sparse or not
+    std::mt19937_64 rng(3);
+    for (int round = 0; round < 500; round++) {
+        const __int128 a = random_scaled(rng, 1 + rng() % 12), b = random_scaled(rng, 1 + rng() % 12);
+        const int dec = 6;
+        const FixedFloat na(10, 20, 20, decimal(a, dec)), nb(10, 20, 20, decimal(b, dec));
+        const FixedFloat wa(10, 1000, 1000, decimal(a, dec)), wb(10, 1000, 1000, decimal(b, dec));
+        CHECK_EQ((wa + wb).toString(), (na + nb).toString());
+        CHECK_EQ((wa - wb).toString(), (na - nb).toString());
+        CHECK_EQ((wa * wb).toString(), (na * nb).toString());
+        CHECK_EQ(wa < wb, na < nb);
+        CHECK_EQ(wa == wb, na == nb);
+        FixedFloat f(wa);
+        f.fma(wb, wb);
+        FixedFloat g(na);
+        g.fma(nb, nb);
+        CHECK_EQ(f.toString(), g.toString());
+        CHECK_EQ((wa - wa).isZero(), true);
+    }
+}
+
+TEST(formats_beyond_sixteen_bit_lengths) {
+    // 100000 digits on each side of the point, where the old 16-bit lengths wrapped around
+    const uint64_t n = 100000;
+    std::mt19937_64 rng(4);
+    std::string s(1, '1');
+    for (uint64_t i = 1; i < n; i++) s += (char) ('0' + rng() % 10);
+    s += '.';
+    for (uint64_t i = 0; i < n - 1; i++) s += (char) ('0' + rng() % 10);
+    s += '7';
+    const FixedFloat x(10, n, n, s);
+    CHECK_EQ(x.getIntDigitLen(), n);
+    CHECK_EQ(x.toString(), s);
+    CHECK_EQ(x.footprint().limbs, 2 * ((n + 8) / 9)); // the integer and the fractional digits start new limbs
+    CHECK(x.footprint().bytes >= x.footprint().limbs * sizeof(uint32_t));
+    // x - x / 2 * 2 is zero or one ulp, the lowest digit of x is odd
+    const FixedFloat two(10, n, n, "2");
+    const FixedFloat rest = x - x / two * two;
+    CHECK_EQ(rest.toString(), "0." + std::string(n - 1, '0') + "1");
+    CHECK((x + x - x) == x);
+    // the low digits of a product of two small values are unaffected by the width
+    const FixedFloat a(10, n, n, "123456789.987654321");
+    CHECK_EQ((a * a).toString(), std::string("15241578994055784.200731595789971041"));
+}
+
+TEST(oversized_formats_throw) {
+    CHECK_THROWS(FixedFloat(10, FixedFloat::MAX_DIGIT_LEN, 1));
+    CHECK_THROWS(FixedFloat(10, 1, FixedFloat::MAX_DIGIT_LEN));
+    CHECK_THROWS(FixedFloat(10, UINT64_MAX, UINT64_MAX));
+}
+
+TEST(to_chars_writes_into_caller_buffers) {
+    std::mt19937_64 rng(5);
+    const char *chars = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    for (uint16_t base : {2, 10, 16, 36, 7}) {
+        // the largest negative value of the format is the longest text
+        const std::string longest = "-" + std::string(12, chars[base - 1]) + "." + std::string(25, chars[base - 1]);
+        const FixedFloat m(base, 12, 25, longest);
+        CHECK_EQ(m.toString(), longest);
+        CHECK(longest.size() <= m.maxChars());
+        for (int round = 0; round < 50; round++) {
+            std::string s = rng() % 2 ? "-" : "";
+            s += chars[1 + rng() % (base - 1)];
+            for (int i = 0; i < (int) (rng() % 12); i++) s += chars[rng() % base];
+            s += '.';
+            for (int i = 0; i < (int) (rng() % 25); i++) s += chars[rng() % base];
+            s += chars[1 + rng() % (base - 1)];
+            const FixedFloat x(base, 12, 25, s);
+            std::string buf(x.maxChars(), '#');
+            const std::to_chars_result r = x.toChars(buf.data(), buf.data() + buf.size());
+            CHECK(r.ec == std::errc());
+            CHECK_EQ(std::string(buf.data(), r.ptr), s);
+            // an exact fit succeeds, one char less fails without claiming to have written anything
+            CHECK(x.toChars(buf.data(), buf.data() + s.size()).ec == std::errc());
+            const std::to_chars_result small = x.toChars(buf.data(), buf.data() + s.size() - 1);
+            CHECK(small.ec == std::errc::value_too_large);
+            CHECK(small.ptr == buf.data() + s.size() - 1);
+        }
+    }
+    char one[2];
+    CHECK(FixedFloat(10, 5, 5).toChars(one, one + 2).ec == std::errc::value_too_large);
+    char three[3];
+    const std::to_chars_result zero = FixedFloat(10, 5, 5).toChars(three, three + 3);
+    CHECK(zero.ec == std::errc());
+    CHECK_EQ(std::string(three, zero.ptr), std::string("0.0"));
+}
+
+TEST(parsing_string_views) {
+    // the view ends before the rest of the buffer, which is not NUL terminated
+    const char text[] = {'1', '2', '.', '5', '9', '9'};
+    CHECK_EQ(FixedFloat(10, 5, 5, std::string_view(text, 4)).toString(), std::string("12.5"));
+    CHECK_EQ(FixedFloat(10, 5, 5, std::string_view(text + 1, 2)).toString(), std::string("2.0"));
+    CHECK_EQ(FixedFloat(10, 5, 5, std::string_view()).toString(), std::string("0.0"));
+    CHECK_EQ(FixedFloat(10, 5, 5, "   ").toString(), std::string("0.0"));
+    CHECK_EQ(FixedFloat(10, 5, 5, "  -3.25  ").toString(), std::string("-3.25"));
+    CHECK_EQ(FixedFloat(10, 5, 5, ".5").toString(), std::string("0.5"));
+    CHECK_EQ(FixedFloat(10, 5, 5, "7.").toString(), std::string("7.0"));
+    // digits that span many limbs parse and format back unchanged
+    std::string s = "9";
+    for (int i = 0; i < 5000; i++) s += (char) ('0' + i * 7 % 10);
+    s += ".1";
+    for (int i = 0; i < 5000; i++) s += (char) ('0' + i * 3 % 10);
+    s += '1';
+    CHECK_EQ(FixedFloat(10, 6000, 6000, s).toString(), s);
+}
+
+int main() {
+    return Check::run();
+}
@@ -0,0 +1,118 @@
+#include <cstdint>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "FixedFloat.hpp"
+#include "LimbAllocator.hpp"
+#include "Check.hpp"
+
+static uint64_t heap_allocs() {
+    return LimbAllocator::threadStats().heap_allocs;
+}
+
+TEST(buffers_are_zeroed_and_sized_in_classes) {
+    LimbAllocator::Scope scope(LimbAllocator::Strategy::POOL);
+    for (size_t n : {1, 3, 64, 1000}) {
+        CHECK(LimbAllocator::capacity(n) >= n);
+        {
+            LimbAllocator::Buffer b(n);
+            for (size_t i = 0; i < n; i++) b[i] = 0xdeadbeef;
+        }
+        // the same array comes back from the pool and is cleared again
+        LimbAllocator::Buffer b(n);
+        bool zero = true;
+        for (size_t i = 0; i < n; i++) zero = zero && b[i] == 0;
+        CHECK(zero);
+    }
+}
+
+TEST(steady_loops_stop_touching_the_heap) {
+    const FixedFloat x(10, 20, 200, "1.0000001"), c(10, 20, 200, "0.5");
+    const auto loop = [&] {
+        FixedFloat acc = c;
+        for (int i = 0; i < 50; i++) {
+            FixedFloat t = acc * x;
+            acc = std::move(t);
+            acc += c;
+            acc -= c;
+        }
+        return acc;
+    };
+    {
+        LimbAllocator::Scope scope(LimbAllocator::Strategy::POOL);
+        loop();
+        const uint64_t before = heap_allocs();
+        loop();
+        CHECK_EQ(heap_allocs() - before, (uint64_t) 0);
+    }
+    {
+        // without the pool every temporary comes from the heap
+        LimbAllocator::Scope scope(LimbAllocator::Strategy::HEAP);
+        const uint64_t before = heap_allocs();
+        loop();
+        CHECK(heap_allocs() - before >= 50);
+    }
+}
+
+TEST(cached_bytes_are_bounded) {
+    LimbAllocator::Scope scope(LimbAllocator::Strategy::POOL);
+    LimbAllocator::trim();
+    // blocks of 1 MiB, only as many as fit the budget stay in the pool
+    const size_t n = (size_t) 1 << 18, blocks = 10;
+    const size_t kept = LimbAllocator::MAX_CACHED_BYTES / (n * sizeof(uint32_t));
+    std::vector<uint32_t*> ps;
+    for (size_t i = 0; i < blocks; i++) ps.push_back(LimbAllocator::allocate(n, false));
+    const LimbAllocator::Stats before = LimbAllocator::threadStats();
+    for (uint32_t *p : ps) LimbAllocator::release(p, n);
+    const LimbAllocator::Stats after = LimbAllocator::threadStats();
+    CHECK_EQ(after.pool_returns - before.pool_returns, (uint64_t) kept);
+    CHECK_EQ(after.heap_frees - before.heap_frees, (uint64_t) (blocks - kept));
+    LimbAllocator::trim();
+}
+
+TEST(in_place_operators_match_the_plain_ones) {
+    std::mt19937 rng(10);
+    const auto random = [&] {
+        std::string s = rng() % 2 ? "-" : "";
+        s += std::to_string(rng() % 100000) + ".";
+        for (int i = 0; i < 40; i++) s += (char) ('0' + rng() % 10);
+        return FixedFloat(10, 12, 40, s);
+    };
+    for (int round = 0; round < 200; round++) {
+        const FixedFloat a = random(), b = random(), c = random();
+        FixedFloat t = a;
+        t += b;
+        CHECK(t == a + b);
+        t = a;
+        t -= b;
+        CHECK(t == a - b);
+        t = a;
+        t *= b;
+        CHECK(t == a * b);
+        t = c;
+        t.fma(a, b);
+        CHECK(t == c + a * b);
+        // aliasing an operand with the destination
+        t = a;
+        t *= t;
+        CHECK(t == a * a);
+        t = a;
+        t += t;
+        CHECK(t == a + a);
+    }
+}
+
+TEST(moves_transfer_the_limbs) {
+    FixedFloat a(10, 10, 10, "123.456");
+    FixedFloat b(std::move(a));
+    CHECK_EQ(b.toString(), std::string("123.456"));
+    FixedFloat c(16, 4, 4);
+    c = std::move(b);
+    CHECK_EQ(c.toString(), std::string("123.456"));
+    CHECK_EQ(c.getBase(), (uint16_t) 10);
+}
+
+int main() {
+    return Check::run();
+}
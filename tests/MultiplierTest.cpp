@@ -0,0 +1,56 @@
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "FixedFloat.hpp"
+#include "Multiplier.hpp"
+#include "Check.hpp"
+
+static std::vector<uint32_t> random_limbs(std::mt19937_64& rng, size_t n, uint64_t limb_base, bool full) {
+    std::vector<uint32_t> v(n);
+    // the worst case for carries is a run of limbs at limb_base - 1
+    for (uint32_t &x : v) x = full ? (uint32_t) (limb_base - 1) : (uint32_t) (rng() % limb_base);
+    return v;
+}
+
+TEST(algorithms_agree_with_schoolbook) {
+    std::mt19937_64 rng(3);
+    for (uint64_t limb_base : {1000000000ull, 1ull << 32, 3486784401ull}) {
+        for (size_t na : {1, 5, 31, 32, 33, 100, 1024, 1500}) {
+            for (size_t nb : {1, 7, 32, 64, 1024, 1500}) {
+                const bool full = (na + nb) % 3 == 0;
+                const std::vector<uint32_t> a = random_limbs(rng, na, limb_base, full), b = random_limbs(rng, nb, limb_base, full);
+                std::vector<uint32_t> ref(na + nb), r(na + nb);
+                Multiplier::schoolbook(a.data(), na, b.data(), nb, ref.data(), limb_base);
+                Multiplier::karatsuba(a.data(), na, b.data(), nb, r.data(), limb_base);
+                CHECK(r == ref);
+                std::fill(r.begin(), r.end(), 0);
+                Multiplier::ntt(a.data(), na, b.data(), nb, r.data(), limb_base);
+                CHECK(r == ref);
+                std::fill(r.begin(), r.end(), 0);
+                Multiplier::mul(a.data(), na, b.data(), nb, r.data(), limb_base);
+                CHECK(r == ref);
+            }
+        }
+    }
+}
+
+TEST(product_is_truncated_to_the_format) {
+    CHECK_EQ((FixedFloat(10, 5, 5, "1.5") * FixedFloat(10, 5, 5, "-2.25")).toString(), std::string("-3.375"));
+    // decimal digits below the format are dropped, not rounded
+    CHECK_EQ((FixedFloat(10, 5, 3, "0.333") * FixedFloat(10, 5, 3, "0.333")).toString(), std::string("0.11"));
+    // integer digits above it overflow
+    CHECK_EQ((FixedFloat(10, 3, 1, "500") * FixedFloat(10, 3, 1, "3")).toString(), std::string("500.0"));
+}
+
+TEST(long_products_match_across_sizes) {
+    // (10^n - 1)^2 = 10^2n - 2 * 10^n + 1 exercises every carry of the large algorithms
+    for (uint64_t n : {50, 600, 12000}) {
+        const FixedFloat a(10, 2 * n + 2, 0, std::string(n, '9'));
+        const std::string expect = std::string(n - 1, '9') + "8" + std::string(n - 1, '0') + "1.0";
+        CHECK_EQ((a * a).toString(), expect);
+    }
+}
+
+int main() {
+    return Check::run();
+}
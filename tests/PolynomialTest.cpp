@@ -0,0 +1,237 @@
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+#include "FixedFloat.hpp"
+#include "Polynomial.hpp"
+#include "Check.hpp"
+
+// the text of n / base^dec written in base, which FixedFloat parses exactly
+static std::string scaled(int64_t n, uint16_t base, int dec) {
+    const char *chars = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    const bool neg = n < 0;
+    uint64_t u = neg ? -(uint64_t) n : (uint64_t) n;
+    std::string digits;
+    for (; u; u /= base) digits.insert(digits.begin(), chars[u % base]);
+    if ((int) digits.size() <= dec) digits.insert(0, dec + 1 - digits.size(), '0');
+    return (neg ? "-" : "") + digits.substr(0, digits.size() - dec) + "." + digits.substr(digits.size() - dec);
+}
+
+static std::vector<FixedFloat> coefficients(const std::vector<int64_t>& ns, uint16_t base, uint64_t int_len, uint64_t dec_len, int dec) {
+    std::vector<FixedFloat> ret;
+    for (int64_t n : ns) ret.emplace_back(base, int_len, dec_len, scaled(n, base, dec));
+    return ret;
+}
+
+// the same product with one fma per pair of coefficients, which truncates every term
+static std::vector<FixedFloat> schoolbook(const std::vector<FixedFloat>& a, const std::vector<FixedFloat>& b) {
+    const FixedFloat &like = a[0];
+    std::vector<FixedFloat> ret(a.size() + b.size() - 1, FixedFloat(like.getBase(), like.getIntDigitLen(), like.getDecDigitLen()));
+    for (size_t i = 0; i < a.size(); i++) {
+        for (size_t j = 0; j < b.size(); j++) ret[i + j].fma(a[i], b[j]);
+    }
+    return ret;
+}
+
+static FixedFloat distance(const FixedFloat& a, const FixedFloat& b) {
+    return a > b ? a - b : b - a;
+}
+
+TEST(products_around_the_threshold_are_exact) {
+    // mixed-sign integers over base^2, so every product coefficient has 4 fractional digits and fits the format
+    std::mt19937_64 rng(1);
+    const size_t sizes[] = {Polynomial::KRONECKER_THRESHOLD, Polynomial::KRONECKER_THRESHOLD + 1, 30};
+    for (uint16_t base : {2, 7, 10, 16}) {
+        for (size_t na : sizes) {
+            for (size_t nb : sizes) {
+                std::vector<int64_t> a(na), b(nb);
+                for (int64_t &x : a) x = (int64_t) (rng() % 2001) - 1000;
+                for (int64_t &x : b) x = (int64_t) (rng() % 2001) - 1000;
+                // nonzero leading coefficients keep both operands at their full length
+                a.back() = 999;
+                b.back() = -998;
+                std::vector<int64_t> c(na + nb - 1, 0);
+                for (size_t i = 0; i < na; i++) {
+                    for (size_t j = 0; j < nb; j++) c[i + j] += a[i] * b[j];
+                }
+                const Polynomial pa(coefficients(a, base, 40, 20, 2)), pb(coefficients(b, base, 40, 20, 2));
+                const Polynomial product = pa * pb;
+                const std::vector<FixedFloat> &got = product.coefficients();
+                CHECK_EQ(got.size(), c.size());
+                for (size_t k = 0; k < std::min(got.size(), c.size()); k++) {
+                    CHECK_EQ(got[k].toString(), FixedFloat(base, 40, 20, scaled(c[k], base, 4)).toString());
+                }
+            }
+        }
+    }
+}
+
+TEST(one_sided_signs) {
+    // operands with only positive or only negative coefficients leave two of the four packed products zero
+    const Polynomial plus(coefficients(std::vector<int64_t>(20, 3), 10, 10, 10, 1));
+    const Polynomial minus(coefficients(std::vector<int64_t>(20, -3), 10, 10, 10, 1));
+    const Polynomial a = plus * plus, b = plus * minus, c = minus * minus;
+    const std::vector<FixedFloat> &pp = a.coefficients(), &pm = b.coefficients(), &mm = c.coefficients();
+    CHECK_EQ(pp.size(), (size_t) 39);
+    CHECK_EQ(pp[0].toString(), std::string("0.09"));
+    CHECK_EQ(pp[19].toString(), std::string("1.8"));
+    CHECK_EQ(pm[19].toString(), std::string("-1.8"));
+    CHECK_EQ(mm[38].toString(), std::string("0.09"));
+    for (size_t k = 0; k < pp.size(); k++) {
+        CHECK(pp[k] == mm[k]);
+        CHECK(pp[k] == -pm[k]);
+    }
+}
+
+TEST(truncation_stays_within_the_schoolbook_error) {
+    // the reference is the exact product in a format with twice the fractional digits, cut back to the operand format;
+    // the Kronecker product truncates the exact sum once, fma truncates every term
+    std::mt19937_64 rng(2);
+    const char *chars = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    for (uint16_t base : {2, 7, 10, 16}) {
+        const uint64_t int_len = 12, dec_len = 25;
+        const FixedFloat ulp(base, int_len, dec_len, "0." + std::string(dec_len - 1, '0') + "1");
+        for (int round = 0; round < 5; round++) {
+            std::vector<FixedFloat> a, b;
+            for (std::vector<FixedFloat> *v : {&a, &b}) {
+                for (int i = 0; i < 30; i++) {
+                    std::string s = rng() % 2 ? "-0." : "0.";
+                    for (uint64_t d = 0; d < dec_len; d++) s += chars[rng() % base];
+                    v->emplace_back(base, int_len, dec_len, s);
+                }
+            }
+            std::vector<FixedFloat> wa, wb;
+            for (const FixedFloat &x : a) wa.push_back(x.convertTo(base, int_len, 2 * dec_len));
+            for (const FixedFloat &x : b) wb.push_back(x.convertTo(base, int_len, 2 * dec_len));
+            const std::vector<FixedFloat> exact = schoolbook(wa, wb), fma = schoolbook(a, b);
+            const Polynomial product = Polynomial(a) * Polynomial(b);
+            const std::vector<FixedFloat> &got = product.coefficients();
+            CHECK_EQ(got.size(), exact.size());
+            const FixedFloat wide_ulp = ulp.convertTo(base, int_len, 2 * dec_len);
+            FixedFloat worst_got(base, int_len, 2 * dec_len), worst_fma(base, int_len, 2 * dec_len);
+            for (size_t k = 0; k < std::min(got.size(), exact.size()); k++) {
+                CHECK_EQ(got[k].toString(), exact[k].convertTo(base, int_len, dec_len).toString());
+                const FixedFloat got_err = distance(got[k].convertTo(base, int_len, 2 * dec_len), exact[k]);
+                const FixedFloat fma_err = distance(fma[k].convertTo(base, int_len, 2 * dec_len), exact[k]);
+                CHECK(got_err < wide_ulp);
+                worst_got = std::max(worst_got, got_err, [] (const FixedFloat& x, const FixedFloat& y) { return x < y; });
+                worst_fma = std::max(worst_fma, fma_err, [] (const FixedFloat& x, const FixedFloat& y) { return x < y; });
+            }
+            CHECK(!(worst_got > worst_fma));
+        }
+    }
+}
+
+TEST(both_paths_truncate_alike) {
+    // products on either side of KRONECKER_THRESHOLD must give the exact product cut once to the format, digit for
+    // digit, so expanding an expression does not change its last digit when a degree crosses the threshold
+    std::mt19937_64 rng(5);
+    const char *chars = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    const size_t t = Polynomial::KRONECKER_THRESHOLD;
+    const size_t sizes[][2] = {{t, t}, {t, 30}, {t + 1, t + 1}, {t + 1, 30}, {30, t}, {30, 30}};
+    for (uint16_t base : {2, 7, 10, 16}) {
+        const uint64_t int_len = 8, dec_len = 21;
+        for (const auto &size : sizes) {
+            std::vector<FixedFloat> a, b;
+            for (size_t i = 0; i < size[0] + size[1]; i++) {
+                std::string s = rng() % 2 ? "-" : "";
+                s += chars[rng() % base];
+                s += '.';
+                for (uint64_t d = 0; d < dec_len; d++) s += chars[rng() % base];
+                (i < size[0] ? a : b).emplace_back(base, int_len, dec_len, s);
+            }
+            std::vector<FixedFloat> wa, wb;
+            for (const FixedFloat &x : a) wa.push_back(x.convertTo(base, int_len, 2 * dec_len));
+            for (const FixedFloat &x : b) wb.push_back(x.convertTo(base, int_len, 2 * dec_len));
+            const std::vector<FixedFloat> exact = schoolbook(wa, wb);
+            const Polynomial product = Polynomial(a) * Polynomial(b);
+            const std::vector<FixedFloat> &got = product.coefficients();
+            CHECK_EQ(got.size(), exact.size());
+            for (size_t k = 0; k < std::min(got.size(), exact.size()); k++) {
+                CHECK_EQ(got[k].toString(), exact[k].convertTo(base, int_len, dec_len).toString());
+            }
+        }
+    }
+}
+
+TEST(multipoint_matches_horner_at_higher_precision) {
+    // the reference is Horner with twice the fractional digits, cut back to the format; the tree works with guard
+    // digits and truncates once, so the two stay within one unit of the last digit
+    std::mt19937_64 rng(6);
+    const char *chars = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    const size_t cases[][2] = {{0, 3}, {1, 1}, {7, 8}, {8, 20}, {9, 10}, {40, 41}, {40, 100}};
+    for (uint16_t base : {2, 10, 16}) {
+        const uint64_t int_len = 8, dec_len = 60;
+        const FixedFloat ulp(base, int_len, dec_len, "0." + std::string(dec_len - 1, '0') + "1");
+        const auto random = [&] {
+            std::string s = rng() % 2 ? "-0." : "0.";
+            for (uint64_t d = 0; d < dec_len; d++) s += chars[rng() % base];
+            return FixedFloat(base, int_len, dec_len, s);
+        };
+        for (const auto &c : cases) {
+            std::vector<FixedFloat> coeffs, xs;
+            for (size_t i = 0; i <= c[0]; i++) coeffs.push_back(random());
+            for (size_t i = 0; i < c[1]; i++) xs.push_back(random());
+            // zero and a repeated point are ordinary roots of the subproducts
+            xs[0] = FixedFloat(base, int_len, dec_len);
+            if (xs.size() > 2) xs[2] = xs[1];
+            const Polynomial p(coeffs), wide = p.convertTo(base, int_len, 2 * dec_len);
+            const std::vector<FixedFloat> got = p.evalMultipoint(xs);
+            CHECK_EQ(got.size(), xs.size());
+            for (size_t i = 0; i < std::min(got.size(), xs.size()); i++) {
+                const FixedFloat ref = wide.eval(xs[i].convertTo(base, int_len, 2 * dec_len)).convertTo(base, int_len, dec_len);
+                CHECK(!(distance(got[i], ref) > ulp));
+                CHECK_EQ(got[i].getDecDigitLen(), dec_len);
+            }
+        }
+    }
+    CHECK(Polynomial().evalMultipoint(std::vector<FixedFloat>(2, FixedFloat(10, 5, 5, "1.5")))[1].isZero());
+    CHECK(Polynomial::multipointGuard(100, 101, 1, 10) > Polynomial::multipointGuard(50, 51, 1, 10));
+    CHECK(Polynomial::multipointGuard(100, 101, 1, 2) > Polynomial::multipointGuard(100, 101, 1, 10));
+}
+
+TEST(same_base_conversions_round_trip) {
+    // widening copies every digit into the new window, narrowing back to the original format gives the same value
+    std::mt19937_64 rng(3);
+    const char *chars = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    for (uint16_t base : {2, 3, 7, 10, 16, 36}) {
+        for (int round = 0; round < 20; round++) {
+            const uint64_t int_len = 1 + rng() % 40, dec_len = rng() % 40;
+            std::string s = rng() % 2 ? "-" : "";
+            for (uint64_t i = 0; i < int_len; i++) s += chars[rng() % base];
+            s += '.';
+            for (uint64_t i = 0; i < dec_len; i++) s += chars[rng() % base];
+            const FixedFloat x(base, int_len, dec_len, s);
+            const FixedFloat wide = x.convertTo(base, int_len + 1 + rng() % 30, dec_len + 1 + rng() % 30);
+            CHECK(wide.convertTo(base, int_len, dec_len) == x);
+            CHECK_EQ(wide.toString(), x.toString());
+        }
+    }
+}
+
+TEST(same_base_conversions_match_the_general_path) {
+    // a base that holds every value of the source exactly is converted by the general path, so going through it
+    // gives the reference result for windows that wrap the integer part and truncate the fraction
+    struct Pair { uint16_t base, exact; uint64_t scale; };
+    const Pair pairs[] = {{2, 6, 1}, {7, 14, 1}, {10, 20, 1}, {16, 6, 4}};
+    const char *chars = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    std::mt19937_64 rng(4);
+    for (const Pair &p : pairs) {
+        for (int round = 0; round < 30; round++) {
+            const uint64_t int_len = 1 + rng() % 30, dec_len = rng() % 30;
+            std::string s = rng() % 2 ? "-" : "";
+            for (uint64_t i = 0; i < int_len; i++) s += chars[rng() % p.base];
+            s += '.';
+            for (uint64_t i = 0; i < dec_len; i++) s += chars[rng() % p.base];
+            const FixedFloat x(p.base, int_len, dec_len, s);
+            const uint64_t to_int = 1 + rng() % 30, to_dec = rng() % 30;
+            const FixedFloat exact = x.convertTo(p.exact, int_len * 2 * p.scale, dec_len * p.scale);
+            CHECK_EQ(x.convertTo(p.base, to_int, to_dec).toString(), exact.convertTo(p.base, to_int, to_dec).toString());
+        }
+    }
+}
+
+int main() {
+    return Check::run();
+}
@@ -0,0 +1,165 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "FixedFloat.hpp"
+#include "Expression.hpp"
+#include "Profiler.hpp"
+#include "Check.hpp"
+
+static bool contains(const std::string& s, const std::string& part) {
+    return s.find(part) != std::string::npos;
+}
+
+TEST(every_instruction_is_counted) {
+    // two literals, x, one add, one sub and one division
+    const Expression e("(x+1)/(x-3)");
+    const FixedFloat x(10, 20, 40, "0.5");
+    Profiler::Profile profile("(x+1)/(x-3)");
+    {
+        Profiler::Scope scope(&profile);
+        e.eval(x);
+    }
+    CHECK_EQ(profile.stats(Profiler::Op::CONST).count, (uint64_t) 2);
+    CHECK_EQ(profile.stats(Profiler::Op::VAR).count, (uint64_t) 1);
+    CHECK_EQ(profile.stats(Profiler::Op::ADD).count, (uint64_t) 1);
+    CHECK_EQ(profile.stats(Profiler::Op::SUB).count, (uint64_t) 1);
+    CHECK_EQ(profile.stats(Profiler::Op::DIV).count, (uint64_t) 1);
+    CHECK_EQ(profile.stats(Profiler::Op::MUL).count, (uint64_t) 0);
+    CHECK_EQ(profile.total().count, (uint64_t) 6);
+    // 1.5 / -2.5, both operands have two significant digits
+    CHECK_EQ(profile.stats(Profiler::Op::DIV).max_operand_digits, (uint64_t) 2);
+    // outside the scope nothing is recorded
+    e.eval(x);
+    CHECK_EQ(profile.total().count, (uint64_t) 6);
+    // the lanes of a batch count once each, the literals are loaded once for the whole batch
+    profile.reset();
+    CHECK_EQ(profile.total().count, (uint64_t) 0);
+    {
+        Profiler::Scope scope(&profile);
+        e.evalBatch(std::vector<FixedFloat>(40, x));
+    }
+    CHECK_EQ(profile.stats(Profiler::Op::ADD).count, (uint64_t) 40);
+    CHECK_EQ(profile.stats(Profiler::Op::DIV).count, (uint64_t) 40);
+    // a polynomial is one Horner evaluation
+    Profiler::Profile poly("poly");
+    {
+        Profiler::Scope scope(&poly);
+        Expression("x^3-2*x+1").eval(x);
+    }
+    CHECK_EQ(poly.stats(Profiler::Op::HORNER).count, (uint64_t) 1);
+    CHECK_EQ(poly.stats(Profiler::Op::MUL).count, (uint64_t) 0);
+}
+
+TEST(operands_count_their_effective_digits) {
+    // the literal is written with 10 digits but folds to 1.2345 in this format, and 0.500 folds to a single digit
+    const Expression e("x*1.23456789+0.500");
+    Profiler::Profile profile("literals");
+    {
+        Profiler::Scope scope(&profile);
+        e.eval(FixedFloat(10, 10, 4, "2"));
+    }
+    CHECK_EQ(profile.stats(Profiler::Op::CONST).count, (uint64_t) 2);
+    CHECK_EQ(profile.stats(Profiler::Op::CONST).operand_digits, (uint64_t) 6);
+    CHECK_EQ(profile.stats(Profiler::Op::CONST).max_operand_digits, (uint64_t) 5);
+    // lanes report each point's own digits, the same as evaluating the points one by one
+    const Expression f("(x+1)*(x-3)/x");
+    std::vector<FixedFloat> xs;
+    for (int i = 0; i < 40; i++) xs.emplace_back(10, 20, 40, i % 3 ? "0.5" : "12.125");
+    Profiler::Profile batch("batch"), single("single");
+    {
+        Profiler::Scope scope(&batch);
+        f.evalBatch(xs);
+    }
+    {
+        Profiler::Scope scope(&single);
+        for (const FixedFloat &x : xs) f.eval(x);
+    }
+    for (Profiler::Op op : {Profiler::Op::VAR, Profiler::Op::ADD, Profiler::Op::SUB, Profiler::Op::MUL, Profiler::Op::DIV}) {
+        CHECK_EQ(batch.stats(op).count, single.stats(op).count);
+        CHECK_EQ(batch.stats(op).operand_digits, single.stats(op).operand_digits);
+        CHECK_EQ(batch.stats(op).max_operand_digits, single.stats(op).max_operand_digits);
+    }
+    // 0.5 has 1 digit and 12.125 has 5, far below the 60 digits of the format
+    CHECK_EQ(batch.stats(Profiler::Op::VAR).operand_digits, (uint64_t) (26 * 1 + 14 * 5));
+    CHECK_EQ(batch.stats(Profiler::Op::VAR).max_operand_digits, (uint64_t) 5);
+    // the same for the Horner lanes of a polynomial
+    const Expression g("x^3-2*x+1");
+    Profiler::Profile horner("horner");
+    {
+        Profiler::Scope scope(&horner);
+        g.evalBatch(xs);
+    }
+    CHECK_EQ(horner.stats(Profiler::Op::HORNER).count, (uint64_t) 40);
+    CHECK_EQ(horner.stats(Profiler::Op::HORNER).operand_digits, (uint64_t) (26 * 1 + 14 * 5));
+    CHECK_EQ(horner.stats(Profiler::Op::HORNER).max_operand_digits, (uint64_t) 5);
+}
+
+TEST(scopes_nest) {
+    const Expression e("1/x");
+    const FixedFloat x(10, 5, 5, "3");
+    Profiler::Profile outer("outer"), inner("inner");
+    CHECK(Profiler::active() == nullptr);
+    {
+        Profiler::Scope a(&outer);
+        e.eval(x);
+        {
+            Profiler::Scope b(&inner);
+            CHECK(Profiler::active() == &inner);
+            e.eval(x);
+            e.eval(x);
+            {
+                // a null scope turns recording off inside it
+                Profiler::Scope c(nullptr);
+                e.eval(x);
+            }
+            CHECK(Profiler::active() == &inner);
+        }
+        CHECK(Profiler::active() == &outer);
+        e.eval(x);
+    }
+    CHECK(Profiler::active() == nullptr);
+    CHECK_EQ(outer.stats(Profiler::Op::DIV).count, (uint64_t) 2);
+    CHECK_EQ(inner.stats(Profiler::Op::DIV).count, (uint64_t) 2);
+}
+
+TEST(reports) {
+    const Expression e("(x+1)/(x-3)");
+    Profiler::Profile profile("say \"hi\"", true);
+    {
+        Profiler::Scope scope(&profile);
+        e.eval(FixedFloat(10, 20, 40, "0.5"));
+    }
+    CHECK_EQ(profile.timeline().size(), (size_t) 6);
+    const std::string json = profile.toJson();
+    CHECK(contains(json, "{\"label\": \"say \\\"hi\\\"\", \"ops\": ["));
+    CHECK(contains(json, "{\"op\": \"DIV\", \"count\": 1, "));
+    CHECK(!contains(json, "\"op\": \"MUL\"")); // operations that never ran are left out
+    CHECK(contains(json, "\"events\": 6, \"dropped_events\": 0}"));
+    const std::string trace = profile.toChromeTrace();
+    CHECK(contains(trace, "\"traceEvents\": ["));
+    CHECK(contains(trace, "{\"name\": \"DIV\", \"cat\": \"expression\", \"ph\": \"X\""));
+    CHECK(contains(trace, "\"args\": {\"instr\": 5, \"lhs_digits\": 2, \"rhs_digits\": 2}"));
+    CHECK(contains(profile.toText(), "profile of say \"hi\"\n"));
+    // past max_events the events are only counted
+    Profiler::Profile small("small", true, 2);
+    {
+        Profiler::Scope scope(&small);
+        e.eval(FixedFloat(10, 20, 40, "0.5"));
+    }
+    CHECK_EQ(small.timeline().size(), (size_t) 2);
+    const uint64_t dropped = small.total().count - 2;
+    CHECK(dropped > 0);
+    CHECK(contains(small.toJson(), "\"events\": 2, \"dropped_events\": " + std::to_string(dropped) + "}"));
+    // without trace the timeline stays empty
+    Profiler::Profile plain("plain");
+    {
+        Profiler::Scope scope(&plain);
+        e.eval(FixedFloat(10, 20, 40, "0.5"));
+    }
+    CHECK(plain.timeline().empty());
+    CHECK(!contains(plain.toChromeTrace(), "\"ph\""));
+}
+
+int main() {
+    return Check::run();
+}
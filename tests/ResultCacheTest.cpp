@@ -0,0 +1,74 @@
+#include <cstdint>
+#include <string>
+#include "FixedFloat.hpp"
+#include "Expression.hpp"
+#include "ResultCache.hpp"
+#include "Profiler.hpp"
+#include "Check.hpp"
+
+TEST(sources_are_normalized) {
+    CHECK_EQ(ResultCache::normalize(" x ^ 2 +\t1 "), std::string("x^2+1"));
+    CHECK_EQ(ResultCache::normalize("1 2+x"), std::string("1 2+x")); // stays invalid
+    ResultCache cache;
+    CHECK(cache.compile("x + 1") == cache.compile("x+1"));
+    CHECK_EQ(cache.expressionCount(), (size_t) 1);
+}
+
+TEST(results_match_eval_and_hit) {
+    ResultCache cache;
+    const FixedFloat x(10, 10, 30, "1.5"), y(16, 10, 30, "1.5");
+    const FixedFloat a = cache.eval("x^3/7", x);
+    CHECK(a == Expression("x^3/7").eval(x));
+    CHECK(cache.eval("x^3/7", x) == a);
+    // the same digits in another format are another entry
+    CHECK(cache.eval("x^3/7", y) == Expression("x^3/7").eval(y));
+    const ResultCache::Stats s = cache.resultStats();
+    CHECK_EQ(s.hits, (uint64_t) 1);
+    CHECK_EQ(s.misses, (uint64_t) 2);
+    CHECK_EQ(cache.resultCount(), (size_t) 2);
+}
+
+TEST(interleaved_expressions_stay_prepared) {
+    // 3/x+x and 7/x alternate on one thread, neither folds its constants again after the first call
+    ResultCache cache;
+    const auto a = cache.compile("3/x+x"), b = cache.compile("7/x");
+    cache.eval(*a, FixedFloat(10, 10, 30, "1.5"));
+    cache.eval(*b, FixedFloat(10, 10, 30, "1.5"));
+    Profiler::Profile profile("3/x+x");
+    FixedFloat r(10, 10, 30);
+    {
+        Profiler::Scope scope(&profile);
+        r = cache.eval(*a, FixedFloat(10, 10, 30, "2.5"));
+    }
+    CHECK(r == Expression("3/x+x").eval(FixedFloat(10, 10, 30, "2.5")));
+    CHECK_EQ(profile.stats(Profiler::Op::CONST).count, (uint64_t) 0);
+    CHECK_EQ(profile.stats(Profiler::Op::DIV).count, (uint64_t) 1);
+    // a failing evaluation still hands its context back
+    const auto c = cache.compile("1/x");
+    CHECK_THROWS(cache.eval(*c, FixedFloat(10, 10, 30, "0")));
+    CHECK_EQ(cache.eval(*c, FixedFloat(10, 10, 30, "4")).toString(), std::string("0.25"));
+}
+
+TEST(results_are_bounded_by_bytes) {
+    // a 10000-digit result and its key take several kilobytes, far more than a short one
+    const size_t limit = 64 << 10;
+    ResultCache cache(16, limit);
+    for (int i = 0; i < 100; i++) {
+        cache.eval("x+1", FixedFloat(10, 10, 10000, std::to_string(i)));
+        CHECK(cache.resultBytes() <= limit);
+    }
+    CHECK(cache.resultCount() < 100);
+    CHECK(cache.resultStats().evictions > 0);
+    // many short results fit in the same budget
+    ResultCache small(16, limit);
+    for (int i = 0; i < 100; i++) small.eval("x+1", FixedFloat(10, 10, 10, std::to_string(i)));
+    CHECK_EQ(small.resultCount(), (size_t) 100);
+    // an entry larger than the whole budget is computed but not kept
+    ResultCache tiny(16, 1000);
+    CHECK_EQ(tiny.eval("x+1", FixedFloat(10, 10, 10000, "1")).toString(), std::string("2.0"));
+    CHECK_EQ(tiny.resultCount(), (size_t) 0);
+}
+
+int main() {
+    return Check::run();
+}
@@ -0,0 +1,68 @@
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "FixedFloat.hpp"
+#include "Polynomial.hpp"
+#include "Expression.hpp"
+#include "RootFinder.hpp"
+#include "Check.hpp"
+
+static Polynomial poly(const std::string& src, uint64_t dec_len) {
+    Polynomial p;
+    Expression(src).toPolynomial(FixedFloat(10, 10, dec_len), p);
+    return p;
+}
+
+static bool near(const FixedFloat& a, double b, double tol) {
+    return std::abs(a.doubleValue() - b) < tol;
+}
+
+TEST(value_and_derivative_in_one_pass) {
+    const Polynomial p = poly("3*x^4-x^3/7+2*x-5", 30), dp = poly("12*x^3-3*x^2/7+2", 30);
+    for (const char *x : {"0", "1.25", "-2.5", "0.001"}) {
+        const FixedFloat v(10, 10, 30, x);
+        FixedFloat value(v), derivative(v);
+        p.evalWithDerivative(v, value, derivative);
+        CHECK(value == p.eval(v));
+        // 3/7 and 1/7 are truncated on their own, so the two derivatives differ in the last digits
+        const FixedFloat diff = derivative - dp.eval(v);
+        const FixedFloat tol(10, 10, 30, "0.0000000000000000000000001");
+        CHECK(diff < tol && -tol < diff);
+    }
+}
+
+TEST(newton_reaches_every_digit) {
+    const Polynomial p = poly("x^2-2", 100);
+    const FixedFloat r = RootFinder::newton(p, FixedFloat(10, 10, 100, "1"), FixedFloat(10, 10, 100, "2"));
+    const std::string sqrt2 = "1.4142135623730950488016887242096980785696718753769480731766797379907324784621070388503875343276415727";
+    // within one unit of the last digit
+    const FixedFloat diff = r - FixedFloat(10, 10, 100, sqrt2);
+    const FixedFloat unit(10, 10, 100, "0." + std::string(99, '0') + "1");
+    CHECK(!(unit < diff) && !(diff < -unit));
+    // the bracket must change sign
+    CHECK_THROWS(RootFinder::newton(p, FixedFloat(10, 10, 100, "2"), FixedFloat(10, 10, 100, "3")));
+}
+
+TEST(aberth_finds_real_and_complex_roots) {
+    std::vector<RootFinder::Root> roots = RootFinder::aberth(poly("x^3-7*x+6", 40)); // (x - 1)(x - 2)(x + 3)
+    CHECK_EQ(roots.size(), (size_t) 3);
+    std::vector<double> re;
+    for (const RootFinder::Root &r : roots) {
+        re.push_back(r.re.doubleValue());
+        CHECK(near(r.im, 0, 1e-30));
+    }
+    std::sort(re.begin(), re.end());
+    CHECK(re.size() == 3 && std::abs(re[0] + 3) < 1e-30 && std::abs(re[1] - 1) < 1e-30 && std::abs(re[2] - 2) < 1e-30);
+
+    roots = RootFinder::aberth(poly("x^2+1", 40));
+    CHECK_EQ(roots.size(), (size_t) 2);
+    for (const RootFinder::Root &r : roots) {
+        CHECK(near(r.re, 0, 1e-30));
+        CHECK(near(r.im, 1, 1e-30) || near(r.im, -1, 1e-30));
+    }
+}
+
+int main() {
+    return Check::run();
+}
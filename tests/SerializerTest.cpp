@@ -0,0 +1,150 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "FixedFloat.hpp"
+#include "Expression.hpp"
+#include "Serializer.hpp"
+#include "Check.hpp"
+
+static std::vector<FixedFloat> samples() {
+    return {
+        FixedFloat(10, 20, 30, "-123.456"),
+        FixedFloat(16, 5, 7, "ff.abc"),
+        FixedFloat(2, 3, 0, "101"),
+        FixedFloat(10, 500, 500, "0"),
+        FixedFloat(36, 1, 1, "z.z"),
+    };
+}
+
+TEST(fixed_floats_round_trip) {
+    std::string bytes;
+    for (const FixedFloat &f : samples()) {
+        const size_t at = bytes.size();
+        Serializer::write(f, bytes);
+        CHECK_EQ(bytes.size() - at, Serializer::size(f));
+        CHECK_EQ(bytes.size() % 8, (size_t) 0);
+    }
+    size_t offset = 0;
+    for (const FixedFloat &f : samples()) {
+        const FixedFloat g = Serializer::read(bytes.data(), bytes.size(), offset);
+        CHECK_EQ(g.getBase(), f.getBase());
+        CHECK_EQ(g.getIntDigitLen(), f.getIntDigitLen());
+        CHECK_EQ(g.getDecDigitLen(), f.getDecDigitLen());
+        CHECK_EQ(g.toString(), f.toString());
+    }
+    CHECK_EQ(offset, bytes.size());
+    // the views of the concatenated records point into the buffer
+    const std::vector<Serializer::View> views = Serializer::viewAll(bytes.data(), bytes.size());
+    CHECK_EQ(views.size(), samples().size());
+    for (size_t i = 0; i < views.size(); i++) {
+        CHECK(views[i].limbs >= (const uint32_t *) bytes.data() && views[i].limbs < (const uint32_t *) (bytes.data() + bytes.size()));
+        CHECK_EQ(views[i].toFixedFloat().toString(), samples()[i].toString());
+    }
+}
+
+TEST(expressions_round_trip) {
+    for (const char *src : {"x", "(x^2+1)/(x-3)", "3/7*x^5-x^2/3+1", "2x(x+1)-0.25", "x^(-2)+x^8+x^4"}) {
+        const Expression e(src);
+        std::string bytes;
+        Serializer::write(e, bytes);
+        CHECK_EQ(bytes.size() % 8, (size_t) 0);
+        size_t offset = 0;
+        const Expression f = Serializer::readExpression(bytes.data(), bytes.size(), offset);
+        CHECK_EQ(offset, bytes.size());
+        CHECK_EQ(f.instructionCount(), e.instructionCount());
+        for (const char *x : {"0.5", "-1.25", "7"}) {
+            const FixedFloat v(10, 20, 30, x);
+            CHECK_EQ(f.eval(v).toString(), e.eval(v).toString());
+        }
+    }
+}
+
+TEST(bad_records_throw) {
+    const FixedFloat f(10, 20, 30, "-123.456");
+    std::string bytes;
+    Serializer::write(f, bytes);
+    size_t offset = 0;
+    // every cut inside the header or the limbs is detected
+    for (size_t n : {(size_t) 0, (size_t) 4, (size_t) 39, (size_t) 41, bytes.size() - 12}) {
+        offset = 0;
+        CHECK_THROWS(Serializer::read(bytes.data(), n, offset));
+    }
+    offset = bytes.size() + 8;
+    CHECK_THROWS(Serializer::read(bytes.data(), bytes.size(), offset));
+    std::string magic = bytes;
+    magic[0] = 'G';
+    offset = 0;
+    CHECK_THROWS(Serializer::read(magic.data(), magic.size(), offset));
+    std::string version = bytes;
+    version[4] = 2;
+    offset = 0;
+    CHECK_THROWS(Serializer::read(version.data(), version.size(), offset));
+    // a limb of 10^9 is not a base 10 limb, the view accepts it but the copy does not
+    std::string limb = bytes;
+    const uint32_t big = 1000000000;
+    memcpy(limb.data() + 40, &big, sizeof(big));
+    offset = 0;
+    const Serializer::View v = Serializer::view(limb.data(), limb.size(), offset);
+    CHECK_THROWS(v.toFixedFloat());
+    // a FixedFloat record is not an expression and the other way around
+    offset = 0;
+    CHECK_THROWS(Serializer::readExpression(bytes.data(), bytes.size(), offset));
+    std::string expr;
+    Serializer::write(Expression("x+1"), expr);
+    offset = 0;
+    CHECK_THROWS(Serializer::read(expr.data(), expr.size(), offset));
+    offset = 0;
+    CHECK_THROWS(Serializer::readExpression(expr.data(), expr.size() - 8, offset));
+}
+
+TEST(oversized_headers_throw) {
+    // a header that claims a format of hundreds of GB is rejected from its lengths, before anything is allocated
+    const FixedFloat f(10, 20, 30, "-123.456");
+    std::string bytes;
+    Serializer::write(f, bytes);
+    std::string huge = bytes;
+    const uint64_t n = FixedFloat::MAX_DIGIT_LEN / 2;
+    memcpy(huge.data() + 16, &n, sizeof(n));
+    memcpy(huge.data() + 24, &n, sizeof(n));
+    size_t offset = 0;
+    CHECK_THROWS(Serializer::view(huge.data(), huge.size(), offset));
+    offset = 0;
+    CHECK_THROWS(Serializer::read(huge.data(), huge.size(), offset));
+    // the same for a view that was not read from a record
+    offset = 0;
+    Serializer::View v = Serializer::view(bytes.data(), bytes.size(), offset);
+    v.int_digit_len = n;
+    v.dec_digit_len = n;
+    CHECK_THROWS(v.toFixedFloat());
+    v.int_digit_len = FixedFloat::MAX_DIGIT_LEN;
+    CHECK_THROWS(v.toFixedFloat());
+    // lengths that only disagree with the limb count are rejected as well
+    std::string wider = bytes;
+    const uint64_t dec = 40;
+    memcpy(wider.data() + 24, &dec, sizeof(dec));
+    offset = 0;
+    CHECK_THROWS(Serializer::view(wider.data(), wider.size(), offset));
+}
+
+TEST(mapped_files) {
+    const std::string path = (std::filesystem::temp_directory_path() / "fixedfloat_serializer_test.bin").string();
+    std::string bytes;
+    for (const FixedFloat &f : samples()) Serializer::write(f, bytes);
+    Serializer::save(path, bytes);
+    {
+        const Serializer::MappedFile file(path);
+        CHECK_EQ(file.size(), bytes.size());
+        const std::vector<Serializer::View> views = Serializer::viewAll(file.data(), file.size());
+        CHECK_EQ(views.size(), samples().size());
+        for (size_t i = 0; i < views.size(); i++) CHECK_EQ(views[i].toFixedFloat().toString(), samples()[i].toString());
+    }
+    std::remove(path.c_str());
+    CHECK_THROWS(Serializer::MappedFile(path));
+}
+
+int main() {
+    return Check::run();
+}
@@ -0,0 +1,234 @@
+#include <cstdint>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "FixedFloat.hpp"
+#include "Expression.hpp"
+#include "BatchRunner.hpp"
+#include "ThreadPool.hpp"
+#include "Server.hpp"
+#include "Check.hpp"
+
+static std::string socket_path(const char *name) {
+    return (std::filesystem::temp_directory_path() / (std::string(name) + "." + std::to_string(getpid()) + ".sock")).string();
+}
+
+static int connect_to(const std::string& path) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, (const sockaddr *) &addr, sizeof(addr)) < 0) throw std::runtime_error("can not connect to " + path);
+    return fd;
+}
+
+TEST(frames_round_trip) {
+    int fds[2];
+    CHECK_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    CHECK(Server::writeFrame(fds[0], 7, "eval 10 5 5 x 1"));
+    CHECK(Server::writeFrame(fds[0], 8, ""));
+    uint32_t id;
+    std::string payload;
+    CHECK(Server::readFrame(fds[1], id, payload));
+    CHECK_EQ(id, (uint32_t) 7);
+    CHECK_EQ(payload, std::string("eval 10 5 5 x 1"));
+    CHECK(Server::readFrame(fds[1], id, payload));
+    CHECK_EQ(id, (uint32_t) 8);
+    CHECK(payload.empty());
+    // a close at a frame boundary ends the stream, a close inside a frame is an error
+    const char half[6] = {3, 0, 0, 0, 1, 0};
+    CHECK_EQ(write(fds[0], half, sizeof(half)), (ssize_t) sizeof(half));
+    close(fds[0]);
+    CHECK_THROWS(Server::readFrame(fds[1], id, payload));
+    close(fds[1]);
+    CHECK_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    close(fds[0]);
+    CHECK(!Server::readFrame(fds[1], id, payload));
+    close(fds[1]);
+}
+
+TEST(concurrent_clients_match_batch_results) {
+    // every client pipelines jobs with enough points for evalBatch, so several of them run nested in
+    // tasks of the pool at once, and each response must equal the batch mode output for its job
+    ThreadPool pool(3);
+    const std::string path = socket_path("fixedfloat_server_test");
+    Server server(path, pool);
+    std::thread serving([&] { server.run(); });
+    const size_t clients = 6, jobs_per_client = 40;
+    BatchRunner reference;
+    std::vector<std::vector<std::string>> jobs(clients), expected(clients), got(clients);
+    for (size_t c = 0; c < clients; c++) {
+        for (size_t j = 0; j < jobs_per_client; j++) {
+            const Expression e("(x^3-2)/(x+7)");
+            std::string job = "eval 10 10 30 (x^3-2)/(x+7)", results;
+            for (size_t i = 0; i < BatchRunner::BATCH_MIN_POINTS + 16; i++) {
+                const std::string x = std::to_string(c * jobs_per_client + j) + "." + std::to_string(1000 + 13 * i);
+                job += " " + x;
+                if (i) results += ' ';
+                results += e.eval(FixedFloat(10, 10, 30, x)).toString();
+            }
+            jobs[c].push_back(job);
+            expected[c].push_back(results);
+        }
+        // a few small and invalid jobs in between, answered like the batch mode answers them
+        for (const std::string job : {"conv 10 5 5 255 16", "eval 10 10 10 x+ 1"}) {
+            jobs[c].push_back(job);
+            expected[c].push_back(reference.process(job));
+        }
+    }
+    std::vector<std::thread> threads;
+    for (size_t c = 0; c < clients; c++) {
+        threads.emplace_back([&, c] {
+            const int fd = connect_to(path);
+            // the jobs are sent without waiting for responses, which may come back in any order;
+            // sending from another thread keeps the server from blocking on a full socket while it throttles
+            std::thread sender([&] {
+                for (size_t j = 0; j < jobs[c].size(); j++) Server::writeFrame(fd, (uint32_t) j, jobs[c][j]);
+            });
+            got[c].resize(jobs[c].size());
+            for (size_t n = 0; n < jobs[c].size(); n++) {
+                uint32_t id;
+                std::string payload;
+                if (!Server::readFrame(fd, id, payload) || id >= got[c].size()) break;
+                got[c][id] = std::move(payload);
+            }
+            sender.join();
+            close(fd);
+        });
+    }
+    for (std::thread &t : threads) t.join();
+    server.stop();
+    serving.join();
+    size_t mismatches = 0;
+    for (size_t c = 0; c < clients; c++) {
+        for (size_t j = 0; j < jobs[c].size(); j++) mismatches += got[c][j] != expected[c][j];
+    }
+    CHECK_EQ(mismatches, (size_t) 0);
+    CHECK_EQ(server.stats().connections, (uint64_t) clients);
+    CHECK_EQ(server.stats().requests, (uint64_t) (clients * (jobs_per_client + 2)));
+}
+
+TEST(clients_that_do_not_read_block_only_themselves) {
+    ThreadPool pool(2);
+    const std::string path = socket_path("fixedfloat_server_slow");
+    Server server(path, pool);
+    std::promise<void> returned;
+    std::thread serving([&] {
+        server.run();
+        returned.set_value();
+    });
+    // every response is about 100 KB, so the socket buffers fill up after a few of them
+    const int slow = connect_to(path);
+    std::string job = "eval 10 10 2000 x/3";
+    for (int i = 0; i < 50; i++) job += " 1";
+    std::thread sender([&] {
+        for (uint32_t id = 0; id < 1000; id++) {
+            if (!Server::writeFrame(slow, id, job)) break;
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    // another client is still answered while the first one never reads
+    const int fast = connect_to(path);
+    const timeval timeout{10, 0};
+    setsockopt(fast, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    CHECK(Server::writeFrame(fast, 1, "eval 10 5 5 x+1 2"));
+    uint32_t id = 0;
+    std::string payload;
+    bool answered = false;
+    try {
+        answered = Server::readFrame(fast, id, payload);
+    } catch (std::exception&) {
+    }
+    CHECK(answered);
+    CHECK_EQ(payload, std::string("3.0"));
+    // stop returns although a response is stuck in the socket of the first client
+    server.stop();
+    if (returned.get_future().wait_for(std::chrono::seconds(10)) != std::future_status::ready) {
+        std::fprintf(stderr, "run did not return after stop\n");
+        std::_Exit(1);
+    }
+    serving.join();
+    sender.join();
+    close(fast);
+    close(slow);
+}
+
+static size_t thread_count() {
+    size_t n = 0;
+    for (const auto &entry : std::filesystem::directory_iterator("/proc/self/task")) n += entry.exists();
+    return n;
+}
+
+TEST(connections_beyond_the_limit_wait) {
+    ThreadPool pool(2);
+    const size_t threads_before = thread_count();
+    const std::string path = socket_path("fixedfloat_server_limit");
+    Server server(path, pool, 0, 2);
+    std::thread serving([&] { server.run(); });
+    const auto ask = [] (int fd, uint32_t id, const std::string& job, std::string& payload) {
+        uint32_t got = 0;
+        try {
+            return Server::writeFrame(fd, id, job) && Server::readFrame(fd, got, payload) && got == id;
+        } catch (std::exception&) {
+            return false;
+        }
+    };
+    const timeval timeout{10, 0}, short_timeout{0, 300000};
+    int fds[3];
+    std::string payload;
+    for (int i = 0; i < 2; i++) {
+        fds[i] = connect_to(path);
+        setsockopt(fds[i], SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        CHECK(ask(fds[i], i, "eval 10 5 5 x+1 2", payload));
+        CHECK_EQ(payload, std::string("3.0"));
+    }
+    // the third connection is only accepted once one of the first two ends
+    fds[2] = connect_to(path);
+    setsockopt(fds[2], SOL_SOCKET, SO_RCVTIMEO, &short_timeout, sizeof(short_timeout));
+    CHECK(!ask(fds[2], 2, "eval 10 5 5 x+2 2", payload));
+    CHECK_EQ(server.stats().connections, (uint64_t) 2);
+    CHECK(server.stats().queued > 0);
+    close(fds[0]);
+    setsockopt(fds[2], SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    uint32_t id = 0;
+    bool answered = false;
+    try {
+        answered = Server::readFrame(fds[2], id, payload);
+    } catch (std::exception&) {
+    }
+    CHECK(answered);
+    CHECK_EQ(id, (uint32_t) 2);
+    CHECK_EQ(payload, std::string("4.0"));
+    CHECK_EQ(server.stats().connections, (uint64_t) 3);
+    // stop joins the threads of every connection instead of leaving them behind, only run may still be returning
+    server.stop();
+    CHECK(thread_count() <= threads_before + 1);
+    serving.join();
+    CHECK_EQ(thread_count(), threads_before);
+    close(fds[1]);
+    close(fds[2]);
+}
+
+TEST(stop_without_clients) {
+    const std::string path = socket_path("fixedfloat_server_stop");
+    Server server(path);
+    std::thread serving([&] { server.run(); });
+    server.stop();
+    serving.join();
+    CHECK_EQ(server.stats().connections, (uint64_t) 0);
+}
+
+int main() {
+    return Check::run();
+}
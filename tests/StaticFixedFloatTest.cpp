@@ -0,0 +1,75 @@
+#include <cstdint>
+#include <random>
+#include <string>
+#include "FixedFloat.hpp"
+#include "StaticFixedFloat.hpp"
+#include "LimbAllocator.hpp"
+#include "Check.hpp"
+
+typedef StaticFixedFloat<10, 5, 5> Small;
+static_assert(Small("1.5") * Small("2.25") == Small("3.375"), "multiplication runs at compile time");
+static_assert(Small("99999.5") + Small("0.5") == Small("0"), "the integer part wraps like FixedFloat");
+static_assert(Small::fromInt(-3) < Small("0.00001"), "comparison runs at compile time");
+
+template <uint16_t Base, uint64_t IntDigits, uint64_t DecDigits>
+static void check_against_dynamic(uint32_t seed) {
+    typedef StaticFixedFloat<Base, IntDigits, DecDigits> S;
+    std::mt19937 rng(seed);
+    const char *digits = "0123456789abcdefghijklmnopqrstuvwxyz";
+    const auto random = [&] {
+        std::string s = rng() % 2 ? "-" : "";
+        for (uint64_t i = 0; i < IntDigits / 2 + 1; i++) s += digits[rng() % Base];
+        s += '.';
+        for (uint64_t i = 0; i < DecDigits; i++) s += digits[rng() % Base];
+        return FixedFloat(Base, IntDigits, DecDigits, s);
+    };
+    for (int round = 0; round < 100; round++) {
+        const FixedFloat a = random(), b = random(), c = random();
+        const S sa(a), sb(b), sc(c);
+        CHECK((sa + sb).toFixedFloat() == a + b);
+        CHECK((sa - sb).toFixedFloat() == a - b);
+        CHECK((sa * sb).toFixedFloat() == a * b);
+        S t = sc;
+        t.fma(sa, sb);
+        FixedFloat u = c;
+        u.fma(a, b);
+        CHECK(t.toFixedFloat() == u);
+        CHECK_EQ(sa < sb, a < b);
+    }
+}
+
+TEST(results_match_fixed_float) {
+    check_against_dynamic<10, 10, 20>(1);
+    check_against_dynamic<16, 8, 8>(2);
+    check_against_dynamic<2, 20, 30>(3);
+    check_against_dynamic<36, 4, 7>(4);
+    // past INLINE_MUL_LIMBS, where products go through Multiplier
+    static_assert(StaticFixedFloat<10, 20, 400>::LEN >= StaticFixedFloat<10, 20, 400>::INLINE_MUL_LIMBS);
+    check_against_dynamic<10, 20, 400>(5);
+    // digit lengths are 64-bit like FixedFloat's, so a format may pass 65535 digits
+    static_assert(StaticFixedFloat<2, 16, 70000>::getDecDigitLen() == 70000);
+    static_assert(StaticFixedFloat<2, 16, 70000>::LEN == 2189);
+    check_against_dynamic<2, 16, 70000>(6);
+}
+
+TEST(short_formats_do_not_allocate) {
+    typedef StaticFixedFloat<10, 10, 50> S;
+    static_assert(S::LEN < S::INLINE_MUL_LIMBS);
+    S acc("0.5");
+    const S x("1.0000001"), c("0.25");
+    const LimbAllocator::Stats before = LimbAllocator::threadStats();
+    for (int i = 0; i < 1000; i++) {
+        acc *= x;
+        acc += c;
+        acc -= c;
+        acc.fma(x, c);
+    }
+    const LimbAllocator::Stats after = LimbAllocator::threadStats();
+    CHECK_EQ(after.heap_allocs - before.heap_allocs, (uint64_t) 0);
+    CHECK_EQ(after.pool_hits - before.pool_hits, (uint64_t) 0);
+    CHECK(!acc.isZero());
+}
+
+int main() {
+    return Check::run();
+}
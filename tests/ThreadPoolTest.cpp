@@ -0,0 +1,85 @@
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "ThreadPool.hpp"
+#include "Check.hpp"
+
+// a parallelFor whose bodies record which thread numbers are in use, and fail when two of them share one
+struct SlotCheck {
+    std::unique_ptr<std::atomic<int>[]> busy;
+    std::atomic<int> clashes{0};
+    std::vector<std::atomic<int>> hits;
+    SlotCheck(size_t slots, size_t n): busy(new std::atomic<int>[slots]()), hits(n) {}
+    void run(ThreadPool& pool, size_t n, const std::function<void()>& inside = nullptr) {
+        pool.parallelFor(n, 1, [&] (size_t begin, size_t end, size_t thread) {
+            if (busy[thread]++ != 0) clashes++;
+            for (size_t i = begin; i < end; i++) hits[i]++;
+            if (inside) inside();
+            else std::this_thread::yield();
+            busy[thread]--;
+        });
+    }
+};
+
+TEST(every_index_runs_once) {
+    ThreadPool pool(4);
+    for (size_t n : {1, 2, 7, 100, 1000}) {
+        std::vector<std::atomic<int>> hits(n);
+        pool.parallelFor(n, 3, [&] (size_t begin, size_t end, size_t thread) {
+            CHECK(thread <= pool.size());
+            for (size_t i = begin; i < end; i++) hits[i]++;
+        });
+        for (size_t i = 0; i < n; i++) CHECK_EQ(hits[i].load(), 1);
+    }
+}
+
+TEST(concurrent_callers_never_share_a_thread_number) {
+    ThreadPool pool(3);
+    const size_t callers = 6, n = 400;
+    std::vector<std::unique_ptr<SlotCheck>> checks;
+    for (size_t c = 0; c < callers; c++) checks.emplace_back(new SlotCheck(pool.size() + 1, n));
+    std::vector<std::thread> threads;
+    for (size_t c = 0; c < callers; c++) {
+        threads.emplace_back([&, c] {
+            for (int round = 0; round < 20; round++) checks[c]->run(pool, n);
+        });
+    }
+    for (std::thread &t : threads) t.join();
+    for (const auto &check : checks) {
+        CHECK_EQ(check->clashes.load(), 0);
+        for (size_t i = 0; i < n; i++) CHECK_EQ(check->hits[i].load(), 20);
+    }
+}
+
+TEST(nested_callers_never_share_a_thread_number) {
+    // every chunk of the outer loop runs a whole inner loop, like evalBatch called from pool tasks
+    ThreadPool pool(4);
+    SlotCheck outer(pool.size() + 1, 64);
+    std::atomic<int> inner_clashes{0};
+    outer.run(pool, 64, [&] {
+        SlotCheck inner(pool.size() + 1, 50);
+        inner.run(pool, 50);
+        inner_clashes += inner.clashes;
+    });
+    CHECK_EQ(outer.clashes.load(), 0);
+    CHECK_EQ(inner_clashes.load(), 0);
+}
+
+TEST(exceptions_reach_the_caller) {
+    ThreadPool pool(2);
+    CHECK_THROWS(pool.parallelFor(100, 1, [] (size_t begin, size_t end, size_t) {
+        if (begin <= 50 && 50 < end) throw std::runtime_error("boom");
+    }));
+    // the pool is still usable afterwards
+    std::atomic<size_t> sum{0};
+    pool.parallelFor(100, 1, [&] (size_t begin, size_t end, size_t) { sum += end - begin; });
+    CHECK_EQ(sum.load(), (size_t) 100);
+}
+
+int main() {
+    return Check::run();
+}